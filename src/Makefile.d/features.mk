@@ -4,13 +4,12 @@
 
 passthru_opts+=\
 	NO_IPV6 NOHW NOMD5 NOPOSTPROCESSING\
-	MOBJCONSISTANCY PACKETDROP ZDEBUG\
+	PACKETDROP ZDEBUG\
 	HAVE_MINIUPNPC\
 	HAVE_DISCORDRPC TESTERS DEVELOP
 
 # build with debugging information
 ifdef DEBUGMODE
-MOBJCONSISTANCY=1
 PACKETDROP=1
 opts+=-DPARANOIA -DRANGECHECK
 endif
@@ -43,6 +43,7 @@
 #include "../k_battle.h"
 #include "../k_grandprix.h"
 #include "../k_podium.h"
+#include "../k_waypoint.h"
 #include "../k_bot.h"
 #include "../z_zone.h"
 #include "../music.h"
@@ -3772,7 +3773,16 @@ bool CallFunc_SetThingProperty(ACSVM::Thread *thread, const ACSVM::Word *argV, A
 			PROP_SCALE(THING_PROP_SCALE, scale)
 			PROP_INT(THING_PROP_DESTSCALE, destscale)
 			PROP_INT(THING_PROP_SCALESPEED, scalespeed)
-			PROP_INT(THING_PROP_EXTRAVALUE1, extravalue1)
+			case THING_PROP_EXTRAVALUE1:
+			{
+				mobj->extravalue1 = value;
+				if (mobj->type == MT_WAYPOINT)
+				{
+					// extravalue1 is whether the waypoint is enabled
+					K_UpdateWaypointEnabled(mobj);
+				}
+				break;
+			}
 			PROP_INT(THING_PROP_EXTRAVALUE2, extravalue2)
 			PROP_INT(THING_PROP_CUSVAL, cusval)
 			PROP_INT(THING_PROP_CVMEM, cvmem)
@@ -10,6 +10,8 @@
 
 #include "chunk_load.hpp"
 
+#include <algorithm>
+
 #include <stb_vorbis.h>
 
 #include "../cxxutil.hpp"
@@ -46,12 +48,9 @@ public:
 		if (!chunk_)
 			return 0;
 
-		size_t written = 0;
-		for (; pos_ < chunk_->samples.size() && written < buffer.size(); pos_++)
-		{
-			buffer[written] = chunk_->samples[pos_];
-			written++;
-		}
+		size_t written = std::min(buffer.size(), chunk_->samples.size() - pos_);
+		std::copy_n(chunk_->samples.begin() + pos_, written, buffer.begin());
+		pos_ += written;
 		return written;
 	}
 
@@ -115,18 +114,9 @@ optional<SoundChunk> try_load_dmx(tcb::span<std::byte> data)
 		std::make_unique<SoundChunkSource>(std::make_unique<SoundChunk>(SoundChunk {std::move(samples)}));
 	Resampler<1> resampler(std::move(chunk_source), rate / static_cast<float>(kSampleRate));
 
-	std::vector<Sample<1>> resampled;
-
-	size_t total = 0;
-	size_t read = 0;
-	resampled.reserve(samples_len * (static_cast<float>(kSampleRate) / rate));
-	do
-	{
-		resampled.resize(total + 4096);
-		read = resampler.generate(tcb::span {resampled.data() + total, 4096});
-		total += read;
-	} while (read != 0);
-	resampled.resize(total);
+	std::vector<Sample<1>> resampled {
+		generate_to_vec(resampler, samples_len * (static_cast<float>(kSampleRate) / rate) + 1)
+	};
 
 	return SoundChunk {std::move(resampled)};
 }
@@ -10,6 +10,10 @@
 
 #include "filter.hpp"
 
+#include <algorithm>
+
+#include "kernels.hpp"
+
 using std::shared_ptr;
 using std::size_t;
 
@@ -17,15 +21,31 @@ using srb2::audio::Filter;
 using srb2::audio::Sample;
 using srb2::audio::Source;
 
+template <size_t IC, size_t OC>
+Filter<IC, OC>::Filter() : input_buffer_(kBlockSize)
+{
+}
+
 template <size_t IC, size_t OC>
 size_t Filter<IC, OC>::generate(tcb::span<Sample<OC>> buffer)
 {
-	input_buffer_.clear();
-	input_buffer_.resize(buffer.size());
+	size_t written = 0;
+
+	while (written < buffer.size())
+	{
+		tcb::span<Sample<IC>> input {input_buffer_.data(), std::min(buffer.size() - written, kBlockSize)};
+
+		zero_samples(input);
+		input_->generate(input);
+
+		size_t filtered = filter(input, buffer.subspan(written, input.size()));
+		written += filtered;
 
-	input_->generate(input_buffer_);
+		if (filtered < input.size())
+			break;
+	}
 
-	return filter(input_buffer_, buffer);
+	return written;
 }
 
 template <size_t IC, size_t OC>
@@ -26,6 +26,8 @@ template <size_t IC, size_t OC>
 class Filter : public Source<OC>
 {
 public:
+	Filter();
+
 	virtual std::size_t generate(tcb::span<Sample<OC>> buffer) override;
 
 	void bind(const std::shared_ptr<Source<IC>>& input);
@@ -11,6 +11,9 @@
 #include "gain.hpp"
 
 #include <algorithm>
+#include <cmath>
+
+#include "kernels.hpp"
 
 using std::size_t;
 
@@ -19,18 +22,28 @@ using srb2::audio::Gain;
 using srb2::audio::Sample;
 
 constexpr const float kGainInterpolationAlpha = 0.8f;
+constexpr const float kGainSettledEpsilon = 1e-6f;
 
 template <size_t C>
 size_t Gain<C>::filter(tcb::span<Sample<C>> input_buffer, tcb::span<Sample<C>> buffer)
 {
 	size_t written = std::min(buffer.size(), input_buffer.size());
-	for (size_t i = 0; i < written; i++)
+	size_t i = 0;
+
+	// Only a gain change needs per-sample work; it settles within a few
+	// dozen samples and the rest is a plain multiply.
+	for (; i < written && gain_ != new_gain_; i++)
 	{
 		buffer[i] = input_buffer[i];
 		buffer[i] *= gain_;
 		gain_ += (new_gain_ - gain_) * kGainInterpolationAlpha;
+
+		if (std::abs(new_gain_ - gain_) < kGainSettledEpsilon)
+			gain_ = new_gain_;
 	}
 
+	scale_samples<C>(buffer.subspan(i, written - i), input_buffer.subspan(i, written - i), gain_);
+
 	return written;
 }
 
@@ -0,0 +1,265 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#include "kernels.hpp"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIO_SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define AUDIO_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+using std::size_t;
+
+using namespace srb2::audio;
+
+namespace
+{
+
+// Sample<C> is C packed floats, so the kernels below run over the
+// amplitudes as one flat array.
+template <size_t C>
+float* floats(tcb::span<Sample<C>> s)
+{
+	return reinterpret_cast<float*>(s.data());
+}
+
+template <size_t C>
+const float* floats(tcb::span<const Sample<C>> s)
+{
+	return reinterpret_cast<const float*>(s.data());
+}
+
+void add_floats(float* dst, const float* src, size_t n)
+{
+	size_t i = 0;
+#if defined(AUDIO_SIMD_SSE2)
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+	}
+#elif defined(AUDIO_SIMD_NEON)
+	for (; i + 4 <= n; i += 4)
+	{
+		vst1q_f32(dst + i, vaddq_f32(vld1q_f32(dst + i), vld1q_f32(src + i)));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		dst[i] += src[i];
+	}
+}
+
+void scale_floats(float* dst, const float* src, float gain, size_t n)
+{
+	size_t i = 0;
+#if defined(AUDIO_SIMD_SSE2)
+	__m128 g = _mm_set1_ps(gain);
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm_storeu_ps(dst + i, _mm_mul_ps(_mm_loadu_ps(src + i), g));
+	}
+#elif defined(AUDIO_SIMD_NEON)
+	for (; i + 4 <= n; i += 4)
+	{
+		vst1q_f32(dst + i, vmulq_n_f32(vld1q_f32(src + i), gain));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		dst[i] = src[i] * gain;
+	}
+}
+
+void clamp_floats(float* dst, size_t n)
+{
+	size_t i = 0;
+#if defined(AUDIO_SIMD_SSE2)
+	__m128 lo = _mm_set1_ps(-1.f);
+	__m128 hi = _mm_set1_ps(1.f);
+	for (; i + 4 <= n; i += 4)
+	{
+		_mm_storeu_ps(dst + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(dst + i), lo), hi));
+	}
+#elif defined(AUDIO_SIMD_NEON)
+	float32x4_t lo = vdupq_n_f32(-1.f);
+	float32x4_t hi = vdupq_n_f32(1.f);
+	for (; i + 4 <= n; i += 4)
+	{
+		vst1q_f32(dst + i, vminq_f32(vmaxq_f32(vld1q_f32(dst + i), lo), hi));
+	}
+#endif
+	for (; i < n; i++)
+	{
+		dst[i] = std::clamp(dst[i], -1.f, 1.f);
+	}
+}
+
+} // namespace
+
+template <size_t C>
+void srb2::audio::zero_samples(tcb::span<Sample<C>> dst)
+{
+	std::fill_n(floats(dst), dst.size() * C, 0.f);
+}
+
+template <size_t C>
+void srb2::audio::add_samples(tcb::span<Sample<C>> dst, tcb::span<const Sample<C>> src)
+{
+	add_floats(floats(dst), floats(src), std::min(dst.size(), src.size()) * C);
+}
+
+template <size_t C>
+void srb2::audio::scale_samples(tcb::span<Sample<C>> dst, tcb::span<const Sample<C>> src, float gain)
+{
+	scale_floats(floats(dst), floats(src), gain, std::min(dst.size(), src.size()) * C);
+}
+
+template <size_t C>
+void srb2::audio::clamp_samples(tcb::span<Sample<C>> dst)
+{
+	clamp_floats(floats(dst), dst.size() * C);
+}
+
+void srb2::audio::pan_samples(tcb::span<Sample<2>> dst, tcb::span<const Sample<1>> src, float left, float right)
+{
+	float* out = floats(dst);
+	const float* in = floats(src);
+	size_t n = std::min(dst.size(), src.size());
+	size_t i = 0;
+
+#if defined(AUDIO_SIMD_SSE2)
+	__m128 scale = _mm_setr_ps(left, right, left, right);
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 mono = _mm_loadu_ps(in + i);
+		_mm_storeu_ps(out + i * 2, _mm_mul_ps(_mm_unpacklo_ps(mono, mono), scale));
+		_mm_storeu_ps(out + i * 2 + 4, _mm_mul_ps(_mm_unpackhi_ps(mono, mono), scale));
+	}
+#elif defined(AUDIO_SIMD_NEON)
+	for (; i + 4 <= n; i += 4)
+	{
+		float32x4_t mono = vld1q_f32(in + i);
+		float32x4x2_t stereo = {{vmulq_n_f32(mono, left), vmulq_n_f32(mono, right)}};
+		vst2q_f32(out + i * 2, stereo);
+	}
+#endif
+	for (; i < n; i++)
+	{
+		out[i * 2] = in[i] * left;
+		out[i * 2 + 1] = in[i] * right;
+	}
+}
+
+template <size_t C>
+size_t srb2::audio::resample_polyphase(
+	tcb::span<Sample<C>> dst,
+	tcb::span<const Sample<C>> src,
+	tcb::span<const float> table,
+	size_t taps,
+	double& pos,
+	double step
+)
+{
+	static_assert(4 % C == 0, "Rows must split evenly into vector lanes");
+
+	const size_t row_len = taps * C;
+	const size_t phases = table.size() / row_len - 1;
+
+	if (src.size() < taps)
+		return 0;
+
+	// The last tap must land inside src
+	const double limit = static_cast<double>(src.size() - taps + 1);
+	const float* in = floats(src);
+	size_t written = 0;
+
+	for (; written < dst.size() && pos < limit; written++)
+	{
+		size_t i = static_cast<size_t>(pos);
+		double phase = (pos - i) * phases;
+		size_t p = static_cast<size_t>(phase);
+		float t = static_cast<float>(phase - p);
+
+		const float* row0 = table.data() + p * row_len;
+		const float* row1 = row0 + row_len;
+		const float* frames = in + i * C;
+		size_t k = 0;
+
+		// Every vector lane k holds channel k % C
+		float sum[4] = {0.f, 0.f, 0.f, 0.f};
+#if defined(AUDIO_SIMD_SSE2)
+		__m128 acc = _mm_setzero_ps();
+		__m128 tv = _mm_set1_ps(t);
+		for (; k + 4 <= row_len; k += 4)
+		{
+			__m128 c0 = _mm_loadu_ps(row0 + k);
+			__m128 c = _mm_add_ps(c0, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(row1 + k), c0), tv));
+			acc = _mm_add_ps(acc, _mm_mul_ps(c, _mm_loadu_ps(frames + k)));
+		}
+		_mm_storeu_ps(sum, acc);
+#elif defined(AUDIO_SIMD_NEON)
+		float32x4_t acc = vdupq_n_f32(0.f);
+		for (; k + 4 <= row_len; k += 4)
+		{
+			float32x4_t c0 = vld1q_f32(row0 + k);
+			float32x4_t c = vmlaq_n_f32(c0, vsubq_f32(vld1q_f32(row1 + k), c0), t);
+			acc = vmlaq_f32(acc, c, vld1q_f32(frames + k));
+		}
+		vst1q_f32(sum, acc);
+#endif
+		for (; k < row_len; k++)
+		{
+			sum[k % 4] += (row0[k] + (row1[k] - row0[k]) * t) * frames[k];
+		}
+
+		for (size_t c = 0; c < C; c++)
+		{
+			float amplitude = 0.f;
+			for (size_t lane = c; lane < 4; lane += C)
+			{
+				amplitude += sum[lane];
+			}
+			dst[written].amplitudes[c] = amplitude;
+		}
+
+		pos += step;
+	}
+
+	return written;
+}
+
+template void srb2::audio::zero_samples<1>(tcb::span<Sample<1>>);
+template void srb2::audio::zero_samples<2>(tcb::span<Sample<2>>);
+template void srb2::audio::add_samples<1>(tcb::span<Sample<1>>, tcb::span<const Sample<1>>);
+template void srb2::audio::add_samples<2>(tcb::span<Sample<2>>, tcb::span<const Sample<2>>);
+template void srb2::audio::scale_samples<1>(tcb::span<Sample<1>>, tcb::span<const Sample<1>>, float);
+template void srb2::audio::scale_samples<2>(tcb::span<Sample<2>>, tcb::span<const Sample<2>>, float);
+template void srb2::audio::clamp_samples<1>(tcb::span<Sample<1>>);
+template void srb2::audio::clamp_samples<2>(tcb::span<Sample<2>>);
+template size_t srb2::audio::resample_polyphase<1>(
+	tcb::span<Sample<1>>,
+	tcb::span<const Sample<1>>,
+	tcb::span<const float>,
+	size_t,
+	double&,
+	double
+);
+template size_t srb2::audio::resample_polyphase<2>(
+	tcb::span<Sample<2>>,
+	tcb::span<const Sample<2>>,
+	tcb::span<const float>,
+	size_t,
+	double&,
+	double
+);
@@ -0,0 +1,93 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_AUDIO_KERNELS_HPP__
+#define __SRB2_AUDIO_KERNELS_HPP__
+
+#include <cstddef>
+
+#include <tcb/span.hpp>
+
+#include "source.hpp"
+
+namespace srb2::audio
+{
+
+// Inner loops of the mixing graph. They run on the audio thread, so
+// none of them allocate. Where SSE2 or NEON is available they work on
+// four floats at a time; the output is the same as the scalar loops.
+
+static_assert(sizeof(Sample<1>) == sizeof(float));
+static_assert(sizeof(Sample<2>) == 2 * sizeof(float));
+
+template <size_t C>
+void zero_samples(tcb::span<Sample<C>> dst);
+
+// dst[i] += src[i]
+template <size_t C>
+void add_samples(tcb::span<Sample<C>> dst, tcb::span<const Sample<C>> src);
+
+// dst[i] = src[i] * gain
+template <size_t C>
+void scale_samples(tcb::span<Sample<C>> dst, tcb::span<const Sample<C>> src, float gain);
+
+// Clamps every amplitude to [-1, 1]
+template <size_t C>
+void clamp_samples(tcb::span<Sample<C>> dst);
+
+// dst[i] = {src[i] * left, src[i] * right}
+void pan_samples(tcb::span<Sample<2>> dst, tcb::span<const Sample<1>> src, float left, float right);
+
+// Polyphase FIR resampling from src, starting at frame position pos and
+// stepping by step for every output frame. Output frame j is the dot
+// product of src frames floor(pos) .. floor(pos) + taps - 1 with a row
+// of table, which holds phases + 1 rows of taps * C coefficients (each
+// coefficient repeated for every channel). Row p is the filter for a
+// fractional position of p / phases; positions in between interpolate
+// two rows. Stops when dst is full or the next frame would read past
+// the end of src. Returns the number of frames written and leaves pos
+// at the next position.
+template <size_t C>
+size_t resample_polyphase(
+	tcb::span<Sample<C>> dst,
+	tcb::span<const Sample<C>> src,
+	tcb::span<const float> table,
+	size_t taps,
+	double& pos,
+	double step
+);
+
+extern template void zero_samples<1>(tcb::span<Sample<1>>);
+extern template void zero_samples<2>(tcb::span<Sample<2>>);
+extern template void add_samples<1>(tcb::span<Sample<1>>, tcb::span<const Sample<1>>);
+extern template void add_samples<2>(tcb::span<Sample<2>>, tcb::span<const Sample<2>>);
+extern template void scale_samples<1>(tcb::span<Sample<1>>, tcb::span<const Sample<1>>, float);
+extern template void scale_samples<2>(tcb::span<Sample<2>>, tcb::span<const Sample<2>>, float);
+extern template void clamp_samples<1>(tcb::span<Sample<1>>);
+extern template void clamp_samples<2>(tcb::span<Sample<2>>);
+extern template size_t resample_polyphase<1>(
+	tcb::span<Sample<1>>,
+	tcb::span<const Sample<1>>,
+	tcb::span<const float>,
+	size_t,
+	double&,
+	double
+);
+extern template size_t resample_polyphase<2>(
+	tcb::span<Sample<2>>,
+	tcb::span<const Sample<2>>,
+	tcb::span<const float>,
+	size_t,
+	double&,
+	double
+);
+
+} // namespace srb2::audio
+
+#endif // __SRB2_AUDIO_KERNELS_HPP__
@@ -12,6 +12,8 @@
 
 #include <algorithm>
 
+#include "kernels.hpp"
+
 using std::shared_ptr;
 using std::size_t;
 
@@ -19,38 +21,30 @@ using srb2::audio::Mixer;
 using srb2::audio::Sample;
 using srb2::audio::Source;
 
-namespace
-{
-
-template <size_t C>
-void default_init_sample_buffer(Sample<C>* buffer, size_t size)
-{
-	std::for_each(buffer, buffer + size, [](auto& i) { i = Sample<C> {}; });
-}
-
 template <size_t C>
-void mix_sample_buffers(Sample<C>* dst, size_t size, Sample<C>* src, size_t src_size)
+Mixer<C>::Mixer() : buffer_(kBlockSize)
 {
-	for (size_t i = 0; i < size && i < src_size; i++)
-	{
-		dst[i] += src[i];
-	}
 }
 
-} // namespace
-
 template <size_t C>
 size_t Mixer<C>::generate(tcb::span<Sample<C>> buffer)
 {
-	buffer_.resize(buffer.size());
-
-	default_init_sample_buffer<C>(buffer.data(), buffer.size());
+	zero_samples(buffer);
 
 	for (auto& source : sources_)
 	{
-		size_t read = source->generate(buffer_);
-
-		mix_sample_buffers<C>(buffer.data(), buffer.size(), buffer_.data(), read);
+		for (size_t done = 0; done < buffer.size();)
+		{
+			tcb::span<Sample<C>> block = buffer.subspan(done, std::min(buffer.size() - done, kBlockSize));
+			size_t read = source->generate(tcb::span {buffer_.data(), block.size()});
+
+			add_samples<C>(block, tcb::span<const Sample<C>> {buffer_.data(), std::min(read, block.size())});
+
+			// A source that runs dry mid-block has nothing more this call
+			if (read < block.size())
+				break;
+			done += block.size();
+		}
 	}
 
 	// because we initialized the out-buffer, we always generate size samples
@@ -25,6 +25,8 @@ template <size_t C>
 class Mixer : public Source<C>
 {
 public:
+	Mixer();
+
 	virtual std::size_t generate(tcb::span<Sample<C>> buffer) override final;
 
 	virtual ~Mixer();
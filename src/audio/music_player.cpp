@@ -11,19 +11,25 @@
 #include "music_player.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <condition_variable>
 #include <exception>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <variant>
 #include <vector>
 
 #include <stb_vorbis.h>
 
+#include "../core/spsc_ring.hpp"
 #include "../cxxutil.hpp"
 #include "../io/streams.hpp"
+#include "kernels.hpp"
 #include "ogg_player.hpp"
 #include "resample.hpp"
 #include "xmp_player.hpp"
@@ -38,17 +44,71 @@ using srb2::audio::MusicPlayer;
 using srb2::audio::Resampler;
 using srb2::audio::Sample;
 using srb2::audio::Source;
+using srb2::audio::kBlockSize;
+using srb2::audio::zero_samples;
+using srb2::SpScRing;
 using namespace srb2;
 
+namespace
+{
+
+// Music is decoded ahead of playback on its own thread, so the audio
+// callback only copies finished blocks. Every block carries the stream
+// generation it was decoded for; anything that moves the decoder (seek,
+// stop, playing from the top) starts a new generation, and the audio
+// thread drops blocks from older ones.
+constexpr const size_t kDecodeAheadBlocks = 32; // ~0.37 s
+
+struct DecodedBlock
+{
+	std::array<Sample<2>, kBlockSize> frames;
+	size_t count;
+	uint32_t generation;
+	float position_start; // decoder position, in seconds, around the block
+	float position_end;
+	bool end; // the source ran dry after this block
+};
+
+} // namespace
+
 class MusicPlayer::Impl
 {
 public:
 	Impl() = default;
-	Impl(tcb::span<std::byte> data) : Impl() { _load(data); }
+	Impl(tcb::span<std::byte> data) : Impl()
+	{
+		_load(data);
+
+		if (resampler_)
+		{
+			ring_ = std::make_unique<SpScRing<DecodedBlock>>(kDecodeAheadBlocks);
+			decode_thread_ = std::thread([this] { decode_loop(); });
+		}
+	}
+
+	Impl(const Impl&) = delete;
+	Impl& operator=(const Impl&) = delete;
+
+	~Impl()
+	{
+		if (decode_thread_.joinable())
+		{
+			{
+				std::lock_guard<std::mutex> lock(decode_mutex_);
+				stop_decoding_ = true;
+			}
+			decode_wake_.notify_one();
+			decode_thread_.join();
+		}
+	}
+
+	// The members below are only called with the SDL audio lock held, like
+	// generate, so only state shared with the decode thread needs
+	// decode_mutex_.
 
 	size_t generate(tcb::span<Sample<2>> buffer)
 	{
-		if (!resampler_)
+		if (!ring_)
 			return 0;
 
 		if (!playing_)
@@ -58,7 +118,40 @@ public:
 
 		while (total_written < buffer.size())
 		{
-			const size_t generated = resampler_->generate(buffer.subspan(total_written));
+			if (pending_.generation != generation_)
+			{
+				pending_.count = 0;
+				pending_.end = false;
+			}
+
+			if (pending_offset_ >= pending_.count)
+			{
+				if (pending_.end)
+				{
+					pending_.end = false;
+					playing_ = false;
+					break;
+				}
+
+				if (!ring_->try_pop(pending_))
+				{
+					// The decoder fell behind; keep time with silence
+					zero_samples(buffer.subspan(total_written));
+					total_written = buffer.size();
+					break;
+				}
+
+				// Not under decode_mutex_, so this can land just before the decoder sleeps. The next pop wakes it
+				// again, and the ring holds plenty of blocks until then.
+				decode_wake_.notify_one();
+
+				pending_offset_ = 0;
+				continue;
+			}
+
+			const size_t generated = std::min(buffer.size() - total_written, pending_.count - pending_offset_);
+
+			std::copy_n(pending_.frames.begin() + pending_offset_, generated, buffer.begin() + total_written);
 
 			// To avoid a branch preventing optimizations, we're always going to apply
 			// the fade gain, even if it would clamp anyway.
@@ -76,12 +169,14 @@ public:
 				gain_ = gain_target_;
 			}
 
+			pending_offset_ += generated;
 			total_written += generated;
 
-			if (generated == 0)
+			consumed_ = true;
+			played_position_ = pending_.position_start;
+			if (pending_.position_end > pending_.position_start)
 			{
-				playing_ = false;
-				break;
+				played_position_ += (pending_.position_end - pending_.position_start) * pending_offset_ / pending_.count;
 			}
 		}
 
@@ -100,6 +195,8 @@ public:
 			audio::Ogg ogg = audio::load_ogg(stream);
 			ogg_inst_ = std::make_shared<audio::OggPlayer<2>>(std::move(ogg));
 			ogg_inst_->looping(looping_);
+			// Playing and pausing happen on this side of the decoder
+			ogg_inst_->playing(true);
 			resampler_ = Resampler<2>(ogg_inst_, ogg_inst_->sample_rate() / 44100.f);
 		}
 		catch (const std::exception& ex)
@@ -135,86 +232,68 @@ public:
 
 	void play(bool looping)
 	{
+		if (!ring_)
+			return;
+
+		std::lock_guard<std::mutex> lock(decode_mutex_);
+
 		if (ogg_inst_)
-		{
 			ogg_inst_->looping(looping);
-			ogg_inst_->playing(true);
-			playing_ = true;
-			ogg_inst_->reset();
-		}
 		else if (xmp_inst_)
-		{
 			xmp_inst_->looping(looping);
-			playing_ = true;
-			xmp_inst_->reset();
+
+		// A freshly loaded song is already decoding from the top
+		if (consumed_ || decode_ended_ || stream_start_ != 0.f)
+		{
+			reset_decoder();
+			restart_stream(0.f);
 		}
+
+		playing_ = true;
 	}
 
 	void unpause()
 	{
-		if (ogg_inst_)
-		{
-			ogg_inst_->playing(true);
+		if (ring_)
 			playing_ = true;
-		}
-		else if (xmp_inst_)
-		{
-			playing_ = true;
-		}
 	}
 
-	void pause()
-	{
-		if (ogg_inst_)
-		{
-			ogg_inst_->playing(false);
-			playing_ = false;
-		}
-		else if (xmp_inst_)
-		{
-			playing_ = false;
-		}
-	}
+	void pause() { playing_ = false; }
 
 	void stop()
 	{
-		if (ogg_inst_)
-		{
-			ogg_inst_->reset();
-			ogg_inst_->playing(false);
-			playing_ = false;
-		}
-		else if (xmp_inst_)
-		{
-			xmp_inst_->reset();
-			playing_ = false;
-		}
+		if (!ring_)
+			return;
+
+		std::lock_guard<std::mutex> lock(decode_mutex_);
+
+		reset_decoder();
+		restart_stream(0.f);
+		playing_ = false;
 	}
 
 	void seek(float position_seconds)
 	{
-		if (ogg_inst_)
-		{
-			ogg_inst_->seek(position_seconds);
+		if (!ring_)
 			return;
-		}
-		if (xmp_inst_)
-		{
-			xmp_inst_->seek(position_seconds);
+
+		std::lock_guard<std::mutex> lock(decode_mutex_);
+
+		// Seeking to where the queued blocks already start would only
+		// throw them away
+		if (!consumed_ && std::abs(position_seconds - stream_start_) < 0.001f)
 			return;
-		}
-	}
 
-	bool playing() const
-	{
 		if (ogg_inst_)
-			return ogg_inst_->playing();
+			ogg_inst_->seek(position_seconds);
 		else if (xmp_inst_)
-			return playing_;
+			xmp_inst_->seek(position_seconds);
 
-		return false;
+		restart_stream(position_seconds);
 	}
 
+	bool playing() const { return playing_; }
+
 	std::optional<audio::MusicType> music_type() const
 	{
 		if (ogg_inst_)
@@ -227,6 +306,8 @@ public:
 
 	std::optional<float> duration_seconds() const
 	{
+		std::lock_guard<std::mutex> lock(decode_mutex_);
+
 		if (ogg_inst_)
 			return ogg_inst_->duration_seconds();
 		if (xmp_inst_)
@@ -237,6 +318,8 @@ public:
 
 	std::optional<float> loop_point_seconds() const
 	{
+		std::lock_guard<std::mutex> lock(decode_mutex_);
+
 		if (ogg_inst_)
 			return ogg_inst_->loop_point_seconds();
 
@@ -245,10 +328,8 @@ public:
 
 	std::optional<float> position_seconds() const
 	{
-		if (ogg_inst_)
-			return ogg_inst_->position_seconds();
-		if (xmp_inst_)
-			return xmp_inst_->position_seconds();
+		if (ogg_inst_ || xmp_inst_)
+			return played_position_;
 
 		return std::nullopt;
 	}
@@ -272,6 +353,8 @@ public:
 
 	void loop_point_seconds(float loop_point)
 	{
+		std::lock_guard<std::mutex> lock(decode_mutex_);
+
 		if (ogg_inst_)
 			ogg_inst_->loop_point_seconds(loop_point);
 	}
@@ -286,11 +369,30 @@ public:
 	}
 
 private:
+	// Decoder, shared with the decode thread under decode_mutex_
 	std::shared_ptr<OggPlayer<2>> ogg_inst_;
 	std::shared_ptr<XmpPlayer<2>> xmp_inst_;
 	std::optional<Resampler<2>> resampler_;
-	bool playing_ {false};
 	bool looping_ {false};
+	bool decode_ended_ {false};
+	bool stop_decoding_ {false};
+
+	// Only changed with both the SDL audio lock and decode_mutex_ held
+	uint32_t generation_ {0};
+	float stream_start_ {0.f}; // where the current generation starts, in seconds
+
+	mutable std::mutex decode_mutex_;
+	std::condition_variable decode_wake_;
+	std::thread decode_thread_;
+	std::unique_ptr<SpScRing<DecodedBlock>> ring_;
+	DecodedBlock decoding_ {}; // decode thread only
+
+	// Audio thread side
+	DecodedBlock pending_ {};
+	size_t pending_offset_ {0};
+	bool consumed_ {false}; // anything of this generation was played
+	float played_position_ {0.f};
+	bool playing_ {false};
 
 	// fade control
 	float gain_target_ {1.f};
@@ -305,6 +407,60 @@ private:
 									  static_cast<double>(gain_samples_target_);
 		return (gain_target_ - gain_) * std::clamp(alpha, 0.f, 1.f) + gain_;
 	}
+
+	// Both of these need decode_mutex_
+	void reset_decoder()
+	{
+		if (ogg_inst_)
+			ogg_inst_->reset();
+		else if (xmp_inst_)
+			xmp_inst_->reset();
+	}
+
+	void restart_stream(float position_seconds)
+	{
+		generation_++;
+		stream_start_ = position_seconds;
+		decode_ended_ = false;
+		consumed_ = false;
+		played_position_ = position_seconds;
+		decode_wake_.notify_one();
+	}
+
+	float decoder_position() const
+	{
+		if (ogg_inst_)
+			return ogg_inst_->position_seconds();
+		if (xmp_inst_)
+			return xmp_inst_->position_seconds();
+
+		return 0.f;
+	}
+
+	void decode_loop()
+	{
+		std::unique_lock<std::mutex> lock(decode_mutex_);
+
+		while (!stop_decoding_)
+		{
+			if (decode_ended_ || ring_->full())
+			{
+				// Paused, stopped and finished players sleep here until the audio thread takes a block or the
+				// stream restarts
+				decode_wake_.wait(lock, [this] { return stop_decoding_ || (!decode_ended_ && !ring_->full()); });
+				continue;
+			}
+
+			decoding_.generation = generation_;
+			decoding_.position_start = decoder_position();
+			decoding_.count = resampler_->generate(decoding_.frames);
+			decoding_.position_end = decoder_position();
+			decoding_.end = decoding_.count < kBlockSize;
+			decode_ended_ = decoding_.end;
+
+			ring_->try_push(decoding_);
+		}
+	}
 };
 
 // The special member functions MUST be declared in this unit, where Impl is complete.
@@ -16,16 +16,73 @@
 #include <utility>
 #include <vector>
 
+#include "kernels.hpp"
+
 using std::shared_ptr;
 using std::size_t;
 using std::vector;
 
 using namespace srb2::audio;
 
+namespace
+{
+
+// Input frames under the filter for every output frame. The output
+// lands between the two middle taps, so that many frames of silence
+// go in front of the stream to keep it lined up with the input.
+constexpr const size_t kTaps = 32;
+constexpr const size_t kLeadFrames = kTaps / 2 - 1;
+
+// Filter rows per input frame. Positions between rows interpolate.
+constexpr const size_t kPhases = 128;
+
+constexpr const double kKaiserBeta = 7.0;
+
+constexpr const double kPi = 3.14159265358979323846;
+
+// Fraction of the lower of the two Nyquist rates that is passed. The
+// short window can't make a sharp cutoff, so it starts rolling off early.
+constexpr const float kCutoffScale = 0.9f;
+
+// Ratio changes smaller than this reuse the old filter
+constexpr const float kCutoffTolerance = 0.005f;
+
+float cutoff_for_ratio(float ratio)
+{
+	// Going down in rate, the filter has to cut at the output's Nyquist
+	return std::min(1.f, 1.f / std::max(ratio, 1.f)) * kCutoffScale;
+}
+
+double bessel_i0(double x)
+{
+	double sum = 1.0;
+	double term = 1.0;
+
+	for (int k = 1; term > sum * 1e-12; k++)
+	{
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+	}
+
+	return sum;
+}
+
+double sinc(double x)
+{
+	if (x == 0.0)
+		return 1.0;
+
+	return std::sin(kPi * x) / (kPi * x);
+}
+
+} // namespace
+
 template <size_t C>
 Resampler<C>::Resampler(std::shared_ptr<Source<C>>&& source, float ratio)
-	: source_(std::forward<std::shared_ptr<Source<C>>>(source)), ratio_(ratio)
+	: source_(std::forward<std::shared_ptr<Source<C>>>(source)), ratio_(ratio), table_((kPhases + 1) * kTaps * C),
+	  buf_(kTaps - 1 + kBlockSize), buf_len_(kLeadFrames)
 {
+	build_table(cutoff_for_ratio(ratio_));
 }
 
 template <size_t C>
@@ -50,39 +107,91 @@ size_t Resampler<C>::generate(tcb::span<Sample<C>> buffer)
 		return source_read;
 	}
 
+	float cutoff = cutoff_for_ratio(ratio_);
+	if (std::abs(cutoff - table_cutoff_) > kCutoffTolerance)
+	{
+		build_table(cutoff);
+	}
+
 	size_t written = 0;
 
 	while (written < buffer.size())
 	{
-		// do we need a refill?
-		if (buf_.size() == 0 || pos_ >= static_cast<int>(buf_.size() - 1))
+		tcb::span<const Sample<C>> buffered {buf_.data(), buf_len_};
+
+		written += resample_polyphase<C>(buffer.subspan(written), buffered, table_, kTaps, pos_, ratio_);
+
+		if (written < buffer.size() && !refill())
+			break;
+	}
+
+	return written;
+}
+
+template <size_t C>
+bool Resampler<C>::refill()
+{
+	// Drop the frames that are behind the next output's first tap
+	size_t first = std::min(static_cast<size_t>(pos_), buf_len_);
+	std::copy(buf_.begin() + first, buf_.begin() + buf_len_, buf_.begin());
+	buf_len_ -= first;
+	pos_ -= first;
+
+	size_t source_read = source_->generate(tcb::span {buf_.data() + buf_len_, kBlockSize});
+	if (source_read > 0)
+	{
+		buf_len_ += source_read;
+		flushed_ = false;
+		return true;
+	}
+
+	if (flushed_)
+		return false;
+
+	// The source ran dry. Feed the window silence once so the last frames
+	// make it out instead of being held back by the lead.
+	std::fill_n(buf_.begin() + buf_len_, kTaps / 2, Sample<C> {});
+	buf_len_ += kTaps / 2;
+	flushed_ = true;
+	return true;
+}
+
+template <size_t C>
+void Resampler<C>::build_table(float cutoff)
+{
+	const size_t row_len = kTaps * C;
+	const double half_width = kTaps / 2.0;
+	const double window_scale = 1.0 / bessel_i0(kKaiserBeta);
+
+	for (size_t p = 0; p <= kPhases; p++)
+	{
+		float* row = table_.data() + p * row_len;
+		double frac = static_cast<double>(p) / kPhases;
+		double coefficients[kTaps];
+		double sum = 0.0;
+
+		for (size_t k = 0; k < kTaps; k++)
 		{
-			pos_ -= buf_.size();
-			last_ = buf_.size() == 0 ? Sample<C> {} : buf_.back();
-			buf_.clear();
-			buf_.resize(512);
-			size_t source_read = source_->generate(buf_);
-			buf_.resize(source_read);
-			if (source_read == 0)
-			{
-				break;
-			}
+			// Distance from the output position, in input frames
+			double x = static_cast<double>(k) - kLeadFrames - frac;
+			double r = x / half_width;
+			double window = r * r < 1.0 ? bessel_i0(kKaiserBeta * std::sqrt(1.0 - r * r)) * window_scale : 0.0;
+
+			coefficients[k] = cutoff * sinc(cutoff * x) * window;
+			sum += coefficients[k];
 		}
 
-		if (pos_ < 0)
+		// Unity gain at DC for every phase
+		for (size_t k = 0; k < kTaps; k++)
 		{
-			buffer[written] = (buf_[0] - last_) * pos_frac_ + last_;
-			advance(ratio_);
-			written++;
-			continue;
+			for (size_t c = 0; c < C; c++)
+			{
+				row[k * C + c] = static_cast<float>(coefficients[k] / sum);
+			}
 		}
-
-		buffer[written] = (buf_[pos_ + 1] - buf_[pos_]) * pos_frac_ + buf_[pos_];
-		advance(ratio_);
-		written++;
 	}
 
-	return written;
+	table_cutoff_ = cutoff;
 }
 
 template <size_t C>
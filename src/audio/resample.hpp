@@ -44,21 +44,21 @@ public:
 private:
 	std::shared_ptr<Source<C>> source_;
 	float ratio_ {1.f};
+
+	// Windowed-sinc filter rows for table_cutoff_, laid out for
+	// resample_polyphase
+	std::vector<float> table_;
+	float table_cutoff_ {0.f};
+
+	// buf_ starts with the frames that the next output still needs from
+	// the previous block; pos_ is the position of its first tap.
 	std::vector<Sample<C>> buf_;
-	Sample<C> last_;
-	int pos_ {0};
-	float pos_frac_ {0.f};
-
-	void advance(float samples)
-	{
-		pos_frac_ += samples;
-		float integer;
-		std::modf(pos_frac_, &integer);
-		pos_ += integer;
-		pos_frac_ -= integer;
-	}
-
-	void refill();
+	std::size_t buf_len_ {0};
+	double pos_ {0.0};
+	bool flushed_ {false};
+
+	bool refill();
+	void build_table(float cutoff);
 };
 
 extern template class Resampler<1>;
@@ -34,6 +34,11 @@ public:
 
 constexpr const std::size_t kSampleRate = 44100;
 
+// Nodes that need scratch space pull from their inputs this many samples
+// at a time, so the scratch can be allocated when the node is made instead
+// of on the audio thread.
+constexpr const std::size_t kBlockSize = 512;
+
 } // namespace srb2::audio
 
 #endif // __SRB2_AUDIO_SOURCE_HPP__
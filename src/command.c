@@ -69,6 +69,8 @@ static const char *CV_StringValue(const char *var_name);
 
 consvar_t *consvar_vars; // list of registered console variables
 static UINT16     consvar_number_of_netids = 0;
+static consvar_t  **consvar_netvars; // registered net variables by netid
+static size_t     consvar_netvarscapacity = 0;
 
 static char com_token[1024];
 static char *COM_Parse(char *data);
@@ -327,6 +329,189 @@ void COM_ImmedExecute(const char *ptext)
 	}
 }
 
+// =========================================================================
+//                               NAME INDEX
+// =========================================================================
+
+// Commands and variables are kept in linked lists, but looking them up by
+// name goes through a hash index instead of walking the lists. Name
+// completion uses a copy of the index sorted by name, rebuilt whenever
+// something has been added since the last completion.
+
+typedef struct
+{
+	const char *name;
+	UINT32 hash;
+	void *item; // NULL for an empty slot
+} nameindexentry_t;
+
+typedef struct
+{
+	nameindexentry_t *slots; // open addressed, capacity is a power of 2
+	size_t count;
+	size_t capacity;
+	nameindexentry_t *sorted; // in strcmp order, valid if sortedvalid
+	boolean sortedvalid;
+} nameindex_t;
+
+static nameindex_t com_commandindex;
+static nameindex_t consvar_index;
+
+/** Hashes a name for the name index, ignoring case like stricmp.
+  *
+  * \param name The name to hash.
+  * \return The hash of the name.
+  */
+static UINT32 COM_HashName(const char *name)
+{
+	UINT32 hash = 2166136261u;
+
+	while (*name)
+	{
+		hash ^= (UINT8)tolower((UINT8)*name++);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+/** Doubles the capacity of a name index and reinserts everything.
+  *
+  * \param index The index to grow.
+  */
+static void COM_GrowNameIndex(nameindex_t *index)
+{
+	nameindexentry_t *oldslots = index->slots;
+	size_t oldcapacity = index->capacity;
+	size_t mask, i, j;
+
+	index->capacity = oldcapacity ? oldcapacity * 2 : 256;
+	index->slots = Z_Calloc(index->capacity * sizeof *index->slots, PU_STATIC, NULL);
+	mask = index->capacity - 1;
+
+	for (i = 0; i < oldcapacity; i++)
+	{
+		if (!oldslots[i].item)
+			continue;
+
+		for (j = oldslots[i].hash & mask; index->slots[j].item; j = (j + 1) & mask)
+			;
+
+		index->slots[j] = oldslots[i];
+	}
+
+	Z_Free(oldslots);
+}
+
+/** Adds a name to a name index. The name must not be in it already.
+  *
+  * \param index The index to add to.
+  * \param name  The name, must stay valid for as long as the item is indexed.
+  * \param item  The command or variable the name belongs to.
+  */
+static void COM_AddToNameIndex(nameindex_t *index, const char *name, void *item)
+{
+	UINT32 hash = COM_HashName(name);
+	size_t mask, i;
+
+	// keep the load factor under 3/4
+	if ((index->count + 1) * 4 > index->capacity * 3)
+		COM_GrowNameIndex(index);
+
+	mask = index->capacity - 1;
+
+	for (i = hash & mask; index->slots[i].item; i = (i + 1) & mask)
+		;
+
+	index->slots[i].name = name;
+	index->slots[i].hash = hash;
+	index->slots[i].item = item;
+	index->count++;
+	index->sortedvalid = false;
+}
+
+/** Finds a name in a name index, case insensitive.
+  *
+  * \param index The index to search.
+  * \param name  The name to search for.
+  * \return The command or variable with the name, or NULL.
+  */
+static void *COM_FindInNameIndex(const nameindex_t *index, const char *name)
+{
+	UINT32 hash;
+	size_t mask, i;
+
+	if (!index->count)
+		return NULL;
+
+	hash = COM_HashName(name);
+	mask = index->capacity - 1;
+
+	for (i = hash & mask; index->slots[i].item; i = (i + 1) & mask)
+		if (index->slots[i].hash == hash && !stricmp(name, index->slots[i].name))
+			return index->slots[i].item;
+
+	return NULL;
+}
+
+static int COM_CompareNameIndexEntries(const void *a, const void *b)
+{
+	return strcmp(((const nameindexentry_t *)a)->name, ((const nameindexentry_t *)b)->name);
+}
+
+/** Does name completion from a name index. Names starting with the
+  * partial name are returned in alphabetical order.
+  *
+  * \param index   The index to complete from.
+  * \param partial The partial name, case sensitive.
+  * \param skips   Number of matches to skip.
+  * \param filter  Optional, returns false for items to leave out.
+  * \return The complete name, or NULL.
+  */
+static const char *COM_CompleteFromNameIndex(nameindex_t *index, const char *partial, INT32 skips, boolean (*filter)(void *item))
+{
+	size_t len = strlen(partial);
+	size_t lo, hi, i;
+
+	if (!len || !index->count)
+		return NULL;
+
+	if (!index->sortedvalid)
+	{
+		index->sorted = Z_Realloc(index->sorted, index->count * sizeof *index->sorted, PU_STATIC, NULL);
+
+		for (i = 0, hi = 0; i < index->capacity; i++)
+			if (index->slots[i].item)
+				index->sorted[hi++] = index->slots[i];
+
+		qsort(index->sorted, index->count, sizeof *index->sorted, COM_CompareNameIndexEntries);
+		index->sortedvalid = true;
+	}
+
+	// everything starting with the partial name sorts together, right at or after it
+	lo = 0;
+	hi = index->count;
+	while (lo < hi)
+	{
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (strcmp(index->sorted[mid].name, partial) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (i = lo; i < index->count && !strncmp(partial, index->sorted[i].name, len); i++)
+	{
+		if (filter && !filter(index->sorted[i].item))
+			continue;
+		if (!skips--)
+			return index->sorted[i].name;
+	}
+
+	return NULL;
+}
+
 // =========================================================================
 //                            COMMAND EXECUTION
 // =========================================================================
@@ -521,19 +706,17 @@ xcommand_t *COM_AddCommand(const char *name, com_func_t func)
 	}
 
 	// fail if the command already exists
-	for (cmd = com_commands; cmd; cmd = cmd->next)
+	cmd = COM_FindInNameIndex(&com_commandindex, name); //case insensitive now that we have lower and uppercase!
+	if (cmd)
 	{
-		if (!stricmp(name, cmd->name)) //case insensitive now that we have lower and uppercase!
-		{
-			// don't I_Error for Lua commands
-			// Lua commands can replace game commands, and they have priority.
-			// BUT, if for some reason we screwed up and made two console commands with the same name,
-			// it's good to have this here so we find out.
-			if (cmd->function != COM_Lua_f)
-				I_Error("Command %s already exists\n", name);
-
-			return NULL;
-		}
+		// don't I_Error for Lua commands
+		// Lua commands can replace game commands, and they have priority.
+		// BUT, if for some reason we screwed up and made two console commands with the same name,
+		// it's good to have this here so we find out.
+		if (cmd->function != COM_Lua_f)
+			I_Error("Command %s already exists\n", name);
+
+		return NULL;
 	}
 
 	cmd = ZZ_Alloc(sizeof *cmd);
@@ -542,6 +725,7 @@ xcommand_t *COM_AddCommand(const char *name, com_func_t func)
 	cmd->debug = false;
 	cmd->next = com_commands;
 	com_commands = cmd;
+	COM_AddToNameIndex(&com_commandindex, cmd->name, cmd);
 
 	return cmd;
 }
@@ -567,14 +751,12 @@ int COM_AddLuaCommand(const char *name)
 		return -1;
 
 	// command already exists
-	for (cmd = com_commands; cmd; cmd = cmd->next)
+	cmd = COM_FindInNameIndex(&com_commandindex, name); //case insensitive now that we have lower and uppercase!
+	if (cmd)
 	{
-		if (!stricmp(name, cmd->name)) //case insensitive now that we have lower and uppercase!
-		{
-			// replace the built in command.
-			cmd->function = COM_Lua_f;
-			return 1;
-		}
+		// replace the built in command.
+		cmd->function = COM_Lua_f;
+		return 1;
 	}
 
 	// Add a new command.
@@ -584,6 +766,7 @@ int COM_AddLuaCommand(const char *name)
 	cmd->debug = false;
 	cmd->next = com_commands;
 	com_commands = cmd;
+	COM_AddToNameIndex(&com_commandindex, cmd->name, cmd);
 	return 0;
 }
 
@@ -594,13 +777,7 @@ int COM_AddLuaCommand(const char *name)
   */
 static boolean COM_Exists(const char *com_name)
 {
-	xcommand_t *cmd;
-
-	for (cmd = com_commands; cmd; cmd = cmd->next)
-		if (!stricmp(com_name, cmd->name))
-			return true;
-
-	return false;
+	return COM_FindInNameIndex(&com_commandindex, com_name) != NULL;
 }
 
 /** Does command completion for the console.
@@ -612,21 +789,8 @@ static boolean COM_Exists(const char *com_name)
   */
 const char *COM_CompleteCommand(const char *partial, INT32 skips)
 {
-	xcommand_t *cmd;
-	size_t len;
-
-	len = strlen(partial);
-
-	if (!len)
-		return NULL;
-
 	// check functions
-	for (cmd = com_commands; cmd; cmd = cmd->next)
-		if (!strncmp(partial, cmd->name, len))
-			if (!skips--)
-				return cmd->name;
-
-	return NULL;
+	return COM_CompleteFromNameIndex(&com_commandindex, partial, skips, NULL);
 }
 
 /** Completes the name of an alias.
@@ -673,13 +837,11 @@ static void COM_ExecuteString(char *ptext)
 		return; // no tokens
 
 	// check functions
-	for (cmd = com_commands; cmd; cmd = cmd->next)
+	cmd = COM_FindInNameIndex(&com_commandindex, com_argv[0]); //case insensitive now that we have lower and uppercase!
+	if (cmd)
 	{
-		if (!stricmp(com_argv[0], cmd->name)) //case insensitive now that we have lower and uppercase!
-		{
-			cmd->function();
-			return;
-		}
+		cmd->function();
+		return;
 	}
 
 	// check aliases
@@ -1377,13 +1539,7 @@ static const char *cv_null_string = "";
   */
 static consvar_t *CV_FindVarInternal(const char *name)
 {
-	consvar_t *cvar;
-
-	for (cvar = consvar_vars; cvar; cvar = cvar->next)
-		if (!stricmp(name,cvar->name))
-			return cvar;
-
-	return NULL;
+	return COM_FindInNameIndex(&consvar_index, name);
 }
 
 /** Searches if a variable has been registered and is visible to the console.
@@ -1409,14 +1565,9 @@ consvar_t *CV_FindVar(const char *name)
   */
 static consvar_t *CV_FindNetVar(UINT16 netid)
 {
-	consvar_t *cvar;
-
-	if (netid > consvar_number_of_netids)
-		return NULL;
-
-	for (cvar = consvar_vars; cvar; cvar = cvar->next)
-		if (cvar->netid == netid)
-			return cvar;
+	// Hidden net variables take ids too, but aren't in the table
+	if (netid != 0 && netid < consvar_netvarscapacity && consvar_netvars[netid])
+		return consvar_netvars[netid];
 
 	if (netid == 44542) // ouch this hack
 		return &cv_karteliminatelast;
@@ -1461,6 +1612,21 @@ void CV_RegisterVar(consvar_t *variable)
 	{
 		variable->next = consvar_vars;
 		consvar_vars = variable;
+		COM_AddToNameIndex(&consvar_index, variable->name, variable);
+
+		if (variable->flags & CV_NETVAR)
+		{
+			if (variable->netid >= consvar_netvarscapacity)
+			{
+				size_t newcapacity = max(consvar_netvarscapacity * 2, max((size_t)variable->netid + 1, 256));
+
+				consvar_netvars = Z_Realloc(consvar_netvars, newcapacity * sizeof *consvar_netvars, PU_STATIC, NULL);
+				memset(&consvar_netvars[consvar_netvarscapacity], 0, (newcapacity - consvar_netvarscapacity) * sizeof *consvar_netvars);
+				consvar_netvarscapacity = newcapacity;
+			}
+
+			consvar_netvars[variable->netid] = variable;
+		}
 	}
 	variable->string = variable->zstring = NULL;
 	memset(&variable->revert, 0, sizeof variable->revert);
@@ -1507,29 +1673,15 @@ static const char *CV_StringValue(const char *var_name)
   * \return The complete variable name, or NULL.
   * \sa COM_CompleteCommand, CV_CompleteAlias
   */
-const char *CV_CompleteVar(char *partial, INT32 skips)
+static boolean CV_CompletionVisible(void *item)
 {
-	consvar_t *cvar;
-	size_t len;
-
-	len = strlen(partial);
-
-	if (!len)
-		return NULL;
+	return !(((consvar_t *)item)->flags & CV_NOSHOWHELP);
+}
 
+const char *CV_CompleteVar(char *partial, INT32 skips)
+{
 	// check variables
-	for (cvar = consvar_vars; cvar; cvar = cvar->next)
-	{
-		if (cvar->flags & CV_NOSHOWHELP)
-			continue;
-		if (strncmp(partial, cvar->name, len))
-			continue;
-		if (skips--)
-			continue;
-		return cvar->name;
-	}
-
-	return NULL;
+	return COM_CompleteFromNameIndex(&consvar_index, partial, skips, CV_CompletionVisible);
 }
 
 boolean CV_CompleteValue(consvar_t *var, const char **valstrp, INT32 *intval)
@@ -11,7 +11,6 @@
 #include "memory.h"
 
 #include <array>
-#include <new>
 
 #include "../z_zone.h"
 
@@ -20,25 +19,40 @@ namespace
 
 class LinearMemory
 {
+	// Blocks that didn't fit, chained through their first 16 bytes
+	struct Overflow
+	{
+		Overflow* next;
+	};
+
 	size_t size_;
 	size_t height_;
 	void* memory_;
+	Overflow* overflow_;
 
 public:
 	constexpr explicit LinearMemory(size_t size) noexcept;
 
 	void* allocate(size_t size);
+	size_t remaining() const noexcept;
 	void reset() noexcept;
 };
 
-constexpr LinearMemory::LinearMemory(size_t size) noexcept : size_(size), height_{0}, memory_{nullptr} {}
+constexpr LinearMemory::LinearMemory(size_t size) noexcept
+	: size_(size), height_{0}, memory_{nullptr}, overflow_{nullptr}
+{
+}
 
 void* LinearMemory::allocate(size_t size)
 {
 	size_t aligned_size = (size + 15) & ~15;
 	if (height_ + aligned_size > size_)
 	{
-		throw std::bad_alloc();
+		// Out of arena; fall back to the heap until the next reset
+		Overflow* block = static_cast<Overflow*>(Z_Malloc(16 + aligned_size, PU_STATIC, nullptr));
+		block->next = overflow_;
+		overflow_ = block;
+		return (void*)((uintptr_t)(block) + 16);
 	}
 
 	if (memory_ == nullptr)
@@ -51,20 +65,38 @@ void* LinearMemory::allocate(size_t size)
 	return ptr;
 }
 
+size_t LinearMemory::remaining() const noexcept
+{
+	return size_ - height_;
+}
+
 void LinearMemory::reset() noexcept
 {
 	height_ = 0;
+
+	while (overflow_ != nullptr)
+	{
+		Overflow* next = overflow_->next;
+		Z_Free(overflow_);
+		overflow_ = next;
+	}
 }
 
 } // namespace
 
-static LinearMemory g_frame_memory {4 * 1024 * 1024};
+// Deferred software renderer columns live here until the end of the frame
+static LinearMemory g_frame_memory {16 * 1024 * 1024};
 
 void* Z_Frame_Alloc(size_t size)
 {
 	return g_frame_memory.allocate(size);
 }
 
+size_t Z_Frame_Remaining()
+{
+	return g_frame_memory.remaining();
+}
+
 void Z_Frame_Reset()
 {
 	g_frame_memory.reset();
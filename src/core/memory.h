@@ -19,9 +19,13 @@ extern "C" {
 
 /// @brief Allocate a block of memory with a lifespan of the current main-thread frame.
 /// This function is NOT thread-safe, but the allocated memory may be used across threads.
-/// @return a pointer to a block of memory aligned with libc malloc alignment, or null if allocation fails
+/// Once the frame arena is full, blocks come from the zone heap until the next reset, so this never fails.
+/// @return a pointer to a block of memory aligned with libc malloc alignment
 void* Z_Frame_Alloc(size_t size);
 
+/// @brief How many bytes are left in the frame arena before allocations spill over to the zone heap.
+size_t Z_Frame_Remaining(void);
+
 /// @brief Resets per-frame memory. Not thread safe.
 void Z_Frame_Reset(void);
 
@@ -0,0 +1,85 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+
+#ifndef __SRB2_CORE_SPSC_RING_HPP__
+#define __SRB2_CORE_SPSC_RING_HPP__
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#include "../cxxutil.hpp"
+
+namespace srb2
+{
+
+// Fixed capacity ring for exactly one producer thread and one consumer
+// thread. Neither side ever blocks; a full ring refuses the push.
+template <typename T>
+class SpScRing
+{
+	std::unique_ptr<T[]> buffer_;
+	size_t mask_;
+
+	alignas(64) std::atomic<size_t> head_; // next slot to pop, written by the consumer
+	alignas(64) std::atomic<size_t> tail_; // next slot to push, written by the producer
+
+public:
+	explicit SpScRing(size_t capacity) : buffer_(new T[capacity]), mask_(capacity - 1), head_(0), tail_(0)
+	{
+		SRB2_ASSERT(capacity && (!(capacity & (capacity - 1))) && "Capacity must be a power of 2!");
+	}
+
+	SpScRing(const SpScRing&) = delete;
+	SpScRing& operator=(const SpScRing&) = delete;
+
+	size_t capacity() const noexcept { return mask_ + 1; }
+
+	size_t size() const noexcept
+	{
+		return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+	}
+
+	bool empty() const noexcept { return size() == 0; }
+	bool full() const noexcept { return size() > mask_; }
+
+	// Producer only.
+	bool try_push(const T& v) noexcept
+	{
+		size_t tail = tail_.load(std::memory_order_relaxed);
+
+		if (tail - head_.load(std::memory_order_acquire) > mask_)
+		{
+			return false;
+		}
+
+		buffer_[tail & mask_] = v;
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only.
+	bool try_pop(T& out) noexcept
+	{
+		size_t head = head_.load(std::memory_order_relaxed);
+
+		if (head == tail_.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		out = buffer_[head & mask_];
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+};
+
+} // namespace srb2
+
+#endif // __SRB2_CORE_SPSC_RING_HPP__
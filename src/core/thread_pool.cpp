@@ -14,6 +14,7 @@
 #include <condition_variable>
 #include <exception>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <system_error>
 
@@ -25,7 +26,98 @@
 
 using namespace srb2;
 
-static void do_work(ThreadPool::Task& work)
+// Queues are single-producer. The thread which owns the pool (the main thread) is the only producer for the
+// injection queues; each worker is the only producer for its own local queue, which receives tasks scheduled
+// from inside other tasks. Anyone may steal from any queue. Scheduling from any other thread is not allowed.
+struct ThreadPool::Shared
+{
+	std::atomic<bool> alive {true};
+	std::thread::id owner;
+	std::vector<std::unique_ptr<Queue>> injection_queues;
+	std::vector<std::unique_ptr<Queue>> local_queues;
+	size_t next_queue_index = 0;
+
+	// Approximate count of tasks sitting in queues. Only used to decide whether workers may sleep.
+	std::atomic<int64_t> queued {0};
+	std::atomic<uint32_t> sleeping {0};
+	std::mutex sleep_mutex;
+	std::condition_variable sleep_condvar;
+};
+
+namespace
+{
+
+thread_local ThreadPool::Shared* t_worker_pool = nullptr;
+thread_local size_t t_worker_index = 0;
+
+void wake_sleepers(ThreadPool::Shared& shared, bool all)
+{
+	if (shared.sleeping.load(std::memory_order_seq_cst) == 0)
+	{
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock {shared.sleep_mutex};
+	if (all)
+	{
+		shared.sleep_condvar.notify_all();
+	}
+	else
+	{
+		shared.sleep_condvar.notify_one();
+	}
+}
+
+void enqueue(ThreadPool::Shared& shared, ThreadPool::Task&& task)
+{
+	shared.queued.fetch_add(1, std::memory_order_seq_cst);
+
+	if (t_worker_pool == &shared)
+	{
+		shared.local_queues[t_worker_index]->push(std::move(task));
+	}
+	else
+	{
+		// The injection queues and next_queue_index belong to the owning thread
+		SRB2_ASSERT(std::this_thread::get_id() == shared.owner);
+
+		size_t qi = shared.next_queue_index;
+		shared.injection_queues[qi]->push(std::move(task));
+
+		shared.next_queue_index += 1;
+		if (shared.next_queue_index >= shared.injection_queues.size())
+		{
+			shared.next_queue_index = 0;
+		}
+	}
+
+	// Continuations are enqueued by whoever finishes a group, and nobody would notify for them otherwise
+	wake_sleepers(shared, false);
+}
+
+void complete_group(ThreadPool::Shared& shared, ThreadPool::GroupState* group)
+{
+	for (; group; group = group->parent.get())
+	{
+		if (group->pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		{
+			continue;
+		}
+
+		std::vector<ThreadPool::Task> continuations;
+		{
+			std::lock_guard<std::mutex> lock {group->continuations_mutex};
+			continuations.swap(group->continuations);
+		}
+
+		for (auto& task : continuations)
+		{
+			enqueue(shared, std::move(task));
+		}
+	}
+}
+
+void do_work(ThreadPool::Shared& shared, ThreadPool::Task& work)
 {
 	try
 	{
@@ -38,77 +130,103 @@ static void do_work(ThreadPool::Task& work)
 	}
 
 	(work.deleter)(work.raw.data());
-	if (work.pseudosema)
+	complete_group(shared, work.group.get());
+	work.group = nullptr;
+}
+
+// Find one task to execute from the point of view of the calling thread. Workers prefer their own most recent
+// work (LIFO, for cache locality), the owning thread prefers its own injection queues, and both fall back to
+// stealing the oldest work from everyone else.
+std::optional<ThreadPool::Task> find_work(ThreadPool::Shared& shared)
+{
+	const size_t count = shared.injection_queues.size();
+	std::optional<ThreadPool::Task> work;
+	size_t start = 0;
+
+	if (t_worker_pool == &shared)
+	{
+		start = t_worker_index;
+		work = shared.local_queues[start]->pop();
+	}
+	else
+	{
+		for (size_t i = 0; i < count && !work; i++)
+		{
+			work = shared.injection_queues[i]->pop();
+		}
+	}
+
+	// Order the other queues starting from the calling worker
+	// i.e. if this is worker 2 of 8, then the order is 2, 3, 4, 5, 6, 7, 0, 1
+	// This tries to balance out work stealing behavior
+	for (size_t i = 0; i < count && !work; i++)
 	{
-		work.pseudosema->fetch_sub(1, std::memory_order_relaxed);
+		size_t qi = start + i;
+		if (qi >= count)
+		{
+			qi -= count;
+		}
+
+		work = shared.injection_queues[qi]->steal();
+		if (!work && (t_worker_pool != &shared || qi != t_worker_index))
+		{
+			work = shared.local_queues[qi]->steal();
+		}
 	}
+
+	if (work)
+	{
+		shared.queued.fetch_sub(1, std::memory_order_relaxed);
+	}
+	return work;
 }
 
-static void pool_executor(
-	int thread_index,
-	std::shared_ptr<std::atomic<bool>> pool_alive,
-	std::shared_ptr<std::mutex> worker_ready_mutex,
-	std::shared_ptr<std::condition_variable> worker_ready_condvar,
-	std::shared_ptr<ThreadPool::Queue> my_wq,
-	std::vector<std::shared_ptr<ThreadPool::Queue>> other_wqs
-)
+void pool_executor(size_t thread_index, std::shared_ptr<ThreadPool::Shared> shared)
 {
 	{
 		std::string thread_name = fmt::format("Thread Pool Thread {}", thread_index);
 		tracy::SetThreadName(thread_name.c_str());
 	}
 
+	t_worker_pool = shared.get();
+	t_worker_index = thread_index;
+
 	int spins = 0;
 	while (true)
 	{
-		std::optional<ThreadPool::Task> work = my_wq->steal();
-		bool did_work = false;
+		std::optional<ThreadPool::Task> work = find_work(*shared);
 		if (work)
 		{
-			do_work(*work);
-
-			did_work = true;
+			do_work(*shared, *work);
 			spins = 0;
+			continue;
 		}
-		else
+
+		// Spin a few loops to avoid yielding, then wait for the ready lock
+		spins += 1;
+		if (spins > 100)
 		{
-			for (auto& q : other_wqs)
+			std::unique_lock<std::mutex> ready_lock {shared->sleep_mutex};
+			shared->sleeping.fetch_add(1, std::memory_order_seq_cst);
+			while (shared->queued.load(std::memory_order_seq_cst) <= 0 && shared->alive.load())
 			{
-				work = q->steal();
-				if (work)
-				{
-					do_work(*work);
-
-					did_work = true;
-					spins = 0;
-
-					// We only want to steal one work item at a time, to prioritize our own queue
-					break;
-				}
+				shared->sleep_condvar.wait(ready_lock);
 			}
-		}
+			shared->sleeping.fetch_sub(1, std::memory_order_seq_cst);
+			spins = 0;
 
-		if (!did_work)
-		{
-			// Spin a few loops to avoid yielding, then wait for the ready lock
-			spins += 1;
-			if (spins > 100)
+			if (!shared->alive.load())
 			{
-				std::unique_lock<std::mutex> ready_lock {*worker_ready_mutex};
-				while (my_wq->empty() && pool_alive->load())
-				{
-					worker_ready_condvar->wait(ready_lock);
-				}
-
-				if (!pool_alive->load())
-				{
-					break;
-				}
+				break;
 			}
 		}
 	}
+
+	t_worker_pool = nullptr;
 }
 
+} // namespace
+
 ThreadPool::ThreadPool()
 {
 	immediate_mode_ = true;
@@ -116,60 +234,27 @@ ThreadPool::ThreadPool()
 
 ThreadPool::ThreadPool(size_t threads)
 {
-	next_queue_index_ = 0;
-	pool_alive_ = std::make_shared<std::atomic<bool>>(true);
+	shared_ = std::make_shared<Shared>();
+	shared_->owner = std::this_thread::get_id();
 
 	for (size_t i = 0; i < threads; i++)
 	{
-		std::shared_ptr<Queue> wsq = std::make_shared<Queue>(2048);
-		work_queues_.push_back(wsq);
-
-		std::shared_ptr<std::mutex> mutex = std::make_shared<std::mutex>();
-		worker_ready_mutexes_.push_back(std::move(mutex));
-		std::shared_ptr<std::condition_variable> condvar = std::make_shared<std::condition_variable>();
-		worker_ready_condvars_.push_back(std::move(condvar));
+		shared_->injection_queues.push_back(std::make_unique<Queue>(2048));
+		shared_->local_queues.push_back(std::make_unique<Queue>(2048));
 	}
 
 	for (size_t i = 0; i < threads; i++)
 	{
-		std::shared_ptr<Queue> my_queue = work_queues_[i];
-		std::vector<std::shared_ptr<Queue>> other_queues;
-		for (size_t j = 0; j < threads; j++)
-		{
-			// Order the other queues starting from the next adjacent worker
-			// i.e. if this is worker 2 of 8, then other queues is 3, 4, 5, 6, 7, 0, 1
-			// This tries to balance out work stealing behavior
-
-			size_t other_index = j + i;
-			if (other_index >= threads)
-			{
-				other_index -= threads;
-			}
-
-			if (other_index != i)
-			{
-				other_queues.push_back(work_queues_[other_index]);
-			}
-		}
-
 		std::thread thread;
 		try
 		{
-			thread = std::thread
-			{
-				pool_executor,
-				i,
-				pool_alive_,
-				worker_ready_mutexes_[i],
-				worker_ready_condvars_[i],
-				my_queue,
-				other_queues
-			};
+			thread = std::thread {pool_executor, i, shared_};
 		}
 		catch (const std::system_error& error)
 		{
 			// Safe shutdown and rethrow
-			pool_alive_->store(false);
+			shared_->alive.store(false);
+			wake_sleepers(*shared_, true);
 			for (auto& t : threads_)
 			{
 				t.join();
@@ -186,6 +271,26 @@ ThreadPool::~ThreadPool() = default;
 
 ThreadPool& ThreadPool::operator=(ThreadPool&&) = default;
 
+void ThreadPool::push_task(Task&& task)
+{
+	for (GroupState* g = task.group.get(); g; g = g->parent.get())
+	{
+		g->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	enqueue_task(std::move(task));
+}
+
+void ThreadPool::enqueue_task(Task&& task)
+{
+	enqueue(*shared_, std::move(task));
+}
+
+bool ThreadPool::in_worker() const noexcept
+{
+	return shared_ != nullptr && t_worker_pool == shared_.get();
+}
+
 void ThreadPool::begin_sema()
 {
 	sema_begun_ = true;
@@ -194,27 +299,34 @@ void ThreadPool::begin_sema()
 ThreadPool::Sema ThreadPool::end_sema()
 {
 	Sema ret = Sema(std::move(cur_sema_));
-	cur_sema_ = nullptr;
+	cur_sema_ = TaskGroup();
 	sema_begun_ = false;
 	return ret;
 }
 
+ThreadPool::TaskGroup ThreadPool::make_group(const TaskGroup& parent)
+{
+	std::shared_ptr<GroupState> state = std::make_shared<GroupState>();
+	state->parent = parent.state_;
+	return TaskGroup(std::move(state));
+}
+
 void ThreadPool::notify()
 {
-	for (size_t i = 0; i < work_queues_.size(); i++)
+	if (immediate_mode_)
 	{
-		auto& q = work_queues_[i];
-		size_t count = q->size();
-		if (count > 0)
-		{
-			worker_ready_condvars_[i]->notify_one();
-		}
+		return;
+	}
+
+	if (shared_->queued.load(std::memory_order_seq_cst) > 0)
+	{
+		wake_sleepers(*shared_, true);
 	}
 }
 
 void ThreadPool::notify_sema(const ThreadPool::Sema& sema)
 {
-	if (!sema.pseudosema_)
+	if (!sema.group_.valid())
 	{
 		return;
 	}
@@ -230,46 +342,39 @@ void ThreadPool::wait_idle()
 
 	ZoneScoped;
 
-	for (size_t i = 0; i < work_queues_.size(); i++)
+	std::optional<Task> work;
+	while ((work = find_work(*shared_)).has_value())
 	{
-		auto& q = work_queues_[i];
-
-		std::optional<Task> work;
-		while ((work = q->pop()).has_value())
-		{
-			do_work(*work);
-		}
+		do_work(*shared_, *work);
 	}
 }
 
 void ThreadPool::wait_sema(const Sema& sema)
 {
-	if (!sema.pseudosema_)
+	wait(sema.group_);
+}
+
+void ThreadPool::wait(const TaskGroup& group)
+{
+	if (immediate_mode_ || !group.valid())
 	{
 		return;
 	}
 
 	ZoneScoped;
 
-	while (sema.pseudosema_->load(std::memory_order_seq_cst) > 0)
+	while (group.state_->pending.load(std::memory_order_acquire) > 0)
 	{
-		// spin to win
-		for (size_t i = 0; i < work_queues_.size(); i++)
+		// Help out instead of blocking; this is what lets tasks wait on nested groups without deadlocking
+		std::optional<Task> work = find_work(*shared_);
+		if (work)
 		{
-			auto& q = work_queues_[i];
-
-			std::optional<Task> work;
-			if ((work = q->pop()).has_value())
-			{
-				do_work(*work);
-				break;
-			}
+			do_work(*shared_, *work);
+		}
+		else
+		{
+			std::this_thread::yield();
 		}
-	}
-
-	if (sema.pseudosema_->load(std::memory_order_seq_cst) != 0)
-	{
-		throw std::exception();
 	}
 }
 
@@ -282,16 +387,16 @@ void ThreadPool::shutdown()
 
 	wait_idle();
 
-	pool_alive_->store(false);
-
-	for (auto& condvar : worker_ready_condvars_)
+	shared_->alive.store(false);
 	{
-		condvar->notify_all();
+		std::lock_guard<std::mutex> lock {shared_->sleep_mutex};
+		shared_->sleep_condvar.notify_all();
 	}
 	for (auto& t : threads_)
 	{
 		t.join();
 	}
+	threads_.clear();
 }
 
 std::unique_ptr<ThreadPool> srb2::g_main_threadpool;
@@ -344,3 +449,33 @@ void I_ThreadPoolWaitIdle(void)
 
 	g_main_threadpool->wait_idle();
 }
+
+struct srb2ctaskgroup_s
+{
+	ThreadPool::TaskGroup group;
+};
+
+srb2ctaskgroup_t* I_ThreadPoolNewGroup(void)
+{
+	SRB2_ASSERT(g_main_threadpool != nullptr);
+
+	return new srb2ctaskgroup_t {g_main_threadpool->make_group()};
+}
+
+void I_ThreadPoolSubmitGroup(srb2ctaskgroup_t* group, srb2cthunk_t thunk, void* data)
+{
+	SRB2_ASSERT(g_main_threadpool != nullptr);
+
+	g_main_threadpool->schedule(group->group, [=]() {
+		(thunk)(data);
+	});
+	g_main_threadpool->notify();
+}
+
+void I_ThreadPoolWaitGroup(srb2ctaskgroup_t* group)
+{
+	SRB2_ASSERT(g_main_threadpool != nullptr);
+
+	g_main_threadpool->wait(group->group);
+	delete group;
+}
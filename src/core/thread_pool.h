@@ -15,15 +15,20 @@
 
 #ifdef __cplusplus
 
+#include <array>
+#include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "../cxxutil.hpp"
 #include "spmc_queue.hpp"
 
 namespace srb2
@@ -32,39 +37,70 @@ namespace srb2
 class ThreadPool
 {
 public:
+	struct GroupState;
+
 	struct Task
 	{
 		void (*thunk)(void*);
 		void (*deleter)(void*);
-		std::shared_ptr<std::atomic<uint32_t>> pseudosema;
-		std::array<std::byte, 512 - sizeof(void(*)(void*)) * 2 - sizeof(std::shared_ptr<std::atomic<uint32_t>>)> raw;
+		std::shared_ptr<GroupState> group;
+		std::array<std::byte, 512 - sizeof(void(*)(void*)) * 2 - sizeof(std::shared_ptr<GroupState>)> raw;
 	};
 
 	using Queue = SpMcQueue<Task>;
 
+	/// Bookkeeping for a TaskGroup. Every scheduled task counts towards its group and all of the group's parents.
+	struct GroupState
+	{
+		std::atomic<uint32_t> pending {0};
+		std::shared_ptr<GroupState> parent;
+		std::mutex continuations_mutex;
+		std::vector<Task> continuations;
+	};
+
+	/// A set of tasks which can be waited on independently of the rest of the pool. Groups may be nested by
+	/// passing a parent to make_group; waiting on a parent also waits for the tasks of all of its children.
+	class TaskGroup
+	{
+		std::shared_ptr<GroupState> state_;
+
+		explicit TaskGroup(std::shared_ptr<GroupState> state) : state_(std::move(state)) {}
+
+		friend class ThreadPool;
+	public:
+		TaskGroup() = default;
+
+		bool valid() const noexcept { return state_ != nullptr; }
+		bool done() const noexcept { return !state_ || state_->pending.load(std::memory_order_acquire) == 0; }
+	};
+
 	class Sema
 	{
-		std::shared_ptr<std::atomic<uint32_t>> pseudosema_;
+		TaskGroup group_;
 
-		explicit Sema(std::shared_ptr<std::atomic<uint32_t>> sema) : pseudosema_(sema) {}
+		explicit Sema(TaskGroup group) : group_(std::move(group)) {}
 
 		friend class ThreadPool;
 	public:
 		Sema() = default;
 	};
 
+	struct Shared;
+
 private:
-	std::shared_ptr<std::atomic<bool>> pool_alive_;
-	std::vector<std::shared_ptr<std::mutex>> worker_ready_mutexes_;
-	std::vector<std::shared_ptr<std::condition_variable>> worker_ready_condvars_;
-	std::vector<std::shared_ptr<Queue>> work_queues_;
+	std::shared_ptr<Shared> shared_;
 	std::vector<std::thread> threads_;
-	size_t next_queue_index_ = 0;
-	std::shared_ptr<std::atomic<uint32_t>> cur_sema_;
+	TaskGroup cur_sema_;
 
 	bool immediate_mode_ = false;
 	bool sema_begun_ = false;
 
+	template <typename T> static Task make_task(T&& thunk);
+	/// Count task towards its group, then enqueue it
+	void push_task(Task&& task);
+	/// Enqueue an already counted task on the calling thread's queue
+	void enqueue_task(Task&& task);
+
 public:
 	ThreadPool();
 	explicit ThreadPool(size_t threads);
@@ -78,14 +114,28 @@ public:
 	void begin_sema();
 	ThreadPool::Sema end_sema();
 
-	/// Enqueue but don't notify
+	/// Create a new task group, optionally nested inside parent
+	TaskGroup make_group(const TaskGroup& parent = TaskGroup());
+
+	/// Enqueue and wake at most one sleeping thread. Only the thread which created the pool and the pool's workers
+	/// may schedule.
 	template <typename T> void schedule(T&& thunk);
-	/// Notify threads after several schedules
+	/// Enqueue into a group and wake at most one sleeping thread
+	template <typename T> void schedule(const TaskGroup& group, T&& thunk);
+	/// Run thunk once every task in after has finished, counting it towards group (which may be empty)
+	template <typename T> void schedule_after(const TaskGroup& after, const TaskGroup& group, T&& thunk);
+	/// Wake every sleeping thread after several schedules
 	void notify();
 	void notify_sema(const Sema& sema);
 	void wait_idle();
 	void wait_sema(const Sema& sema);
+	/// Help execute tasks until every task in group (and its children) has finished
+	void wait(const TaskGroup& group);
 	void shutdown();
+
+	/// True if the calling thread is one of this pool's workers
+	bool in_worker() const noexcept;
+	size_t thread_count() const noexcept { return threads_.size(); }
 };
 
 extern std::unique_ptr<ThreadPool> g_main_threadpool;
@@ -103,10 +153,21 @@ void callable_destroyer(F* f)
 }
 
 template <typename T>
-void ThreadPool::schedule(T&& thunk)
+ThreadPool::Task ThreadPool::make_task(T&& thunk)
 {
-	static_assert(sizeof(T) <= sizeof(std::declval<Task>().raw));
+	using U = std::decay_t<T>;
+	static_assert(sizeof(U) <= sizeof(std::declval<Task>().raw));
+
+	Task task;
+	task.thunk = reinterpret_cast<void(*)(void*)>(callable_caller<U>);
+	task.deleter = reinterpret_cast<void(*)(void*)>(callable_destroyer<U>);
+	new (reinterpret_cast<U*>(task.raw.data())) U(std::forward<T>(thunk));
+	return task;
+}
 
+template <typename T>
+void ThreadPool::schedule(T&& thunk)
+{
 	if (immediate_mode_)
 	{
 		(thunk)();
@@ -115,32 +176,60 @@ void ThreadPool::schedule(T&& thunk)
 
 	if (sema_begun_)
 	{
-		if (cur_sema_ == nullptr)
+		if (!cur_sema_.valid())
 		{
-			cur_sema_ = std::make_shared<std::atomic<uint32_t>>(0);
+			cur_sema_ = make_group();
 		}
-		cur_sema_->fetch_add(1, std::memory_order_relaxed);
+		schedule(cur_sema_, std::forward<T>(thunk));
+		return;
+	}
+
+	push_task(make_task(std::forward<T>(thunk)));
+}
+
+template <typename T>
+void ThreadPool::schedule(const TaskGroup& group, T&& thunk)
+{
+	if (immediate_mode_)
+	{
+		(thunk)();
+		return;
 	}
 
-	size_t qi = next_queue_index_;
+	Task task = make_task(std::forward<T>(thunk));
+	task.group = group.state_;
+	push_task(std::move(task));
+}
 
+template <typename T>
+void ThreadPool::schedule_after(const TaskGroup& after, const TaskGroup& group, T&& thunk)
+{
+	SRB2_ASSERT(!after.valid() || after.state_ != group.state_);
+
+	if (immediate_mode_)
 	{
-		std::shared_ptr<Queue> q = work_queues_[qi];
-		Task task;
-		task.thunk = reinterpret_cast<void(*)(void*)>(callable_caller<T>);
-		task.deleter = reinterpret_cast<void(*)(void*)>(callable_destroyer<T>);
-		task.pseudosema = cur_sema_;
-		new (reinterpret_cast<T*>(task.raw.data())) T(std::move(thunk));
-
-		q->push(std::move(task));
+		(thunk)();
+		return;
 	}
-	// worker_ready_condvars_[qi]->notify_one();
 
-	next_queue_index_ += 1;
-	if (next_queue_index_ >= threads_.size())
+	Task task = make_task(std::forward<T>(thunk));
+	task.group = group.state_;
+	for (GroupState* g = task.group.get(); g; g = g->parent.get())
 	{
-		next_queue_index_ = 0;
+		g->pending.fetch_add(1, std::memory_order_relaxed);
 	}
+
+	if (after.valid())
+	{
+		std::lock_guard<std::mutex> lock {after.state_->continuations_mutex};
+		if (after.state_->pending.load(std::memory_order_acquire) > 0)
+		{
+			after.state_->continuations.push_back(std::move(task));
+			return;
+		}
+	}
+
+	enqueue_task(std::move(task));
 }
 
 } // namespace srb2
@@ -150,12 +239,18 @@ extern "C" {
 #endif // __cplusplus
 
 typedef void (*srb2cthunk_t)(void*);
+typedef struct srb2ctaskgroup_s srb2ctaskgroup_t;
 
 void I_ThreadPoolInit(void);
 void I_ThreadPoolShutdown(void);
 void I_ThreadPoolSubmit(srb2cthunk_t thunk, void* data);
 void I_ThreadPoolWaitIdle(void);
 
+/// Task groups for C callers: submit any number of thunks, then wait on the group, which also frees it.
+srb2ctaskgroup_t* I_ThreadPoolNewGroup(void);
+void I_ThreadPoolSubmitGroup(srb2ctaskgroup_t* group, srb2cthunk_t thunk, void* data);
+void I_ThreadPoolWaitGroup(srb2ctaskgroup_t* group);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
@@ -35,6 +35,7 @@
 #include "p_saveg.h"
 #include "z_zone.h"
 #include "p_local.h"
+#include "p_synchash.h"
 #include "m_misc.h"
 #include "am_map.h"
 #include "m_random.h"
@@ -43,13 +44,16 @@
 #include "r_local.h"
 #include "m_argv.h"
 #include "p_setup.h"
-#include "lzf.h"
+#include "m_delta.h"
 #include "lua_script.h"
 #include "lua_hook.h"
 #include "md5.h"
 #include "m_perfstats.h"
 #include "monocypher/monocypher.h"
 #include "stun.h"
+#include "core/thread_pool.h"
+
+#include <zlib.h>
 
 // SRB2Kart
 #include "k_credits.h"
@@ -115,6 +119,15 @@ static boolean resendingsavegame[MAXNETNODES]; // Are we resending the savegame?
 static tic_t savegameresendcooldown[MAXNETNODES]; // How long before we can resend again?
 static tic_t freezetimeout[MAXNETNODES]; // Until when can this node freeze the server before getting a timeout?
 
+// Uncompressed savegames, kept so a resend only has to carry what changed
+typedef struct
+{
+	UINT8 *buffer;
+	size_t length;
+} netsavebase_t;
+static netsavebase_t netsavesent[MAXNETNODES]; // Last savegame sent, waiting for PT_RECEIVEDGAMESTATE
+static netsavebase_t netsaveacked[MAXNETNODES]; // Last savegame the node said it loaded
+
 // Incremented by cv_joindelay when a client joins, decremented each tic.
 // If higher than cv_joindelay * 2 (3 joins in a short timespan), joins are temporarily disabled.
 static tic_t joindelay = 0;
@@ -147,7 +160,7 @@ static tic_t firstticstosend; // min of the nettics
 static tic_t tictoclear = 0; // optimize d_clearticcmd
 static tic_t maketic;
 
-static INT16 consistancy[BACKUPTICS];
+static UINT32 consistancy[BACKUPTICS];
 
 static UINT8 player_joining = false;
 UINT8 hu_redownloadinggamestate = 0;
@@ -164,6 +177,7 @@ static boolean cl_packetmissed;
 // here it is for the secondary local player (splitscreen)
 static UINT8 mynode; // my address pointofview server
 static boolean cl_redownloadinggamestate = false;
+static netsavebase_t cl_netsavebase; // Last savegame we loaded, base for delta resends
 
 static UINT8 localtextcmd[MAXSPLITSCREENPLAYERS][MAXTEXTCMD];
 static tic_t neededtic;
@@ -267,33 +281,122 @@ shouldsign_t ShouldSignChallenge(uint8_t *message)
 	return SIGN_OK;
 }
 
-static inline void *G_DcpyTiccmd(void* dest, const ticcmd_t* src, const size_t n)
+// Which fields of a ticcmd follow the mask byte in PT_SERVERTICS
+#define TD_FWD      0x01
+#define TD_TURNING  0x02
+#define TD_ANGLE    0x04
+#define TD_THROWDIR 0x08
+#define TD_AIMING   0x10
+#define TD_BUTTONS  0x20
+#define TD_LATENCY  0x40
+#define TD_FLAGS    0x80
+
+// Analog axes move by small steps from tic to tic, so their changes go
+// out zigzag coded in 7 bit groups: one byte for most tics, three at worst.
+static UINT8 *WriteAxisDelta(UINT8 *p, INT16 value, INT16 base)
 {
-	const size_t d = n / sizeof(ticcmd_t);
-	const size_t r = n % sizeof(ticcmd_t);
-	UINT8 *ret = dest;
+	UINT16 delta = (UINT16)(value - base);
+	UINT16 zigzag = (UINT16)((delta << 1) ^ (UINT16)((INT16)delta >> 15));
 
-	if (r)
-		M_Memcpy(dest, src, n);
-	else if (d)
-		G_MoveTiccmd(dest, src, d);
-	return ret+n;
+	while (zigzag >= 0x80)
+	{
+		*p++ = (UINT8)(zigzag | 0x80);
+		zigzag >>= 7;
+	}
+	*p++ = (UINT8)zigzag;
+	return p;
 }
 
-static inline void *G_ScpyTiccmd(ticcmd_t* dest, void* src, const size_t n)
+static INT16 ReadAxisDelta(UINT8 **p, INT16 base)
 {
-	const size_t d = n / sizeof(ticcmd_t);
-	const size_t r = n % sizeof(ticcmd_t);
-	UINT8 *ret = src;
+	UINT16 zigzag = 0;
+	INT32 shift = 0;
+	UINT8 b;
+
+	do
+	{
+		b = *(*p)++;
+		zigzag |= (UINT16)((b & 0x7F) << shift);
+		shift += 7;
+	} while ((b & 0x80) && shift < 21);
+
+	return (INT16)(base + (INT16)((zigzag >> 1) ^ (UINT16)-(zigzag & 1)));
+}
+
+// Writes cmd as the fields that differ from base, at most
+// MAXTICCMDDELTASIZE bytes. Bots also carry their item confirm, like
+// G_MoveTiccmd copies it.
+static UINT8 *SV_WriteTiccmdDelta(UINT8 *p, const ticcmd_t *cmd, const ticcmd_t *base)
+{
+	UINT8 *mask = p++;
+
+	*mask = 0;
+
+	if (cmd->forwardmove != base->forwardmove)
+	{
+		*mask |= TD_FWD;
+		WRITESINT8(p, cmd->forwardmove);
+	}
+	if (cmd->turning != base->turning)
+	{
+		*mask |= TD_TURNING;
+		p = WriteAxisDelta(p, cmd->turning, base->turning);
+	}
+	if (cmd->angle != base->angle)
+	{
+		*mask |= TD_ANGLE;
+		p = WriteAxisDelta(p, cmd->angle, base->angle);
+	}
+	if (cmd->throwdir != base->throwdir)
+	{
+		*mask |= TD_THROWDIR;
+		p = WriteAxisDelta(p, cmd->throwdir, base->throwdir);
+	}
+	if (cmd->aiming != base->aiming)
+	{
+		*mask |= TD_AIMING;
+		p = WriteAxisDelta(p, cmd->aiming, base->aiming);
+	}
+	if (cmd->buttons != base->buttons)
+	{
+		*mask |= TD_BUTTONS;
+		WRITEUINT16(p, cmd->buttons);
+	}
+	if (cmd->latency != base->latency)
+	{
+		*mask |= TD_LATENCY;
+		WRITEUINT8(p, cmd->latency);
+	}
+	if (cmd->flags != base->flags)
+	{
+		*mask |= TD_FLAGS;
+		WRITEUINT8(p, cmd->flags);
+	}
+
+	if (cmd->flags & TICCMD_BOT)
+		WRITESINT8(p, cmd->bot.itemconfirm);
 
-	if (r)
-		M_Memcpy(dest, src, n);
-	else if (d)
-		G_MoveTiccmd(dest, src, d);
-	return ret+n;
+	return p;
 }
 
+static UINT8 *CL_ReadTiccmdDelta(ticcmd_t *cmd, UINT8 *p, const ticcmd_t *base)
+{
+	UINT8 mask = READUINT8(p);
+
+	cmd->forwardmove = (mask & TD_FWD) ? READSINT8(p) : base->forwardmove;
+	cmd->turning = (mask & TD_TURNING) ? ReadAxisDelta(&p, base->turning) : base->turning;
+	cmd->angle = (mask & TD_ANGLE) ? ReadAxisDelta(&p, base->angle) : base->angle;
+	cmd->throwdir = (mask & TD_THROWDIR) ? ReadAxisDelta(&p, base->throwdir) : base->throwdir;
+	cmd->aiming = (mask & TD_AIMING) ? ReadAxisDelta(&p, base->aiming) : base->aiming;
+	cmd->buttons = (mask & TD_BUTTONS) ? READUINT16(p) : base->buttons;
+	cmd->latency = (mask & TD_LATENCY) ? READUINT8(p) : base->latency;
+	cmd->flags = (mask & TD_FLAGS) ? READUINT8(p) : base->flags;
 
+	if (cmd->flags & TICCMD_BOT)
+		cmd->bot.itemconfirm = READSINT8(p);
+
+	return p;
+}
 
 // Some software don't support largest packet
 // (original sersetup, not exactely, but the probability of sending a packet
@@ -623,7 +726,8 @@ void ReadLmpExtraData(UINT8 **demo_pointer, INT32 playernum)
 // end extra data function for lmps
 // -----------------------------------------------------------------
 
-static INT16 Consistancy(void);
+static UINT32 Consistancy(void);
+static const char *ConsistancyMismatch(UINT32 a, UINT32 b);
 
 typedef enum
 {
@@ -1248,12 +1352,153 @@ static boolean SV_ResendingSavegameToAnyone(void)
 	return false;
 }
 
+static void NetSaveBaseFree(netsavebase_t *base)
+{
+	Z_Free(base->buffer);
+	base->buffer = NULL;
+	base->length = 0;
+}
+
+// Savegame transfer header flags
+#define NETSAVE_DEFLATE 0x01 // payload is zlib compressed
+#define NETSAVE_DELTA   0x02 // payload is an M_DeltaEncode stream against the last acknowledged savegame
+
+// The savegame is deflated in blocks on the thread pool, pigz style:
+// every block is primed with the tail of the one before it and ends on
+// a sync flush, so the blocks join into one zlib stream that the client
+// inflates in one go.
+#define NETSAVE_DEFLATEBLOCK (128*1024)
+#define NETSAVE_DEFLATEDICT (32*1024)
+
+typedef struct
+{
+	const UINT8 *in;
+	size_t inlen;
+	size_t dictlen; // bytes before in used as dictionary
+	boolean last;
+	UINT8 *out;
+	size_t outsize;
+	size_t outlen;
+	boolean ok;
+} deflateblock_t;
+
+static void SV_DeflateBlock(void *data)
+{
+	deflateblock_t *block = data;
+	z_stream strm;
+	int flush = block->last ? Z_FINISH : Z_SYNC_FLUSH;
+	int ret;
+
+	block->ok = false;
+
+	memset(&strm, 0, sizeof strm);
+	if (deflateInit2(&strm, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return;
+
+	if (block->dictlen)
+		deflateSetDictionary(&strm, block->in - block->dictlen, block->dictlen);
+
+	strm.next_in = (Bytef *)block->in;
+	strm.avail_in = block->inlen;
+	strm.next_out = block->out;
+	strm.avail_out = block->outsize;
+
+	ret = deflate(&strm, flush);
+	if (strm.avail_in == 0 && strm.avail_out != 0 && ret == (block->last ? Z_STREAM_END : Z_OK))
+	{
+		block->outlen = block->outsize - strm.avail_out;
+		block->ok = true;
+	}
+
+	deflateEnd(&strm);
+}
+
+static size_t SV_DeflateSaveGameBound(size_t length)
+{
+	return compressBound(length) + (length / NETSAVE_DEFLATEBLOCK + 1) * 16;
+}
+
+// Compresses in into a zlib stream at out, which must hold
+// SV_DeflateSaveGameBound(inlen) bytes. Returns 0 on failure.
+static size_t SV_DeflateSaveGame(const UINT8 *in, size_t inlen, UINT8 *out)
+{
+	size_t numblocks = inlen / NETSAVE_DEFLATEBLOCK + 1;
+	deflateblock_t *blocks = Z_Calloc(numblocks * sizeof (*blocks), PU_STATIC, NULL);
+	UINT8 *p = out;
+	boolean success = true;
+	size_t i;
+#ifdef HAVE_THREADS
+	srb2ctaskgroup_t *group = (numblocks > 1) ? I_ThreadPoolNewGroup() : NULL;
+#endif
+
+	for (i = 0; i < numblocks; i++)
+	{
+		deflateblock_t *block = &blocks[i];
+		size_t offset = i * NETSAVE_DEFLATEBLOCK;
+
+		block->in = in + offset;
+		block->inlen = min(NETSAVE_DEFLATEBLOCK, inlen - offset);
+		block->dictlen = min(NETSAVE_DEFLATEDICT, offset);
+		block->last = (i == numblocks - 1);
+		block->outsize = compressBound(block->inlen) + 16;
+		block->out = Z_Malloc(block->outsize, PU_STATIC, NULL);
+
+#ifdef HAVE_THREADS
+		if (group != NULL)
+		{
+			I_ThreadPoolSubmitGroup(group, SV_DeflateBlock, block);
+			continue;
+		}
+#endif
+		SV_DeflateBlock(block);
+	}
+
+#ifdef HAVE_THREADS
+	if (group != NULL)
+		I_ThreadPoolWaitGroup(group);
+#endif
+
+	// zlib header for best compression
+	WRITEUINT8(p, 0x78);
+	WRITEUINT8(p, 0xDA);
+
+	for (i = 0; i < numblocks; i++)
+	{
+		if (!blocks[i].ok)
+			success = false;
+		else if (success)
+		{
+			memcpy(p, blocks[i].out, blocks[i].outlen);
+			p += blocks[i].outlen;
+		}
+		Z_Free(blocks[i].out);
+	}
+	Z_Free(blocks);
+
+	if (!success)
+		return 0;
+
+	{
+		uLong adler = adler32(adler32(0, NULL, 0), in, inlen);
+		WRITEUINT8(p, (adler >> 24) & 0xFF);
+		WRITEUINT8(p, (adler >> 16) & 0xFF);
+		WRITEUINT8(p, (adler >> 8) & 0xFF);
+		WRITEUINT8(p, adler & 0xFF);
+	}
+
+	return p - out;
+}
+
 static void SV_SendSaveGame(INT32 node, boolean resending)
 {
-	size_t length, compressedlen;
+	size_t length, payloadlen, headerlen, compressedlen;
 	savebuffer_t save = {0};
-	UINT8 *compressedsave;
+	UINT8 *delta = NULL;
+	UINT8 *payload;
 	UINT8 *buffertosend;
+	UINT8 *p;
+	UINT8 flags = 0;
+	netsavebase_t *base = &netsaveacked[node];
 
 	// first save it in a malloced buffer
 	if (P_SaveBufferAlloc(&save, NETSAVEGAMESIZE) == false)
@@ -1262,9 +1507,6 @@ static void SV_SendSaveGame(INT32 node, boolean resending)
 		return;
 	}
 
-	// Leave room for the uncompressed length.
-	save.p += sizeof(UINT32);
-
 	P_SaveNetGame(&save, resending);
 
 	length = save.p - save.buffer;
@@ -1274,36 +1516,59 @@ static void SV_SendSaveGame(INT32 node, boolean resending)
 		I_Error("Savegame buffer overrun");
 	}
 
-	// Allocate space for compressed save: one byte fewer than for the
-	// uncompressed data to ensure that the compression is worthwhile.
-	compressedsave = Z_Malloc(length - 1, PU_STATIC, NULL);
-	if (!compressedsave)
+	payload = save.buffer;
+	payloadlen = length;
+
+	// The node still has the last savegame it loaded,
+	// so a resend only needs what changed since then.
+	if (resending && base->buffer != NULL)
 	{
-		CONS_Alert(CONS_ERROR, M_GetText("No more free memory for savegame\n"));
-		return;
+		delta = Z_Malloc(M_DeltaBound(length), PU_STATIC, NULL);
+		payloadlen = M_DeltaEncode(base->buffer, base->length, save.buffer, length, delta);
+		payload = delta;
+		flags |= NETSAVE_DELTA;
 	}
 
-	// Attempt to compress it.
-	if ((compressedlen = lzf_compress(save.buffer + sizeof(UINT32), length - sizeof(UINT32), compressedsave + sizeof(UINT32), length - sizeof(UINT32) - 1)))
-	{
-		// Compressing succeeded; send compressed data
-		P_SaveBufferFree(&save);
+	headerlen = 1 + sizeof(UINT32);
+	if (flags & NETSAVE_DELTA)
+		headerlen += 2 * sizeof(UINT32);
+
+	buffertosend = Z_Malloc(headerlen + max(SV_DeflateSaveGameBound(payloadlen), payloadlen), PU_STATIC, NULL);
 
-		// State that we're compressed.
-		buffertosend = compressedsave;
-		WRITEUINT32(compressedsave, length - sizeof(UINT32));
-		length = compressedlen + sizeof(UINT32);
+	// Compression is worth it only if it's smaller than the data itself.
+	compressedlen = SV_DeflateSaveGame(payload, payloadlen, buffertosend + headerlen);
+	if (compressedlen != 0 && compressedlen < payloadlen)
+	{
+		flags |= NETSAVE_DEFLATE;
+		payloadlen = compressedlen;
 	}
 	else
 	{
-		// Compression failed to make it smaller; send original
-		Z_Free(compressedsave);
+		memcpy(buffertosend + headerlen, payload, payloadlen);
+	}
 
-		// State that we're not compressed
-		buffertosend = save.buffer;
-		WRITEUINT32(save.buffer, 0);
+	p = buffertosend;
+	WRITEUINT8(p, flags);
+	WRITEUINT32(p, length);
+	if (flags & NETSAVE_DELTA)
+	{
+		WRITEUINT32(p, crc32(0, base->buffer, base->length));
+		WRITEUINT32(p, base->length);
 	}
 
+	Z_Free(delta);
+
+	if (flags & NETSAVE_DELTA)
+		CONS_Printf(M_GetText("Sending %s of changes to a %s savegame\n"), sizeu1(payloadlen), sizeu2(length));
+
+	// Keep the uncompressed savegame around; once the node confirms
+	// it loaded it, it becomes the base for the next resend. Trim it
+	// down from NETSAVEGAMESIZE first, since every node keeps two.
+	NetSaveBaseFree(&netsavesent[node]);
+	netsavesent[node].buffer = Z_Realloc(save.buffer, length, PU_STATIC, NULL);
+	netsavesent[node].length = length;
+
+	length = headerlen + payloadlen;
 	AddRamToSendQueue(node, buffertosend, length, SF_Z_RAM, 0);
 
 	// Remember when we started sending the savegame so we can handle timeouts
@@ -1355,10 +1620,94 @@ static void SV_SavedGame(void)
 #define TMPSAVENAME "$$$.sav"
 
 
+// Turns the savegame as sent by SV_SendSaveGame back into the raw
+// savegame, and keeps a copy as the base for the next delta.
+static boolean CL_DecodeReceivedSavegame(savebuffer_t *save)
+{
+	UINT8 flags;
+	size_t rawlen, payloadlen;
+	UINT8 *payload;
+	UINT8 *raw;
+	UINT8 *inflated = NULL;
+	boolean success = true;
+
+	if (P_SaveBufferRemaining(save) < 1 + sizeof(UINT32))
+		return false;
+
+	flags = READUINT8(save->p);
+	rawlen = READUINT32(save->p);
+
+	if (rawlen == 0 || rawlen > NETSAVEGAMESIZE)
+		return false;
+
+	if (flags & NETSAVE_DELTA)
+	{
+		UINT32 basecrc, baselen;
+
+		if (P_SaveBufferRemaining(save) < 2 * sizeof(UINT32))
+			return false;
+
+		basecrc = READUINT32(save->p);
+		baselen = READUINT32(save->p);
+
+		if (cl_netsavebase.buffer == NULL || cl_netsavebase.length != baselen
+			|| crc32(0, cl_netsavebase.buffer, cl_netsavebase.length) != basecrc)
+		{
+			CONS_Alert(CONS_ERROR, M_GetText("Savegame delta does not match the last savegame we loaded\n"));
+			return false;
+		}
+	}
+
+	payload = save->p;
+	payloadlen = P_SaveBufferRemaining(save);
+
+	if (flags & NETSAVE_DEFLATE)
+	{
+		// A delta is never larger than its bound, a full savegame never larger than itself
+		uLongf inflatedlen = (flags & NETSAVE_DELTA) ? M_DeltaBound(rawlen) : rawlen;
+
+		inflated = Z_Malloc(inflatedlen, PU_STATIC, NULL);
+		if (uncompress(inflated, &inflatedlen, payload, payloadlen) != Z_OK)
+		{
+			Z_Free(inflated);
+			return false;
+		}
+
+		payload = inflated;
+		payloadlen = inflatedlen;
+	}
+
+	raw = Z_Malloc(rawlen, PU_STATIC, NULL);
+
+	if (flags & NETSAVE_DELTA)
+		success = M_DeltaDecode(cl_netsavebase.buffer, cl_netsavebase.length, payload, payloadlen, raw, rawlen);
+	else if (payloadlen == rawlen)
+		memcpy(raw, payload, rawlen);
+	else
+		success = false;
+
+	Z_Free(inflated);
+	P_SaveBufferFree(save);
+
+	if (!success)
+	{
+		Z_Free(raw);
+		return false;
+	}
+
+	NetSaveBaseFree(&cl_netsavebase);
+	cl_netsavebase.buffer = Z_Malloc(rawlen, PU_STATIC, NULL);
+	cl_netsavebase.length = rawlen;
+	memcpy(cl_netsavebase.buffer, raw, rawlen);
+
+	P_SaveBufferFromExisting(save, raw, rawlen);
+	return true;
+}
+
 static void CL_LoadReceivedSavegame(boolean reloading)
 {
 	savebuffer_t save = {0};
-	size_t length, decompressedlen;
+	size_t length;
 	char tmpsave[256];
 
 	sprintf(tmpsave, "%s" PATHSEP TMPSAVENAME, srb2home);
@@ -1372,16 +1721,10 @@ static void CL_LoadReceivedSavegame(boolean reloading)
 	length = save.size;
 	CONS_Printf(M_GetText("Loading savegame length %s\n"), sizeu1(length));
 
-	// Decompress saved game if necessary.
-	decompressedlen = READUINT32(save.p);
-	if (decompressedlen > 0)
+	if (!CL_DecodeReceivedSavegame(&save))
 	{
-		UINT8 *decompressedbuffer = Z_Malloc(decompressedlen, PU_STATIC, NULL);
-
-		lzf_decompress(save.p, length - sizeof(UINT32), decompressedbuffer, decompressedlen);
-
-		P_SaveBufferFree(&save);
-		P_SaveBufferFromExisting(&save, decompressedbuffer, decompressedlen);
+		I_Error("Can't decode savegame sent");
+		return;
 	}
 
 	paused = false;
@@ -2000,10 +2343,10 @@ static boolean CL_ServerConnectionTicker(const char *tmpsave, tic_t *oldtic, tic
 			for (i = 0; i < fileneedednum; i++)
 				if (fileneeded[i].status == FS_NOTFOUND || fileneeded[i].status == FS_MD5SUMBAD)
 				{
-					if (!curl_running)
-						CURLPrepareFile(http_source, i);
 					waitmore = true;
-					break;
+					// Start as many as there are free slots
+					if (!CURLPrepareFile(http_source, i))
+						break;
 				}
 
 			if (curl_running)
@@ -2622,6 +2965,8 @@ void CL_Reset(void)
 	SV_StopServer();
 	SV_ResetServer();
 
+	NetSaveBaseFree(&cl_netsavebase);
+
 	// make sure we don't leave any fileneeded gunk over from a failed join
 	fileneedednum = 0;
 	memset(fileneeded, 0, sizeof(fileneeded));
@@ -3311,6 +3656,8 @@ static void ResetNode(INT32 node)
 	sendingsavegame[node] = false;
 	resendingsavegame[node] = false;
 	savegameresendcooldown[node] = 0;
+	NetSaveBaseFree(&netsavesent[node]);
+	NetSaveBaseFree(&netsaveacked[node]);
 
 	bannednode[node].banid = SIZE_MAX;
 	bannednode[node].timeleft = NO_BAN_TIME;
@@ -4799,6 +5146,67 @@ static void FuzzTiccmd(ticcmd_t* target)
 	}
 }
 
+#ifdef SIGNGAMETRAFFIC
+// Signed packets from players are held back until the end of GetPackets,
+// so their signatures can be checked together on the thread pool instead
+// of one at a time on the main thread. Once a node has a held packet,
+// everything after it from that node is held too, to keep the order.
+#define MAXHELDPACKETS 64
+
+typedef struct
+{
+	SINT8 node;
+	INT16 datalength;
+	doomdata_t *data; // datalength bytes, not a whole doomdata_t
+	boolean checked[MAXSPLITSCREENPLAYERS];
+	boolean failed[MAXSPLITSCREENPLAYERS];
+	uint8_t key[MAXSPLITSCREENPLAYERS][PUBKEYLENGTH];
+} heldpacket_t;
+
+typedef struct
+{
+	heldpacket_t *packet;
+	INT32 split;
+} heldsignature_t;
+
+static heldpacket_t heldpackets[MAXHELDPACKETS];
+static heldsignature_t heldsignatures[MAXHELDPACKETS * MAXSPLITSCREENPLAYERS];
+static INT32 numheldpackets = 0;
+static const heldpacket_t *currentheldpacket = NULL; // being handled right now
+
+static void VerifyHeldSignature(void *data)
+{
+	heldsignature_t *sig = data;
+	heldpacket_t *held = sig->packet;
+
+	held->failed[sig->split] = (crypto_eddsa_check(held->data->signature[sig->split],
+		held->key[sig->split], (const uint8_t *)&held->data->u, held->datalength - BASEPACKETSIZE) != 0);
+}
+
+// Returns true if the signature of split player in netbuffer is valid.
+// Uses the batched result when the packet was held and the player's key
+// has not changed since.
+static boolean CheckPacketSignature(int split, int targetplayer)
+{
+	precise_t starttime;
+	boolean ok;
+
+	if (currentheldpacket != NULL && currentheldpacket->checked[split]
+		&& !memcmp(currentheldpacket->key[split], players[targetplayer].public_key, PUBKEYLENGTH))
+	{
+		return !currentheldpacket->failed[split];
+	}
+
+	starttime = I_GetPreciseTime();
+	ok = (crypto_eddsa_check(netbuffer->signature[split], players[targetplayer].public_key,
+		(const uint8_t *)&netbuffer->u, doomcom->datalength - BASEPACKETSIZE) == 0);
+	ps_netverify_time += I_GetPreciseTime() - starttime;
+	ps_netverify_calls++;
+
+	return ok;
+}
+#endif
+
 /** Handles a packet received from a node that is in game
   *
   * \param node The packet sender
@@ -4811,7 +5219,7 @@ static void HandlePacketFromPlayer(SINT8 node)
 {
 	INT32 netconsole;
 	tic_t realend, realstart;
-	UINT8 *pak, *txtpak, numtxtpak;
+	UINT8 *txtpak, numtxtpak;
 #ifndef NOMD5
 	UINT8 finalmd5[16];/* Well, it's the cool thing to do? */
 #endif
@@ -4841,14 +5249,13 @@ static void HandlePacketFromPlayer(SINT8 node)
 				if (targetplayer == -1)
 					continue;
 
-				const void* message = &netbuffer->u;
 				if (IsSplitPlayerOnNodeGuest(node, splitnodes) || demo.playback)
 				{
 					//CONS_Printf("Throwing out a guest signature from node %d player %d\n", node, splitnodes);
 				}
 				else
 				{
-					if (crypto_eddsa_check(netbuffer->signature[splitnodes], players[targetplayer].public_key, message, doomcom->datalength - BASEPACKETSIZE))
+					if (!CheckPacketSignature(splitnodes, targetplayer))
 					{
 						CONS_Alert(CONS_ERROR, "SIGFAIL! Packet type %d from node %d player %d\nkey %s size %d netconsole %d\n",
 							netbuffer->packettype, node, splitnodes,
@@ -4978,10 +5385,13 @@ static void HandlePacketFromPlayer(SINT8 node)
 
 			// Check player consistancy during the level
 			if (realstart <= gametic && realstart + BACKUPTICS - 1 > gametic && gamestate == GS_LEVEL
-				&& consistancy[realstart%BACKUPTICS] != SHORT(netbuffer->u.clientpak.consistancy)
+				&& consistancy[realstart%BACKUPTICS] != (UINT32)LONG(netbuffer->u.clientpak.consistancy)
 				&& !resendingsavegame[node] && savegameresendcooldown[node] <= I_GetTime()
 				&& !SV_ResendingSavegameToAnyone())
 			{
+				const UINT32 theirs = LONG(netbuffer->u.clientpak.consistancy);
+				const char *diverged = ConsistancyMismatch(consistancy[realstart%BACKUPTICS], theirs);
+
 				if (cv_resynchattempts.value)
 				{
 					// Tell the client we are about to resend them the gamestate
@@ -4991,21 +5401,18 @@ static void HandlePacketFromPlayer(SINT8 node)
 					resendingsavegame[node] = true;
 
 					if (cv_blamecfail.value)
-						CONS_Printf(M_GetText("Synch failure for player %d (%s); expected %hd, got %hd\n"),
+						CONS_Printf(M_GetText("Synch failure for player %d (%s); expected %08x, got %08x (%s)\n"),
 							netconsole+1, player_names[netconsole],
-							consistancy[realstart%BACKUPTICS],
-							SHORT(netbuffer->u.clientpak.consistancy));
-					DEBFILE(va("Restoring player %d (synch failure) [%update] %d!=%d\n",
-						netconsole, realstart, consistancy[realstart%BACKUPTICS],
-						SHORT(netbuffer->u.clientpak.consistancy)));
+							consistancy[realstart%BACKUPTICS], theirs, diverged);
+					DEBFILE(va("Restoring player %d (synch failure) [%u] %08x!=%08x (%s)\n",
+						netconsole, realstart, consistancy[realstart%BACKUPTICS], theirs, diverged));
 					break;
 				}
 				else
 				{
 					SendKick(netconsole, KICK_MSG_CON_FAIL);
-					DEBFILE(va("player %d kicked (synch failure) [%u] %d!=%d\n",
-						netconsole, realstart, consistancy[realstart%BACKUPTICS],
-						SHORT(netbuffer->u.clientpak.consistancy)));
+					DEBFILE(va("player %d kicked (synch failure) [%u] %08x!=%08x (%s)\n",
+						netconsole, realstart, consistancy[realstart%BACKUPTICS], theirs, diverged));
 					break;
 				}
 			}
@@ -5080,7 +5487,7 @@ static void HandlePacketFromPlayer(SINT8 node)
 				// doomcom->numslots+1 "+1" since doomcom->numslots can change within this time and sent time
 				j = software_MAXPACKETLENGTH
 					- (incoming_size + 3 + BASESERVERTICSSIZE
-					+ (doomcom->numslots+1)*sizeof(ticcmd_t));
+					+ (doomcom->numslots+1)*MAXTICCMDDELTASIZE);
 
 				// search a tic that have enougth space in the ticcmd
 				while ((textcmd = D_GetExistingTextcmd(tic, netconsole)),
@@ -5198,6 +5605,15 @@ static void HandlePacketFromPlayer(SINT8 node)
 			sendingsavegame[node] = false;
 			resendingsavegame[node] = false;
 			savegameresendcooldown[node] = I_GetTime() + 5 * TICRATE;
+
+			// The node has loaded what we sent last; diff future resends against that.
+			if (netsavesent[node].buffer != NULL)
+			{
+				NetSaveBaseFree(&netsaveacked[node]);
+				netsaveacked[node] = netsavesent[node];
+				netsavesent[node].buffer = NULL;
+				netsavesent[node].length = 0;
+			}
 			break;
 // -------------------------------------------- CLIENT RECEIVE ----------
 		case PT_SERVERTICS:
@@ -5213,18 +5629,15 @@ static void HandlePacketFromPlayer(SINT8 node)
 			realstart = ExpandTics(netbuffer->u.serverpak.starttic, maketic);
 			realend = realstart + netbuffer->u.serverpak.numtics;
 
-			if (!txtpak)
-				txtpak = (UINT8 *)&netbuffer->u.serverpak.cmds[netbuffer->u.serverpak.numslots
-					* netbuffer->u.serverpak.numtics];
-
 			if (realend > gametic + CLIENTBACKUPTICS)
 				realend = gametic + CLIENTBACKUPTICS;
 			cl_packetmissed = realstart > neededtic;
 
 			if (realstart <= neededtic && realend > neededtic)
 			{
+				static const ticcmd_t emptycmd;
 				tic_t i, j;
-				pak = (UINT8 *)&netbuffer->u.serverpak.cmds;
+				txtpak = (UINT8 *)&netbuffer->u.serverpak.cmds;
 
 				for (i = realstart; i < realend; i++)
 				{
@@ -5232,8 +5645,11 @@ static void HandlePacketFromPlayer(SINT8 node)
 					D_Clearticcmd(i);
 
 					// copy the tics
-					pak = G_ScpyTiccmd(netcmds[i%BACKUPTICS], pak,
-						netbuffer->u.serverpak.numslots*sizeof (ticcmd_t));
+					for (j = 0; j < netbuffer->u.serverpak.numslots; j++)
+					{
+						const ticcmd_t *base = (i > realstart) ? &netcmds[(i-1)%BACKUPTICS][j] : &emptycmd;
+						txtpak = CL_ReadTiccmdDelta(&netcmds[i%BACKUPTICS][j], txtpak, base);
+					}
 
 					// copy the textcmds
 					numtxtpak = *txtpak++;
@@ -5462,6 +5878,109 @@ static void HandlePacketFromPlayer(SINT8 node)
   * \todo Add details to this description (lol)
   *
   */
+#ifdef SIGNGAMETRAFFIC
+static boolean IsNodeHeld(SINT8 node)
+{
+	INT32 i;
+
+	for (i = 0; i < numheldpackets; i++)
+	{
+		if (heldpackets[i].node == node)
+			return true;
+	}
+
+	return false;
+}
+
+static void HoldPacket(SINT8 node)
+{
+	heldpacket_t *held = &heldpackets[numheldpackets++];
+	INT32 split;
+
+	held->node = node;
+	held->datalength = doomcom->datalength;
+	held->data = Z_Malloc(doomcom->datalength, PU_STATIC, NULL);
+	M_Memcpy(held->data, netbuffer, doomcom->datalength);
+
+	for (split = 0; split < MAXSPLITSCREENPLAYERS; split++)
+	{
+		int targetplayer = NodeToSplitPlayer(node, split);
+
+		held->failed[split] = false;
+		held->checked[split] = (IsPacketSigned(netbuffer->packettype)
+			&& targetplayer != -1
+			&& !IsSplitPlayerOnNodeGuest(node, split)
+			&& !demo.playback);
+
+		if (held->checked[split])
+			M_Memcpy(held->key[split], players[targetplayer].public_key, PUBKEYLENGTH);
+	}
+}
+
+// Checks every held signature in one batch, then handles the held
+// packets in the order they arrived.
+static void FlushHeldPackets(void)
+{
+	precise_t starttime = I_GetPreciseTime();
+	INT32 numsignatures = 0;
+	INT32 i, split;
+
+	for (i = 0; i < numheldpackets; i++)
+	{
+		for (split = 0; split < MAXSPLITSCREENPLAYERS; split++)
+		{
+			if (!heldpackets[i].checked[split])
+				continue;
+
+			heldsignatures[numsignatures].packet = &heldpackets[i];
+			heldsignatures[numsignatures].split = split;
+			numsignatures++;
+		}
+	}
+
+#ifdef HAVE_THREADS
+	if (numsignatures > 1)
+	{
+		srb2ctaskgroup_t *group = I_ThreadPoolNewGroup();
+
+		for (i = 0; i < numsignatures; i++)
+			I_ThreadPoolSubmitGroup(group, VerifyHeldSignature, &heldsignatures[i]);
+
+		I_ThreadPoolWaitGroup(group);
+	}
+	else
+#endif
+	{
+		for (i = 0; i < numsignatures; i++)
+			VerifyHeldSignature(&heldsignatures[i]);
+	}
+
+	ps_netverify_time += I_GetPreciseTime() - starttime;
+	ps_netverify_calls += numsignatures;
+
+	for (i = 0; i < numheldpackets; i++)
+	{
+		heldpacket_t *held = &heldpackets[i];
+
+		M_Memcpy(netbuffer, held->data, held->datalength);
+		doomcom->datalength = held->datalength;
+		doomcom->remotenode = held->node;
+
+		currentheldpacket = held;
+		if (nodeingame[held->node])
+			HandlePacketFromPlayer(held->node);
+		else
+			HandlePacketFromAwayNode(held->node);
+		currentheldpacket = NULL;
+
+		Z_Free(held->data);
+		held->data = NULL;
+	}
+
+	numheldpackets = 0;
+}
+#endif
+
 static void GetPackets(void)
 {
 	SINT8 node; // The packet sender
@@ -5503,6 +6022,16 @@ static void GetPackets(void)
 		if (netbuffer->packettype == PT_PLAYERINFO)
 			continue; // We do nothing with PLAYERINFO, that's for the MS browser.
 
+#ifdef SIGNGAMETRAFFIC
+		if (server && nodeingame[node] && (IsPacketSigned(netbuffer->packettype) || IsNodeHeld(node)))
+		{
+			HoldPacket(node);
+			if (numheldpackets == MAXHELDPACKETS)
+				FlushHeldPackets();
+			continue;
+		}
+#endif
+
 		// Packet received from someone already playing
 		if (nodeingame[node])
 			HandlePacketFromPlayer(node);
@@ -5510,6 +6039,11 @@ static void GetPackets(void)
 		else
 			HandlePacketFromAwayNode(node);
 	}
+
+#ifdef SIGNGAMETRAFFIC
+	if (numheldpackets > 0)
+		FlushHeldPackets();
+#endif
 }
 
 //
@@ -5520,166 +6054,34 @@ static void GetPackets(void)
 // no more use random generator, because at very first tic isn't yet synchronized
 // Note: It is called consistAncy on purpose.
 //
-static INT16 Consistancy(void)
+static UINT32 Consistancy(void)
 {
-	INT32 i;
-	UINT32 ret = 0;
-#ifdef MOBJCONSISTANCY
-	thinker_t *th;
-	mobj_t *mo;
-#endif
+	UINT32 ret = P_SyncHashConsistancy();
 
-	DEBFILE(va("TIC %u ", gametic));
+	DEBFILE(va("TIC %u Consistancy = %08x\n", gametic, ret));
 
-	for (i = 0; i < MAXPLAYERS; i++)
-	{
-		if (!playeringame[i])
-			ret ^= 0xCCCC;
-		else if (!players[i].mo || gamestate != GS_LEVEL);
-		else
-		{
-			ret += players[i].mo->x;
-			ret -= players[i].mo->y;
-			ret += players[i].itemtype;
-			ret *= i+1;
-		}
-	}
-	// I give up
-	// Coop desynching enemies is painful
-	if (gamestate == GS_LEVEL)
-	{
-		for (i = 0; i < PRNUMSYNCED; i++)
-		{
-			if (i & 1)
-			{
-				ret -= P_GetRandSeed(i);
-			}
-			else
-			{
-				ret += P_GetRandSeed(i);
-			}
-		}
-	}
-
-#ifdef MOBJCONSISTANCY
-	if (gamestate == GS_LEVEL)
-	{
-		for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
-		{
-			if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
-				continue;
+	return ret;
+}
 
-			mo = (mobj_t *)th;
+// Names the subsystems whose byte differs between two consistancy values
+static const char *ConsistancyMismatch(UINT32 a, UINT32 b)
+{
+	static char buf[64];
+	INT32 i;
 
-			if (TypeIsNetSynced(mo->type) == false)
-				continue;
+	buf[0] = '\0';
 
-			if (mo->flags & (MF_SPECIAL | MF_SOLID | MF_PUSHABLE | MF_BOSS | MF_MISSILE | MF_SPRING | MF_ELEMENTAL | MF_FIRE | MF_ENEMY | MF_PAIN | MF_DONTPUNT))
-			{
-				ret -= mo->type;
-				ret += mo->x;
-				ret -= mo->y;
-				ret += mo->z;
-				ret -= mo->momx;
-				ret += mo->momy;
-				ret -= mo->momz;
-				ret += mo->angle;
-				ret -= mo->flags;
-				ret += mo->flags2;
-				ret -= mo->eflags;
-				if (mo->target && TypeIsNetSynced(mo->target->type))
-				{
-					ret += mo->target->type;
-					ret -= mo->target->x;
-					ret += mo->target->y;
-					ret -= mo->target->z;
-					ret += mo->target->momx;
-					ret -= mo->target->momy;
-					ret += mo->target->momz;
-					ret -= mo->target->angle;
-					ret += mo->target->flags;
-					ret -= mo->target->flags2;
-					ret += mo->target->eflags;
-					ret -= mo->target->state - states;
-					ret += mo->target->tics;
-					ret -= mo->target->sprite;
-					//ret += mo->target->frame;
-				}
-				else
-					ret ^= 0x3333;
-				if (mo->tracer && TypeIsNetSynced(mo->tracer->type))
-				{
-					ret += mo->tracer->type;
-					ret -= mo->tracer->x;
-					ret += mo->tracer->y;
-					ret -= mo->tracer->z;
-					ret += mo->tracer->momx;
-					ret -= mo->tracer->momy;
-					ret += mo->tracer->momz;
-					ret -= mo->tracer->angle;
-					ret += mo->tracer->flags;
-					ret -= mo->tracer->flags2;
-					ret += mo->tracer->eflags;
-					ret -= mo->tracer->state - states;
-					ret += mo->tracer->tics;
-					ret -= mo->tracer->sprite;
-					//ret += mo->tracer->frame;
-				}
-				else
-					ret ^= 0xAAAA;
-				// SRB2Kart: We use hnext & hprev very extensively
-				if (mo->hnext && TypeIsNetSynced(mo->hnext->type))
-				{
-					ret += mo->hnext->type;
-					ret -= mo->hnext->x;
-					ret += mo->hnext->y;
-					ret -= mo->hnext->z;
-					ret += mo->hnext->momx;
-					ret -= mo->hnext->momy;
-					ret += mo->hnext->momz;
-					ret -= mo->hnext->angle;
-					ret += mo->hnext->flags;
-					ret -= mo->hnext->flags2;
-					ret += mo->hnext->eflags;
-					ret -= mo->hnext->state - states;
-					ret += mo->hnext->tics;
-					ret -= mo->hnext->sprite;
-					//ret += mo->hnext->frame;
-				}
-				else
-					ret ^= 0x5555;
-				if (mo->hprev && TypeIsNetSynced(mo->hprev->type))
-				{
-					ret += mo->hprev->type;
-					ret -= mo->hprev->x;
-					ret += mo->hprev->y;
-					ret -= mo->hprev->z;
-					ret += mo->hprev->momx;
-					ret -= mo->hprev->momy;
-					ret += mo->hprev->momz;
-					ret -= mo->hprev->angle;
-					ret += mo->hprev->flags;
-					ret -= mo->hprev->flags2;
-					ret += mo->hprev->eflags;
-					ret -= mo->hprev->state - states;
-					ret += mo->hprev->tics;
-					ret -= mo->hprev->sprite;
-					//ret += mo->hprev->frame;
-				}
-				else
-					ret ^= 0xCCCC;
-				ret -= mo->state - states;
-				ret += mo->tics;
-				ret -= mo->sprite;
-				//ret += mo->frame;
-			}
+	for (i = 0; i < NUMSYNCSUBSYSTEMS; i++)
+	{
+		if (((a ^ b) >> (i * 8)) & 0xFF)
+		{
+			if (buf[0] != '\0')
+				strlcat(buf, ", ", sizeof buf);
+			strlcat(buf, syncsubsystemnames[i], sizeof buf);
 		}
 	}
-#endif
-
-	DEBFILE(va("Consistancy = %u\n", (ret & 0xFFFF)));
 
-	return (INT16)(ret & 0xFFFF);
+	return buf;
 }
 
 // confusing, but this DOESN'T send PT_NODEKEEPALIVE, it sends PT_BASICKEEPALIVE
@@ -5726,7 +6128,7 @@ static void CL_SendClientCmd(void)
 	{
 		// Send PT_NODEKEEPALIVE packet
 		netbuffer->packettype = (mis ? PT_NODEKEEPALIVEMIS : PT_NODEKEEPALIVE);
-		packetsize = sizeof (clientcmd_pak) - sizeof (ticcmd_t) - sizeof (INT16);
+		packetsize = sizeof (clientcmd_pak) - sizeof (ticcmd_t) - sizeof (UINT32);
 		HSendPacket(servernode, false, 0, packetsize);
 	}
 	else if (gamestate != GS_NULL && (addedtogame || dedicated))
@@ -5785,7 +6187,7 @@ static void CL_SendClientCmd(void)
 
 		packetsize = sizeof (clientcmd_pak);
 		G_MoveTiccmd(&netbuffer->u.clientpak.cmd, &localcmds[0][lagDelay], 1);
-		netbuffer->u.clientpak.consistancy = SHORT(consistancy[gametic % BACKUPTICS]);
+		netbuffer->u.clientpak.consistancy = LONG(consistancy[gametic % BACKUPTICS]);
 
 		if (splitscreen) // Send a special packet with 2 cmd for splitscreen
 		{
@@ -5885,54 +6287,59 @@ static void SV_SendTics(void)
 			if (realfirsttic < firstticstosend)
 				realfirsttic = firstticstosend;
 
-			// compute the length of the packet and cut it if too large
+			netbuffer->packettype = PT_SERVERTICS;
+			netbuffer->u.serverpak.starttic = (UINT8)realfirsttic;
+			netbuffer->u.serverpak.numslots = (UINT8)SHORT(doomcom->numslots);
+			bufpos = (UINT8 *)&netbuffer->u.serverpak.cmds;
+
+			// write the tics, cutting the packet if it gets too large
 			packsize = BASESERVERTICSSIZE;
 			for (i = realfirsttic; i < lasttictosend; i++)
 			{
-				packsize += sizeof (ticcmd_t) * doomcom->numslots;
-				packsize += TotalTextCmdPerTic(i);
+				static const ticcmd_t emptycmd;
+				UINT8 cmdbuf[MAXPLAYERS * MAXTICCMDDELTASIZE];
+				UINT8 *cmdpos = cmdbuf;
+				size_t ticsize;
+
+				for (j = 0; j < doomcom->numslots; j++)
+				{
+					const ticcmd_t *base = (i > realfirsttic) ? &netcmds[(i-1)%BACKUPTICS][j] : &emptycmd;
+					cmdpos = SV_WriteTiccmdDelta(cmdpos, &netcmds[i%BACKUPTICS][j], base);
+				}
+
+				ticsize = (cmdpos - cmdbuf) + TotalTextCmdPerTic(i);
 
-				if (packsize > software_MAXPACKETLENGTH)
+				if (packsize + ticsize > software_MAXPACKETLENGTH)
 				{
 					DEBFILE(va("packet too large (%s) at tic %d (should be from %d to %d)\n",
-						sizeu1(packsize), i, realfirsttic, lasttictosend));
-					lasttictosend = i;
+						sizeu1(packsize + ticsize), i, realfirsttic, lasttictosend));
+
+					if (i > realfirsttic)
+					{
+						lasttictosend = i;
+						break;
+					}
 
 					// too bad: too much player have send extradata and there is too
 					//          much data in one tic.
 					// To avoid it put the data on the next tic. (see getpacket
 					// textcmd case) but when numplayer changes the computation can be different
-					if (lasttictosend == realfirsttic)
-					{
-						if (packsize > MAXPACKETLENGTH)
-							I_Error("Too many players: can't send %s data for %d players to node %d\n"
-							        "Well sorry nobody is perfect....\n",
-							        sizeu1(packsize), doomcom->numslots, n);
-						else
-						{
-							lasttictosend++; // send it anyway!
-							DEBFILE("sending it anyway\n");
-						}
-					}
-					break;
+					if (packsize + ticsize > MAXPACKETLENGTH)
+						I_Error("Too many players: can't send %s data for %d players to node %d\n"
+						        "Well sorry nobody is perfect....\n",
+						        sizeu1(packsize + ticsize), doomcom->numslots, n);
+
+					lasttictosend = i + 1; // send it anyway!
+					DEBFILE("sending it anyway\n");
 				}
-			}
 
-			// Send the tics
-			netbuffer->packettype = PT_SERVERTICS;
-			netbuffer->u.serverpak.starttic = (UINT8)realfirsttic;
-			netbuffer->u.serverpak.numtics = (UINT8)(lasttictosend - realfirsttic);
-			netbuffer->u.serverpak.numslots = (UINT8)SHORT(doomcom->numslots);
-			bufpos = (UINT8 *)&netbuffer->u.serverpak.cmds;
+				packsize += ticsize;
+				ticcmdbytes += cmdpos - cmdbuf;
+				ticcmdrawbytes += doomcom->numslots * sizeof (ticcmd_t);
 
-			for (i = realfirsttic; i < lasttictosend; i++)
-			{
-				bufpos = G_DcpyTiccmd(bufpos, netcmds[i%BACKUPTICS], doomcom->numslots * sizeof (ticcmd_t));
-			}
+				WRITEMEM(bufpos, cmdbuf, cmdpos - cmdbuf);
 
-			// add textcmds
-			for (i = realfirsttic; i < lasttictosend; i++)
-			{
+				// add textcmds
 				ntextcmd = bufpos++;
 				*ntextcmd = 0;
 				for (j = 0; j < MAXPLAYERS; j++)
@@ -5949,6 +6356,8 @@ static void SV_SendTics(void)
 					}
 				}
 			}
+
+			netbuffer->u.serverpak.numtics = (UINT8)(lasttictosend - realfirsttic);
 			packsize = bufpos - (UINT8 *)&(netbuffer->u);
 
 			HSendPacket(n, false, 0, packsize);
@@ -6631,6 +7040,10 @@ void NetUpdate(void)
 		}
 	}
 
+	ps_netsign_time = 0;
+	ps_netverify_time = 0;
+	ps_netverify_calls = 0;
+
 #ifdef DEDICATEDIDLETIME
 	if (server && dedicated && gamestate == GS_LEVEL)
 	{
@@ -6825,8 +7238,12 @@ tic_t GetLag(INT32 node)
 	return gametic - nettics[node];
 }
 
-#define REWIND_POINT_INTERVAL 4*TICRATE + 16
-rewind_t *rewindhead;
+// Keyframes are taken while a replay plays, so any tic that has been
+// reached once can be returned to by loading the closest keyframe and
+// simulating at most this many tics.
+#define REWIND_POINT_INTERVAL (2*TICRATE)
+rewind_t *rewindhead; // Newest first
+static UINT8 *rewindscratch; // Uncompressed netsave being saved or loaded
 
 void CL_ClearRewinds(void)
 {
@@ -6834,55 +7251,91 @@ void CL_ClearRewinds(void)
 	while ((head = rewindhead))
 	{
 		rewindhead = rewindhead->next;
+		free(head->savebuffer);
 		free(head);
 	}
 }
 
+rewind_t *CL_FindRewindPoint(tic_t time)
+{
+	rewind_t *rewind = rewindhead;
+
+	while (rewind && rewind->leveltime > time)
+		rewind = rewind->next;
+
+	return rewind;
+}
+
 rewind_t *CL_SaveRewindPoint(size_t demopos)
 {
 	savebuffer_t save = {0};
+	rewind_t **link = &rewindhead;
+	rewind_t *newer = NULL;
 	rewind_t *rewind;
+	uLongf compressedlen;
 
-	if (rewindhead && rewindhead->leveltime + REWIND_POINT_INTERVAL > leveltime)
+	while (*link && (*link)->leveltime > leveltime)
+	{
+		newer = *link;
+		link = &(*link)->next;
+	}
+
+	// Seeking back replays tics that already have keyframes nearby.
+	if (*link && (*link)->leveltime + REWIND_POINT_INTERVAL > leveltime)
+		return NULL;
+	if (newer && newer->leveltime < leveltime + REWIND_POINT_INTERVAL)
+		return NULL;
+
+	if (!rewindscratch && !(rewindscratch = (UINT8 *)malloc(NETSAVEGAMESIZE)))
 		return NULL;
 
 	rewind = (rewind_t *)malloc(sizeof (rewind_t));
 	if (!rewind)
 		return NULL;
 
-	P_SaveBufferFromExisting(&save, rewind->savebuffer, NETSAVEGAMESIZE);
+	P_SaveBufferFromExisting(&save, rewindscratch, NETSAVEGAMESIZE);
 	P_SaveNetGame(&save, false);
 
+	rewind->rawlength = save.p - save.buffer;
+	if (rewind->rawlength > NETSAVEGAMESIZE)
+		I_Error("Savegame buffer overrun");
+
+	compressedlen = compressBound(rewind->rawlength);
+	rewind->savebuffer = (UINT8 *)malloc(compressedlen);
+	if (!rewind->savebuffer
+		|| compress2(rewind->savebuffer, &compressedlen, rewindscratch, rewind->rawlength, Z_BEST_SPEED) != Z_OK)
+	{
+		free(rewind->savebuffer);
+		free(rewind);
+		return NULL;
+	}
+	rewind->savelength = compressedlen;
+
 	rewind->leveltime = leveltime;
-	rewind->next = rewindhead;
 	rewind->demopos = demopos;
-	rewindhead = rewind;
+	rewind->next = *link;
+	*link = rewind;
 
 	return rewind;
 }
 
-rewind_t *CL_RewindToTime(tic_t time)
+boolean CL_LoadRewindPoint(const rewind_t *rewind)
 {
 	savebuffer_t save = {0};
-	rewind_t *rewind;
-
-	while (rewindhead && rewindhead->leveltime > time)
-	{
-		rewind = rewindhead->next;
-		free(rewindhead);
-		rewindhead = rewind;
-	}
+	uLongf rawlength = rewind->rawlength;
 
-	if (!rewindhead)
-		return NULL;
+	if (uncompress(rewindscratch, &rawlength, rewind->savebuffer, rewind->savelength) != Z_OK
+		|| rawlength != rewind->rawlength)
+		return false;
 
-	P_SaveBufferFromExisting(&save, rewindhead->savebuffer, NETSAVEGAMESIZE);
-	P_LoadNetGame(&save, false);
+	P_SaveBufferFromExisting(&save, rewindscratch, rawlength);
+	if (!P_LoadNetGame(&save, false))
+		return false;
 
 	wipegamestate = gamestate; // No fading back in!
 	timeinmap = leveltime;
 
-	return rewindhead;
+	return true;
 }
 
 void D_MD5PasswordPass(const UINT8 *buffer, size_t len, const char *salt, void *dest)
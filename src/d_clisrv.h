@@ -34,7 +34,7 @@ The 'packet version' is used to distinguish packet formats.
 This version is independent of VERSION and SUBVERSION. Different
 applications may follow different packet versions.
 */
-#define PACKETVERSION 0
+#define PACKETVERSION 3
 
 // Network play related stuff.
 // There is a data struct that stores network
@@ -160,7 +160,7 @@ struct clientcmd_pak
 {
 	UINT8 client_tic;
 	UINT8 resendfrom;
-	INT16 consistancy;
+	UINT32 consistancy; // one byte per subsystem, see p_synchash.h
 	ticcmd_t cmd;
 } ATTRPACK;
 
@@ -170,7 +170,7 @@ struct client2cmd_pak
 {
 	UINT8 client_tic;
 	UINT8 resendfrom;
-	INT16 consistancy;
+	UINT32 consistancy;
 	ticcmd_t cmd, cmd2;
 } ATTRPACK;
 
@@ -180,7 +180,7 @@ struct client3cmd_pak
 {
 	UINT8 client_tic;
 	UINT8 resendfrom;
-	INT16 consistancy;
+	UINT32 consistancy;
 	ticcmd_t cmd, cmd2, cmd3;
 } ATTRPACK;
 
@@ -190,7 +190,7 @@ struct client4cmd_pak
 {
 	UINT8 client_tic;
 	UINT8 resendfrom;
-	INT16 consistancy;
+	UINT32 consistancy;
 	ticcmd_t cmd, cmd2, cmd3, cmd4;
 } ATTRPACK;
 
@@ -205,7 +205,10 @@ struct servertics_pak
 	UINT8 starttic;
 	UINT8 numtics;
 	UINT8 numslots; // "Slots filled": Highest player number in use plus one.
-	ticcmd_t cmds[45]; // Normally [BACKUPTIC][MAXPLAYERS] but too large
+	// For each tic: numslots ticcmds, each delta coded against the same
+	// slot in the previous tic of this packet (the first tic against an
+	// empty ticcmd), followed by the tic's textcmds.
+	UINT8 cmds[45*sizeof (ticcmd_t)];
 } ATTRPACK;
 
 struct serverconfig_pak
@@ -485,6 +488,7 @@ extern consvar_t cv_playbackspeed;
 #define BASEPACKETSIZE      offsetof(doomdata_t, u)
 #define FILETXHEADER        offsetof(filetx_pak, data)
 #define BASESERVERTICSSIZE  offsetof(doomdata_t, u.serverpak.cmds[0])
+#define MAXTICCMDDELTASIZE  19 // see SV_WriteTiccmdDelta
 
 typedef enum
 {
@@ -679,20 +683,24 @@ extern boolean hu_stopped;
 // SRB2Kart
 //
 
+// Replay keyframe: a compressed netsave plus the demo reader state at that tic
 struct rewind_t {
-	UINT8 savebuffer[NETSAVEGAMESIZE];
+	UINT8 *savebuffer;
+	size_t savelength; // compressed
+	size_t rawlength;
 	tic_t leveltime;
 	size_t demopos;
 
 	ticcmd_t oldcmd[MAXPLAYERS];
 	mobj_t oldghost[MAXPLAYERS];
 
-	rewind_t *next;
+	rewind_t *next; // older keyframe
 };
 
 void CL_ClearRewinds(void);
 rewind_t *CL_SaveRewindPoint(size_t demopos);
-rewind_t *CL_RewindToTime(tic_t time);
+rewind_t *CL_FindRewindPoint(tic_t time);
+boolean CL_LoadRewindPoint(const rewind_t *rewind);
 
 void HandleSigfail(const char *string);
 
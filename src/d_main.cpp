@@ -802,6 +802,11 @@ static bool D_Display(bool world)
 
 			s[sizeof s - 1] = '\0';
 
+			if (server)
+			{
+				snprintf(s, sizeof s - 1, "tics %d b/s (%.0f%%)", ticcmdbps, ticcmdpercent);
+				V_DrawRightAlignedString(BASEVIDWIDTH, BASEVIDHEIGHT-ST_HEIGHT-50, V_YELLOWMAP, s);
+			}
 			snprintf(s, sizeof s - 1, "get %d b/s", getbps);
 			V_DrawRightAlignedString(BASEVIDWIDTH, BASEVIDHEIGHT-ST_HEIGHT-40, V_YELLOWMAP, s);
 			snprintf(s, sizeof s - 1, "send %d b/s", sendbps);
@@ -2027,7 +2032,18 @@ void D_SRB2Main(void)
 			G_DeferedPlayDemo(tmp);
 		}
 		else
+		{
+			strlcpy(timedemo_name, tmp, sizeof(timedemo_name));
+			timedemo_quit = M_CheckParm("-quit");
+			timedemo_csv_id[0] = 0;
+			timedemo_csv = M_CheckParm("-csv");
+			if (timedemo_csv && M_IsNextParm())
+				strlcpy(timedemo_csv_id, M_GetNextParm(), sizeof(timedemo_csv_id));
+			timedemo_json = M_CheckParm("-json");
+			if (timedemo_json && M_IsNextParm())
+				strlcpy(timedemo_csv_id, M_GetNextParm(), sizeof(timedemo_csv_id));
 			G_TimeDemo(tmp);
+		}
 
 		G_SetGamestate(GS_NULL);
 		wipegamestate = GS_NULL;
@@ -33,6 +33,7 @@
 #include "stun.h"
 #include "byteptr.h"
 #include "monocypher/monocypher.h"
+#include "m_perfstats.h"
 
 //
 // NETWORKING
@@ -101,6 +102,9 @@ boolean packetloss[MAXPLAYERS][PACKETMEASUREWINDOW];
 // globals
 INT32 getbps, sendbps;
 float lostpercent, duppercent, gamelostpercent;
+INT32 ticcmdbytes, ticcmdrawbytes; // PT_SERVERTICS ticcmds, as sent and as they would be uncompressed
+INT32 ticcmdbps;
+float ticcmdpercent;
 INT32 packetheaderlength;
 
 boolean Net_GetNetStat(void)
@@ -125,10 +129,16 @@ boolean Net_GetNetStat(void)
 			gamelostpercent = 100.0f*(float)ticmiss/(float)ticruned;
 		else
 			gamelostpercent = 0.0f;
+		ticcmdbps = (ticcmdbytes*TICRATE)/df;
+		if (ticcmdrawbytes)
+			ticcmdpercent = 100.0f*(float)ticcmdbytes/(float)ticcmdrawbytes;
+		else
+			ticcmdpercent = 0.0f;
 
 		ticmiss = ticruned = 0;
 		oldsendbyte = sendbytes;
 		getbytes = 0;
+		ticcmdbytes = ticcmdrawbytes = 0;
 		sendackpacket = getackpacket = duppacket = retransmit = 0;
 		statstarttic = t;
 
@@ -844,20 +854,13 @@ static void DebugPrintpacket(const char *header)
 		case PT_SERVERTICS:
 		{
 			servertics_pak *serverpak = &netbuffer->u.serverpak;
-			UINT8 *cmd = (UINT8 *)(&serverpak->cmds[serverpak->numslots * serverpak->numtics]);
-			size_t ntxtcmd = &((UINT8 *)netbuffer)[doomcom->datalength] - cmd;
-
-			fprintf(debugfile, "    firsttic %u ply %d tics %d ntxtcmd %s\n",
-				(UINT32)serverpak->starttic, serverpak->numslots, serverpak->numtics, sizeu1(ntxtcmd));
-			/// \todo Display more readable information about net commands
-			fprintfstringnewline((char *)cmd, ntxtcmd);
-			/*fprintfstring((char *)cmd, 3);
-			if (ntxtcmd > 4)
-			{
-				fprintf(debugfile, "[%s]", netxcmdnames[*((cmd) + 3) - 1]);
-				fprintfstring(((char *)cmd) + 4, ntxtcmd - 4);
-			}
-			fprintf(debugfile, "\n");*/
+			UINT8 *cmd = (UINT8 *)serverpak->cmds;
+			size_t payload = &((UINT8 *)netbuffer)[doomcom->datalength] - cmd;
+
+			// ticcmds are delta coded and interleaved with the textcmds,
+			// so there is nothing readable to print without decoding them.
+			fprintf(debugfile, "    firsttic %u ply %d tics %d payload %s\n",
+				(UINT32)serverpak->starttic, serverpak->numslots, serverpak->numtics, sizeu1(payload));
 			break;
 		}
 		case PT_CLIENTCMD:
@@ -1043,6 +1046,64 @@ static boolean ShouldDropPacket(void)
 	}
 #endif
 
+#ifdef SIGNGAMETRAFFIC
+// The signatures of the last signed message, reused as long as the
+// payload and the local players' keys stay the same.
+static struct
+{
+	UINT8 packettype;
+	UINT8 *message;
+	size_t length, capacity;
+	uint8_t key[MAXSPLITSCREENPLAYERS][PUBKEYLENGTH];
+	uint8_t signature[MAXSPLITSCREENPLAYERS][SIGNATURELENGTH];
+} lastsigned;
+
+static void SignPacket(size_t packetlength)
+{
+	const void *message = &netbuffer->u;
+	uint8_t key[MAXSPLITSCREENPLAYERS][PUBKEYLENGTH];
+	precise_t starttime = I_GetPreciseTime();
+	INT32 i;
+
+	// Only the players on this machine sign, the server never
+	// looks at the other slots.
+	memset(key, 0, sizeof(key));
+	for (i = 0; i <= splitscreen; i++)
+	{
+		if (!PR_IsLocalPlayerGuest(i))
+			M_Memcpy(key[i], PR_GetLocalPlayerProfile(i)->public_key, PUBKEYLENGTH);
+	}
+
+	if (lastsigned.message == NULL
+		|| lastsigned.packettype != netbuffer->packettype
+		|| lastsigned.length != packetlength
+		|| memcmp(lastsigned.key, key, sizeof(key))
+		|| memcmp(lastsigned.message, message, packetlength))
+	{
+		memset(lastsigned.signature, 0, sizeof(lastsigned.signature));
+		for (i = 0; i <= splitscreen; i++)
+		{
+			if (!PR_IsLocalPlayerGuest(i))
+				crypto_eddsa_sign(lastsigned.signature[i], PR_GetLocalPlayerProfile(i)->secret_key, message, packetlength);
+		}
+
+		if (packetlength > lastsigned.capacity || lastsigned.message == NULL)
+		{
+			lastsigned.capacity = max(packetlength, 1);
+			lastsigned.message = Z_Realloc(lastsigned.message, lastsigned.capacity, PU_STATIC, NULL);
+		}
+
+		M_Memcpy(lastsigned.message, message, packetlength);
+		M_Memcpy(lastsigned.key, key, sizeof(key));
+		lastsigned.packettype = netbuffer->packettype;
+		lastsigned.length = packetlength;
+	}
+
+	M_Memcpy(netbuffer->signature, lastsigned.signature, sizeof(netbuffer->signature));
+	ps_netsign_time += I_GetPreciseTime() - starttime;
+}
+#endif
+
 //
 // HSendPacket
 //
@@ -1051,19 +1112,14 @@ boolean HSendPacket(INT32 node, boolean reliable, UINT8 acknum, size_t packetlen
 	doomcom->datalength = (INT16)(packetlength + BASEPACKETSIZE);
 
 #ifdef SIGNGAMETRAFFIC
-	if (IsPacketSigned(netbuffer->packettype))
-	{	
-		int i;
-
-		for (i = 0; i < MAXSPLITSCREENPLAYERS; i++)
-		{
-			const void* message = &netbuffer->u;
-			//CONS_Printf("Signing packet type %d of length %d\n", netbuffer->packettype, packetlength);
-			if (PR_IsLocalPlayerGuest(i))	
-				memset(netbuffer->signature[i], 0, sizeof(netbuffer->signature[i]));
-			else
-				crypto_eddsa_sign(netbuffer->signature[i], PR_GetLocalPlayerProfile(i)->secret_key, message, packetlength);
-		}
+	if (acknum != 0)
+	{
+		// Resent from the ack buffer, which kept the original signatures.
+	}
+	else if (IsPacketSigned(netbuffer->packettype))
+	{
+		//CONS_Printf("Signing packet type %d of length %d\n", netbuffer->packettype, packetlength);
+		SignPacket(packetlength);
 
 		#ifdef DEVELOP
 			if (cv_badtraffic.value)
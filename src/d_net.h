@@ -38,10 +38,13 @@ extern "C" {
 extern INT32 ticruned, ticmiss;
 extern INT32 getbps, sendbps;
 extern float lostpercent, duppercent, gamelostpercent;
+extern INT32 ticcmdbps;
+extern float ticcmdpercent;
 extern INT32 packetheaderlength;
 boolean Net_GetNetStat(void);
 extern INT32 getbytes;
 extern INT64 sendbytes; // Realtime updated
+extern INT32 ticcmdbytes, ticcmdrawbytes; // Realtime updated
 
 #define PACKETMEASUREWINDOW (TICRATE*2)
 extern boolean packetloss[MAXPLAYERS][PACKETMEASUREWINDOW];
@@ -19,6 +19,7 @@
 #include "command.h"
 #include "i_time.h"
 #include "i_system.h"
+#include "i_video.h"
 #include "g_game.h"
 #include "hu_stuff.h"
 #include "g_input.h"
@@ -72,6 +73,7 @@
 #include "k_roulette.h"
 #include "k_bans.h"
 #include "k_director.h"
+#include "k_waypoint.h"
 #include "k_credits.h"
 
 #ifdef SRB2_CONFIG_ENABLE_WEBM_MOVIES
@@ -181,6 +183,8 @@ static void Command_Isgamemodified_f(void);
 #ifdef _DEBUG
 static void Command_Togglemodified_f(void);
 static void Command_Archivetest_f(void);
+static void Command_Pathfindbench_f(void);
+static void Command_Simddrawtest_f(void);
 #endif
 
 static void Command_KartGiveItem_f(void);
@@ -247,6 +251,7 @@ CV_PossibleValue_t perfstats_cons_t[] = {
 char timedemo_name[256];
 boolean timedemo_csv;
 char timedemo_csv_id[256];
+boolean timedemo_json;
 boolean timedemo_quit;
 
 INT16 gametype = GT_RACE;
@@ -428,6 +433,8 @@ void D_RegisterServerCommands(void)
 #ifdef _DEBUG
 	COM_AddDebugCommand("togglemodified", Command_Togglemodified_f);
 	COM_AddDebugCommand("archivetest", Command_Archivetest_f);
+	COM_AddDebugCommand("pathfindbench", Command_Pathfindbench_f);
+	COM_AddDebugCommand("simddrawtest", Command_Simddrawtest_f);
 #endif
 
 	COM_AddDebugCommand("downloads", Command_Downloads_f);
@@ -2118,7 +2125,7 @@ static void Command_Timedemo_f(void)
 
 	if (COM_Argc() < 2)
 	{
-		CONS_Printf(M_GetText("timedemo <demoname> [-csv [<trialid>]] [-quit]: time a demo\n"));
+		CONS_Printf(M_GetText("timedemo <demoname> [-csv [<trialid>]] [-json [<trialid>]] [-quit]: time a demo\n"));
 		return;
 	}
 
@@ -2155,13 +2162,19 @@ static void Command_Timedemo_f(void)
 	if (demo.playback)
 		G_StopDemo();
 
-	// print timedemo results as CSV?
-	i = COM_CheckParm("-csv");
-	timedemo_csv = (i > 0);
-	if (COM_CheckParm("-quit") != i + 1)
-		strcpy(timedemo_csv_id, COM_Argv(i + 1)); // user-defined string to identify row
-	else
-		timedemo_csv_id[0] = 0;
+	// print timedemo results as CSV and/or JSON?
+	timedemo_csv = (COM_CheckParm("-csv") > 0);
+	timedemo_json = (COM_CheckParm("-json") > 0);
+	timedemo_csv_id[0] = 0;
+	for (i = 2; i + 1 < COM_Argc(); i++)
+	{
+		// user-defined string to identify row
+		if ((!strcmp(COM_Argv(i), "-csv") || !strcmp(COM_Argv(i), "-json")) && COM_Argv(i + 1)[0] != '-')
+		{
+			strlcpy(timedemo_csv_id, COM_Argv(i + 1), sizeof(timedemo_csv_id));
+			break;
+		}
+	}
 
 	// exit after the timedemo?
 	timedemo_quit = (COM_CheckParm("-quit") > 0);
@@ -6479,18 +6492,13 @@ static void Command_Archivetest_f(void)
 {
 	savebuffer_t save = {0};
 	UINT32 i, wrote;
-	thinker_t *th;
 	if (gamestate != GS_LEVEL)
 	{
 		CONS_Printf("This command only works in-game, you dummy.\n");
 		return;
 	}
 
-	// assign mobjnum
-	i = 1;
-	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
-		if (th->function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
-			((mobj_t *)th)->mobjnum = i++;
+	// mobjnums are given out by the mobj pool, so there's nothing to assign
 
 	// allocate buffer
 	if (P_SaveBufferAlloc(&save, 1024) == false)
@@ -6523,6 +6531,94 @@ static void Command_Archivetest_f(void)
 	P_SaveBufferFree(&save);
 	CONS_Printf("Done. No crash.\n");
 }
+
+/** Pathfinds between random pairs of waypoints on the current map and
+  * reports how long it took.
+  */
+static void Command_Pathfindbench_f(void)
+{
+	const size_t count = K_GetNumWaypoints();
+	UINT32 runs = 5000;
+	UINT32 seed = 0x2A4D7F13;
+	UINT32 i, found = 0, benchnodes = 0;
+	precise_t start;
+	UINT64 elapsed;
+
+	if (gamestate != GS_LEVEL || count == 0)
+	{
+		CONS_Printf("This command only works in-game on a map with waypoints.\n");
+		return;
+	}
+
+	if (COM_Argc() > 1)
+	{
+		runs = max(1, atoi(COM_Argv(1)));
+	}
+
+	if (COM_Argc() > 2)
+	{
+		seed = (UINT32)atoi(COM_Argv(2));
+	}
+
+	start = I_GetPreciseTime();
+
+	for (i = 0; i < runs; i++)
+	{
+		waypoint_t *source, *destination;
+		path_t path = {0};
+
+		// Don't touch the synced RNG, this runs on one machine only
+		seed = seed * 1664525 + 1013904223;
+		source = K_GetWaypointFromIndex((seed >> 8) % count);
+		seed = seed * 1664525 + 1013904223;
+		destination = K_GetWaypointFromIndex((seed >> 8) % count);
+
+		if (K_PathfindToWaypoint(source, destination, &path, (i & 1), false))
+		{
+			found++;
+			benchnodes += path.numnodes;
+			Z_Free(path.array);
+		}
+	}
+
+	elapsed = (I_GetPreciseTime() - start) * 1000000 / I_GetPrecisePrecision();
+
+	CONS_Printf("%u paths on %s (%s waypoints): %u found, %u nodes\n",
+		runs, G_BuildMapName(gamemap), sizeu1(count), found, benchnodes);
+	CONS_Printf("%u.%03u ms total, %u.%03u us per path\n",
+		(UINT32)(elapsed / 1000), (UINT32)(elapsed % 1000),
+		(UINT32)(elapsed / runs), (UINT32)((elapsed * 1000 / runs) % 1000));
+}
+
+/** Draws random spans and columns with the scalar and the vectorized
+  * drawers and checks that they put the same pixels on the screen.
+  */
+static void Command_Simddrawtest_f(void)
+{
+	UINT32 runs = 2000;
+	UINT32 seed = 0x5EED5EED;
+
+	if (rendermode != render_soft)
+	{
+		CONS_Printf("This command only works in the software renderer.\n");
+		return;
+	}
+
+	if (COM_Argc() > 1)
+	{
+		runs = max(1, atoi(COM_Argv(1)));
+	}
+
+	if (COM_Argc() > 2)
+	{
+		seed = (UINT32)atoi(COM_Argv(2));
+	}
+
+	if (R_CheckSIMDDrawFuncs(runs, seed) == 0)
+	{
+		CONS_Printf("All vectorized drawers match.\n");
+	}
+}
 #endif
 
 /** Give yourself an, optional quantity or one of, an item.
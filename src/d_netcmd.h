@@ -141,6 +141,7 @@ extern consvar_t cv_livestudioaudience;
 extern char timedemo_name[256];
 extern boolean timedemo_csv;
 extern char timedemo_csv_id[256];
+extern boolean timedemo_json;
 extern boolean timedemo_quit;
 
 typedef enum
@@ -56,6 +56,8 @@
 #include "filesrch.h"
 #include "stun.h"
 
+#include <zlib.h>
+
 #include <errno.h>
 
 // Prototypes
@@ -78,19 +80,45 @@ typedef struct filetx_s
 	UINT8 fileid;
 	INT32 node; // Destination
 	struct filetx_s *next; // Next file in the list
-} filetx_t;
 
-// Current transfers (one for each node)
-typedef struct filetran_s
-{
-	filetx_t *txlist; // Linked list of all files for the node
+	// Set up once the file starts being sent
+	FILE *currentfile; // The file currently being sent
 	UINT8 iteration;
 	UINT8 ackediteration;
 	UINT32 position; // The current position in the file
 	boolean *ackedfragments;
 	UINT32 ackedsize;
-	FILE *currentfile; // The file currently being sent/received
+	UINT32 inflight; // Fragments sent this iteration and not acknowledged yet
 	tic_t dontsenduntil;
+} filetx_t;
+
+// How many files of a node's list are sent at once
+#define MAXFILESINFLIGHT 4
+
+// Bounds of the per node window, in fragments
+#define MINFILEWINDOW 4
+#define MAXFILEWINDOW 4096
+
+// Current transfers (one for each node)
+typedef struct filetran_s
+{
+	filetx_t *txlist; // Linked list of all files for the node
+	UINT8 nextfile; // Round robin among the files in flight
+
+	// Fragments allowed in flight, grown like a TCP congestion window
+	// and capped to what cv_downloadspeed can fill in one round trip
+	UINT32 window;
+	UINT32 ssthresh;
+	UINT32 windowacks;
+	tic_t lastack;
+
+	// Round trip time, measured on one fragment at a time
+	fixed_t srtt; // Smoothed, in tics
+	boolean probing;
+	UINT8 probefileid;
+	UINT8 probeiteration;
+	UINT32 probefragment;
+	tic_t probetime;
 } filetran_t;
 static filetran_t transfer[MAXNETNODES];
 
@@ -102,16 +130,12 @@ INT32 fileneedednum; // Number of files needed to join the server
 fileneeded_t fileneeded[MAX_WADFILES]; // List of needed files
 static tic_t lasttimeackpacketsent = 0;
 
-// For resuming failed downloads
-typedef struct
-{
-	char filename[MAX_WADPATH];
-	UINT8 md5sum[16];
-	boolean *receivedfragments;
-	UINT32 fragmentsize;
-	UINT32 currentsize;
-} pauseddownload_t;
-static pauseddownload_t *pauseddownload = NULL;
+// For resuming failed downloads: a file that was being downloaded is
+// kept next to a .part file holding which fragments arrived and a hash
+// of every chunk of fragments, so only intact chunks are kept on resume.
+#define FILECHUNKFRAGMENTS 64
+#define PARTFILEMAGIC "RRDL"
+#define PARTFILEVERSION 1
 
 // for cl loading screen
 INT32 lastfilenum = -1;
@@ -121,19 +145,27 @@ INT32 totalfilesrequestednum = 0;
 UINT32 totalfilesrequestedsize = 0;
 
 #ifdef HAVE_CURL
-static CURL *http_handle;
+// Files downloaded over HTTP at the same time
+#define MAXCURLTRANSFERS 4
+
+typedef struct
+{
+	CURL *handle; // NULL if the slot is free
+	fileneeded_t *file;
+	curl_off_t dlnow;
+	curl_off_t dltotal;
+	curl_off_t resumefrom; // Size of the partial file we continued
+	time_t starttime;
+	UINT32 origfilesize;
+	UINT32 origtotalfilesize;
+} curltransfer_t;
+
 static CURLM *multi_handle;
+static curltransfer_t curl_transfer[MAXCURLTRANSFERS];
 boolean curl_running = false;
 boolean curl_failedwebdownload = false;
-static curl_off_t curl_dlnow;
-static curl_off_t curl_dltotal;
-static time_t curl_starttime;
 INT32 curl_transfers = 0;
 static int curl_runninghandles = 0;
-static UINT32 curl_origfilesize;
-static UINT32 curl_origtotalfilesize;
-static char *curl_realname = NULL;
-fileneeded_t *curl_curfile = NULL;
 HTTP_login *curl_logins;
 #endif
 
@@ -330,29 +362,187 @@ boolean CL_CheckDownloadable(void)
 	return false;
 }
 
-/** Returns true if a needed file transfer can be resumed
+static UINT32 FragmentHash(UINT32 fragment, const UINT8 *data, size_t size)
+{
+	UINT8 index[4];
+	UINT8 *p = index;
+
+	WRITEUINT32(p, fragment);
+	return crc32(crc32(0, index, 4), data, size);
+}
+
+static UINT32 NumFragments(const fileneeded_t *file)
+{
+	return file->totalsize / file->fragmentsize + 1;
+}
+
+static UINT32 FragmentLength(const fileneeded_t *file, UINT32 fragment)
+{
+	return min(file->fragmentsize, file->totalsize - fragment * file->fragmentsize);
+}
+
+static void CL_PartFileName(char *out, const fileneeded_t *file)
+{
+	snprintf(out, MAX_WADPATH + 8, "%s.part", file->filename);
+}
+
+/** Writes the state of an unfinished download next to the file
   *
-  * \param file The needed file to resume the transfer for
-  * \return True if the transfer can be resumed
+  * \param file The needed file that is being downloaded
   *
   */
-static boolean CL_CanResumeDownload(fileneeded_t *file)
+static void CL_SavePartialDownload(const fileneeded_t *file)
 {
-	return pauseddownload
-		&& !strcmp(pauseddownload->filename, file->filename) // Same name
-		&& !memcmp(pauseddownload->md5sum, file->md5sum, 16) // Same checksum
-		&& pauseddownload->fragmentsize == file->fragmentsize; // Same fragment size
+	char partname[MAX_WADPATH + 8];
+	UINT32 numfragments = NumFragments(file);
+	UINT32 numchunks = numfragments / FILECHUNKFRAGMENTS + 1;
+	size_t length = 4 + 1 + 16 + 4 + 4 + (numfragments + 7) / 8 + numchunks * 4;
+	UINT8 *buffer, *p;
+	FILE *f;
+	UINT32 i;
+
+	buffer = p = calloc(1, length);
+	if (!buffer)
+		return;
+
+	WRITEMEM(p, PARTFILEMAGIC, 4);
+	WRITEUINT8(p, PARTFILEVERSION);
+	WRITEMEM(p, file->md5sum, 16);
+	WRITEUINT32(p, file->totalsize);
+	WRITEUINT32(p, file->fragmentsize);
+
+	for (i = 0; i < numfragments; i++)
+		if (file->receivedfragments[i])
+			p[i >> 3] |= 1 << (i & 7);
+	p += (numfragments + 7) / 8;
+
+	for (i = 0; i < numchunks; i++)
+		WRITEUINT32(p, file->chunkhashes[i]);
+
+	CL_PartFileName(partname, file);
+	f = fopen(partname, "wb");
+	if (f)
+	{
+		if (fwrite(buffer, 1, length, f) != length)
+			CONS_Alert(CONS_WARNING, "Can't write %s, the download will restart next time\n", partname);
+		fclose(f);
+	}
+
+	free(buffer);
 }
 
-void CL_AbortDownloadResume(void)
+/** Reopens a partially downloaded file, keeping the chunks whose data
+  * still hashes to what was recorded when it was received
+  *
+  * \param file The needed file, with its total and fragment size set
+  * \return True if the download was resumed
+  *
+  */
+static boolean CL_ResumeDownload(fileneeded_t *file)
 {
-	if (!pauseddownload)
-		return;
+	char partname[MAX_WADPATH + 8];
+	UINT32 numfragments = NumFragments(file);
+	UINT32 numchunks = numfragments / FILECHUNKFRAGMENTS + 1;
+	size_t length = 4 + 1 + 16 + 4 + 4 + (numfragments + 7) / 8 + numchunks * 4;
+	UINT8 *buffer = NULL, *bitmap, *p;
+	UINT8 *data = NULL;
+	UINT32 kept = 0, c, i;
+	FILE *f;
+	long filelength;
+
+	CL_PartFileName(partname, file);
+
+	f = fopen(partname, "rb");
+	if (!f)
+		return false;
+
+	fseek(f, 0, SEEK_END);
+	filelength = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	if (filelength != (long)length || !(buffer = malloc(length)) || fread(buffer, 1, length, f) != length)
+	{
+		fclose(f);
+		free(buffer);
+		return false;
+	}
+	fclose(f);
+
+	p = buffer;
+	if (memcmp(p, PARTFILEMAGIC, 4) || p[4] != PARTFILEVERSION)
+		goto fail;
+	p += 5;
+	if (memcmp(p, file->md5sum, 16))
+		goto fail;
+	p += 16;
+	if (READUINT32(p) != file->totalsize || READUINT32(p) != file->fragmentsize)
+		goto fail;
+	bitmap = p;
+	p += (numfragments + 7) / 8;
+
+	file->file = fopen(file->filename, "r+b");
+	if (!file->file)
+		goto fail;
+
+	file->receivedfragments = calloc(numfragments, sizeof(*file->receivedfragments));
+	file->chunkhashes = calloc(numchunks, sizeof(*file->chunkhashes));
+	data = malloc(file->fragmentsize);
+	if (!file->receivedfragments || !file->chunkhashes || !data)
+		I_Error("CL_ResumeDownload: No more memory\n");
+
+	file->currentsize = 0;
+
+	for (c = 0; c < numchunks; c++)
+	{
+		UINT32 first = c * FILECHUNKFRAGMENTS;
+		UINT32 last = min(first + FILECHUNKFRAGMENTS, numfragments);
+		UINT32 stored = READUINT32(p);
+		UINT32 hash = 0;
+		boolean any = false;
+
+		for (i = first; i < last; i++)
+		{
+			UINT32 size;
+
+			if (!(bitmap[i >> 3] & (1 << (i & 7))))
+				continue;
+
+			size = FragmentLength(file, i);
+			if (fseek(file->file, i * file->fragmentsize, SEEK_SET)
+				|| fread(data, 1, size, file->file) != size)
+			{
+				any = false;
+				break;
+			}
+
+			hash += FragmentHash(i, data, size);
+			any = true;
+		}
 
-	free(pauseddownload->receivedfragments);
-	remove(pauseddownload->filename);
-	free(pauseddownload);
-	pauseddownload = NULL;
+		if (!any || hash != stored)
+			continue;
+
+		for (i = first; i < last; i++)
+		{
+			if (bitmap[i >> 3] & (1 << (i & 7)))
+			{
+				file->receivedfragments[i] = true;
+				file->currentsize += FragmentLength(file, i);
+				kept++;
+			}
+		}
+		file->chunkhashes[c] = hash;
+	}
+
+	CONS_Printf("Resuming download, kept %uK of %uK...\n", file->currentsize >> 10, file->totalsize >> 10);
+
+	free(data);
+	free(buffer);
+	return true;
+
+fail:
+	free(buffer);
+	return false;
 }
 
 // The following was written and, against all odds, works.
@@ -1059,11 +1249,12 @@ boolean AddLuaFileToSendQueue(INT32 node, const char *filename)
   * either because the file has been fully sent or because the node was disconnected
   *
   * \param node The destination
+  * \param p The file request to remove
   *
   */
-static void SV_EndFileSend(INT32 node)
+static void SV_EndFileSend(INT32 node, filetx_t *p)
 {
-	filetx_t *p = transfer[node].txlist;
+	filetx_t **q;
 
 	// Free the file request according to the freemethod
 	// parameter used with AddFileToSendQueue/AddRamToSendQueue
@@ -1072,8 +1263,8 @@ static void SV_EndFileSend(INT32 node)
 		case SF_FILE: // It's a file, close it and free its filename
 			if (cv_noticedownload.value)
 				CONS_Printf("Ending file transfer (id %d) for node %d\n", p->fileid, node);
-			if (transfer[node].currentfile)
-				fclose(transfer[node].currentfile);
+			if (p->currentfile)
+				fclose(p->currentfile);
 			free(p->id.filename);
 			break;
 		case SF_Z_RAM: // It's a memory block allocated with Z_Alloc or the likes, use Z_Free
@@ -1086,171 +1277,296 @@ static void SV_EndFileSend(INT32 node)
 	}
 
 	// Remove the file request from the list
-	transfer[node].txlist = p->next;
+	for (q = &transfer[node].txlist; *q != p; q = &(*q)->next)
+		;
+	*q = p->next;
+
+	if (p->ackedfragments)
+		free(p->ackedfragments);
 	free(p);
 
 	// Indicate that the transmission is over
-	transfer[node].currentfile = NULL;
-	if (transfer[node].ackedfragments)
-		free(transfer[node].ackedfragments);
-	transfer[node].ackedfragments = NULL;
+	if (!transfer[node].txlist)
+		memset(&transfer[node], 0, sizeof (transfer[node]));
 
 	filestosend--;
 }
 
 #define FILEFRAGMENTSIZE (software_MAXPACKETLENGTH - (FILETXHEADER + BASEPACKETSIZE))
 
-/** Handles file transmission
+/** Opens a file (or memory block) and sets up its send state
   *
   */
-void FileSendTicker(void)
+static void SV_StartFileSend(filetx_t *f)
 {
-	static INT32 currentnode = 0;
-	filetx_pak *p;
-	size_t fragmentsize;
-	filetx_t *f;
-	INT32 packetsent, ram, i, j;
+	if (f->ram == SF_FILE) // Sending a file
+	{
+		long filesize;
 
-	// If someone is taking too long to download, kick them with a timeout
-	// to prevent blocking the rest of the server...
-	if (luafiletransfers)
+		f->currentfile = fopen(f->id.filename, "rb");
+
+		if (!f->currentfile)
+			I_Error("File %s does not exist",
+				f->id.filename);
+
+		fseek(f->currentfile, 0, SEEK_END);
+		filesize = ftell(f->currentfile);
+
+		// Nobody wants to transfer a file bigger
+		// than 4GB!
+		if (filesize >= LONG_MAX)
+			I_Error("filesize of %s is too large", f->id.filename);
+		if (filesize == -1)
+			I_Error("Error getting filesize of %s", f->id.filename);
+
+		f->size = (UINT32)filesize;
+		fseek(f->currentfile, 0, SEEK_SET);
+	}
+	else // Sending RAM
+		f->currentfile = (FILE *)1; // Set currentfile to a non-null value to indicate that it is open
+
+	f->iteration = 1;
+	f->ackediteration = 0;
+	f->position = 0;
+	f->ackedsize = 0;
+	f->inflight = 0;
+
+	f->ackedfragments = calloc(f->size / FILEFRAGMENTSIZE + 1, sizeof(*f->ackedfragments));
+	if (!f->ackedfragments)
+		I_Error("FileSendTicker: No more memory\n");
+
+	f->dontsenduntil = 0;
+}
+
+/** Returns the nth file that is sent alongside the first one, or NULL
+  *
+  * Files sent at the same time must have different ids,
+  * since that is all acknowledgements tell them apart by.
+  *
+  */
+static filetx_t *SV_FileInFlight(filetran_t *trans, INT32 n)
+{
+	filetx_t *f, *g;
+	INT32 i;
+
+	for (f = trans->txlist, i = 0; f && i < MAXFILESINFLIGHT; f = f->next, i++)
 	{
-		for (i = 1; i < MAXNETNODES; i++)
-		{
-			luafiletransfernodestatus_t status = luafiletransfers->nodestatus[i];
+		for (g = trans->txlist; g != f; g = g->next)
+			if (g->fileid == f->fileid)
+				return NULL;
 
-			if (status != LFTNS_NONE && status != LFTNS_WAITING && status != LFTNS_SENT
-				&& I_GetTime() > luafiletransfers->nodetimeouts[i])
-			{
-				Net_ConnectionTimeout(i);
-			}
-		}
+		if (i == n)
+			return f;
 	}
 
-	if (!filestosend) // No file to send
-		return;
+	return NULL;
+}
 
-	packetsent = cv_downloadspeed.value;
+static UINT32 SV_MaxFileWindow(const filetran_t *trans)
+{
+	// Enough to keep sending at full speed for one round trip, and some
+	UINT32 rtt = FixedCeil(trans->srtt) >> FRACBITS;
+	return min(MAXFILEWINDOW, (UINT32)cv_downloadspeed.value * (rtt + 2));
+}
 
-	netbuffer->packettype = PT_FILEFRAGMENT;
+// Unacknowledged fragments are considered lost: shrink the window
+// and stop waiting for them.
+static void SV_FileWindowLoss(filetran_t *trans)
+{
+	INT32 i;
+	filetx_t *f;
+
+	trans->window = max(MINFILEWINDOW, trans->window / 2);
+	trans->ssthresh = trans->window;
+	trans->windowacks = 0;
+	trans->probing = false;
+	trans->lastack = I_GetTime();
+
+	for (i = 0; (f = SV_FileInFlight(trans, i)) != NULL; i++)
+		f->inflight = 0;
+}
 
-	// (((sendbytes-nowsentbyte)*TICRATE)/(I_GetTime()-starttime)<(UINT32)net_bandwidth)
-	while (packetsent-- && filestosend != 0)
+static void SV_FileWindowAck(filetran_t *trans)
+{
+	trans->lastack = I_GetTime();
+
+	if (trans->window < trans->ssthresh)
+		trans->window++; // Slow start, doubles every round trip
+	else if (++trans->windowacks >= trans->window)
 	{
-		for (i = currentnode, j = 0; j < MAXNETNODES;
-			i = (i+1) % MAXNETNODES, j++)
-		{
-			if (transfer[i].txlist)
-				break;
-		}
-		// no transfer to do
-		if (j >= MAXNETNODES)
-			I_Error("filestosend=%d but no file to send found\n", filestosend);
+		trans->window++;
+		trans->windowacks = 0;
+	}
 
-		currentnode = (i+1) % MAXNETNODES;
-		f = transfer[i].txlist;
-		ram = f->ram;
+	trans->window = min(trans->window, SV_MaxFileWindow(trans));
+}
 
-		// Open the file if it isn't open yet, or
-		if (!transfer[i].currentfile)
-		{
-			if (!ram) // Sending a file
-			{
-				long filesize;
+static void SV_FileWrapped(filetran_t *trans, filetx_t *f)
+{
+	if (f->ackediteration < f->iteration)
+		f->dontsenduntil = I_GetTime() + TICRATE / 2;
 
-				transfer[i].currentfile =
-					fopen(f->id.filename, "rb");
+	f->position = 0;
+	f->iteration++;
 
-				if (!transfer[i].currentfile)
-					I_Error("File %s does not exist",
-						f->id.filename);
+	// Whatever is left unacknowledged is sent again this iteration
+	f->inflight = 0;
+	if (trans->probing && trans->probefileid == f->fileid)
+		trans->probing = false;
+}
 
-				fseek(transfer[i].currentfile, 0, SEEK_END);
-				filesize = ftell(transfer[i].currentfile);
+/** Sends the next fragment for a node, from one of the files in flight
+  *
+  * \return True if a fragment was sent
+  *
+  */
+static boolean SV_SendFileFragment(INT32 node)
+{
+	filetran_t *trans = &transfer[node];
+	filetx_pak *p;
+	size_t fragmentsize;
+	filetx_t *f = NULL, *g;
+	UINT32 inflight = 0;
+	INT32 i;
 
-				// Nobody wants to transfer a file bigger
-				// than 4GB!
-				if (filesize >= LONG_MAX)
-					I_Error("filesize of %s is too large", f->id.filename);
-				if (filesize == -1)
-					I_Error("Error getting filesize of %s", f->id.filename);
+	if (!trans->window)
+	{
+		trans->window = max(MINFILEWINDOW, (UINT32)cv_downloadspeed.value);
+		trans->ssthresh = MAXFILEWINDOW;
+		trans->lastack = I_GetTime();
+	}
 
-				f->size = (UINT32)filesize;
-				fseek(transfer[i].currentfile, 0, SEEK_SET);
-			}
-			else // Sending RAM
-				transfer[i].currentfile = (FILE *)1; // Set currentfile to a non-null value to indicate that it is open
+	for (i = 0; (g = SV_FileInFlight(trans, i)) != NULL; i++)
+		inflight += g->inflight;
 
-			transfer[i].iteration = 1;
-			transfer[i].ackediteration = 0;
-			transfer[i].position = 0;
-			transfer[i].ackedsize = 0;
+	if (inflight >= trans->window)
+	{
+		// Nothing came back for a while, the window must have been lost
+		tic_t rto = max(TICRATE / 4, 2 * (FixedCeil(trans->srtt) >> FRACBITS));
+		if (I_GetTime() - trans->lastack > rto)
+			SV_FileWindowLoss(trans);
+		return false;
+	}
 
-			transfer[i].ackedfragments = calloc(f->size / FILEFRAGMENTSIZE + 1, sizeof(*transfer[i].ackedfragments));
-			if (!transfer[i].ackedfragments)
-				I_Error("FileSendTicker: No more memory\n");
+	// Round robin between the files in flight
+	for (i = 0; i < MAXFILESINFLIGHT; i++)
+	{
+		filetx_t *candidate = SV_FileInFlight(trans, (trans->nextfile + i) % MAXFILESINFLIGHT);
 
-			transfer[i].dontsenduntil = 0;
-		}
+		if (!candidate)
+			continue;
+
+		// Open the file if it isn't open yet
+		if (!candidate->currentfile)
+			SV_StartFileSend(candidate);
 
 		// If the client hasn't acknowledged any fragment from the previous iteration,
 		// it is most likely because their acks haven't had enough time to reach the server
 		// yet, due to latency. In that case, we wait a little to avoid useless resend.
-		if (I_GetTime() < transfer[i].dontsenduntil)
+		if (I_GetTime() < candidate->dontsenduntil)
 			continue;
 
-		// Find the first non-acknowledged fragment
-		while (transfer[i].ackedfragments[transfer[i].position / FILEFRAGMENTSIZE])
+		f = candidate;
+		trans->nextfile = (UINT8)((trans->nextfile + i + 1) % MAXFILESINFLIGHT);
+		break;
+	}
+
+	if (!f)
+		return false;
+
+	// Find the first non-acknowledged fragment
+	while (f->ackedfragments[f->position / FILEFRAGMENTSIZE])
+	{
+		f->position += FILEFRAGMENTSIZE;
+		if (f->position >= f->size)
+			SV_FileWrapped(trans, f);
+	}
+
+	// Build a packet containing a file fragment
+	netbuffer->packettype = PT_FILEFRAGMENT;
+	p = (void*)&netbuffer->u.filetxpak;
+	fragmentsize = FILEFRAGMENTSIZE;
+	if (f->size-f->position < fragmentsize)
+		fragmentsize = f->size-f->position;
+	if (f->ram)
+		M_Memcpy(p->data, &f->id.ram[f->position], fragmentsize);
+	else
+	{
+		fseek(f->currentfile, f->position, SEEK_SET);
+
+		if (fread(p->data, 1, fragmentsize, f->currentfile) != fragmentsize)
+			I_Error("FileSendTicker: can't read %s byte on %s at %d because %s", sizeu1(fragmentsize), f->id.filename, f->position, M_FileError(f->currentfile));
+	}
+	p->iteration = f->iteration;
+	p->position = LONG(f->position);
+	p->fileid = f->fileid;
+	p->filesize = LONG(f->size);
+	p->size = SHORT((UINT16)FILEFRAGMENTSIZE);
+
+	// Send the packet
+	if (!HSendPacket(node, false, 0, FILETXHEADER + fragmentsize)) // Don't use the default acknowledgement system
+		return false; // Not sent for some odd reason, retry at next call
+
+	if (!trans->probing)
+	{
+		trans->probing = true;
+		trans->probefileid = f->fileid;
+		trans->probeiteration = f->iteration;
+		trans->probefragment = f->position / FILEFRAGMENTSIZE;
+		trans->probetime = I_GetTime();
+	}
+
+	f->inflight++;
+	f->position = (UINT32)(f->position + fragmentsize);
+	if (f->position >= f->size)
+		SV_FileWrapped(trans, f);
+
+	return true;
+}
+
+/** Handles file transmission
+  *
+  */
+void FileSendTicker(void)
+{
+	static INT32 currentnode = 0;
+	INT32 packetsent, tries, i;
+
+	// If someone is taking too long to download, kick them with a timeout
+	// to prevent blocking the rest of the server...
+	if (luafiletransfers)
+	{
+		for (i = 1; i < MAXNETNODES; i++)
 		{
-			transfer[i].position += FILEFRAGMENTSIZE;
-			if (transfer[i].position >= f->size)
-			{
-				if (transfer[i].ackediteration < transfer[i].iteration)
-					transfer[i].dontsenduntil = I_GetTime() + TICRATE / 2;
+			luafiletransfernodestatus_t status = luafiletransfers->nodestatus[i];
 
-				transfer[i].position = 0;
-				transfer[i].iteration++;
+			if (status != LFTNS_NONE && status != LFTNS_WAITING && status != LFTNS_SENT
+				&& I_GetTime() > luafiletransfers->nodetimeouts[i])
+			{
+				Net_ConnectionTimeout(i);
 			}
 		}
+	}
 
-		// Build a packet containing a file fragment
-		p = (void*)&netbuffer->u.filetxpak;
-		fragmentsize = FILEFRAGMENTSIZE;
-		if (f->size-transfer[i].position < fragmentsize)
-			fragmentsize = f->size-transfer[i].position;
-		if (ram)
-			M_Memcpy(p->data, &f->id.ram[transfer[i].position], fragmentsize);
-		else
-		{
-			fseek(transfer[i].currentfile, transfer[i].position, SEEK_SET);
+	if (!filestosend) // No file to send
+		return;
 
-			if (fread(p->data, 1, fragmentsize, transfer[i].currentfile) != fragmentsize)
-				I_Error("FileSendTicker: can't read %s byte on %s at %d because %s", sizeu1(fragmentsize), f->id.filename, transfer[i].position, M_FileError(transfer[i].currentfile));
-		}
-		p->iteration = transfer[i].iteration;
-		p->position = LONG(transfer[i].position);
-		p->fileid = f->fileid;
-		p->filesize = LONG(f->size);
-		p->size = SHORT((UINT16)FILEFRAGMENTSIZE);
-
-		// Send the packet
-		if (HSendPacket(i, false, 0, FILETXHEADER + fragmentsize)) // Don't use the default acknowledgement system
-		{ // Success
-			transfer[i].position = (UINT32)(transfer[i].position + fragmentsize);
-			if (transfer[i].position >= f->size)
-			{
-				if (transfer[i].ackediteration < transfer[i].iteration)
-					transfer[i].dontsenduntil = I_GetTime() + TICRATE / 2;
+	packetsent = cv_downloadspeed.value;
 
-				transfer[i].position = 0;
-				transfer[i].iteration++;
-			}
+	// Hand out this tic's packets between nodes, skipping the ones
+	// whose window is full, until nobody has anything left to send
+	for (tries = 0; packetsent > 0 && tries < MAXNETNODES;)
+	{
+		i = currentnode;
+		currentnode = (currentnode + 1) % MAXNETNODES;
+
+		if (transfer[i].txlist && SV_SendFileFragment(i))
+		{
+			packetsent--;
+			tries = 0;
 		}
 		else
-		{ // Not sent for some odd reason, retry at next call
-			// Exit the while (can't send this one so why should i send the next?)
-			break;
-		}
+			tries++;
 	}
 }
 
@@ -1259,10 +1575,14 @@ void PT_FileAck(void)
 	fileack_pak *packet = (void*)&netbuffer->u.fileack;
 	INT32 node = doomcom->remotenode;
 	filetran_t *trans = &transfer[node];
+	filetx_t *f;
 	INT32 i, j;
 
 	// Wrong file id? Ignore it, it's probably a late packet
-	if (!(trans->txlist && packet->fileid == trans->txlist->fileid))
+	for (i = 0; (f = SV_FileInFlight(trans, i)) != NULL; i++)
+		if (packet->fileid == f->fileid && f->ackedfragments)
+			break;
+	if (!f)
 		return;
 
 	if (packet->numsegments * sizeof(*packet->segments) != doomcom->datalength - BASEPACKETSIZE - sizeof(*packet))
@@ -1271,11 +1591,11 @@ void PT_FileAck(void)
 		return;
 	}
 
-	if (packet->iteration > trans->ackediteration)
+	if (packet->iteration > f->ackediteration)
 	{
-		trans->ackediteration = packet->iteration;
-		if (trans->ackediteration >= trans->iteration - 1)
-			trans->dontsenduntil = 0;
+		f->ackediteration = packet->iteration;
+		if (f->ackediteration >= f->iteration - 1)
+			f->dontsenduntil = 0;
 	}
 
 	for (i = 0; i < packet->numsegments; i++)
@@ -1285,21 +1605,39 @@ void PT_FileAck(void)
 		for (j = 0; j < 32; j++)
 			if (LONG(segment->acks) & (1 << j))
 			{
-				if (LONG(segment->start) * FILEFRAGMENTSIZE >= trans->txlist->size)
+				UINT32 fragment = LONG(segment->start) + j;
+
+				if (fragment * FILEFRAGMENTSIZE >= f->size)
 				{
 					Net_CloseConnection(node);
 					return;
 				}
 
-				if (!trans->ackedfragments[LONG(segment->start) + j])
+				if (trans->probing && trans->probefileid == f->fileid
+					&& trans->probefragment == fragment && trans->probeiteration == f->iteration)
+				{
+					fixed_t sample = (I_GetTime() - trans->probetime) << FRACBITS;
+
+					if (trans->srtt)
+						trans->srtt += (sample - trans->srtt) / 8;
+					else
+						trans->srtt = sample;
+					trans->probing = false;
+				}
+
+				if (!f->ackedfragments[fragment])
 				{
-					trans->ackedfragments[LONG(segment->start) + j] = true;
-					trans->ackedsize += FILEFRAGMENTSIZE;
+					f->ackedfragments[fragment] = true;
+					f->ackedsize += FILEFRAGMENTSIZE;
+
+					if (f->inflight)
+						f->inflight--;
+					SV_FileWindowAck(trans);
 
 					// If the last missing fragment was acked, finish!
-					if (trans->ackedsize == trans->txlist->size)
+					if (f->ackedsize >= f->size)
 					{
-						SV_EndFileSend(node);
+						SV_EndFileSend(node, f);
 						return;
 					}
 				}
@@ -1309,10 +1647,17 @@ void PT_FileAck(void)
 
 void PT_FileReceived(void)
 {
-	filetx_t *trans = transfer[doomcom->remotenode].txlist;
+	filetx_t *trans;
+	INT32 i;
 
-	if (trans && netbuffer->u.filereceived == trans->fileid)
-		SV_EndFileSend(doomcom->remotenode);
+	for (i = 0; (trans = SV_FileInFlight(&transfer[doomcom->remotenode], i)) != NULL; i++)
+	{
+		if (netbuffer->u.filereceived == trans->fileid)
+		{
+			SV_EndFileSend(doomcom->remotenode, trans);
+			return;
+		}
+	}
 }
 
 // Someone knocked on the door with their public key.
@@ -1461,43 +1806,38 @@ void PT_FileFragment(void)
 
 		file->status = FS_DOWNLOADING;
 		file->fragmentsize = fragmentsize;
+		file->totalsize = LONG(pak->filesize);
 		file->iteration = 0;
 
 		file->ackpacket = calloc(1, sizeof(*file->ackpacket) + 512);
 		if (!file->ackpacket)
 			I_Error("FileSendTicker: No more memory\n");
 
-		if (CL_CanResumeDownload(file))
-		{
-			file->file = fopen(filename, "r+b");
-			if (!file->file)
-				I_Error("Can't reopen file %s: %s", filename, strerror(errno));
-			CONS_Printf("\r%s...\n", filename);
+		CONS_Printf("\r%s...\n", filename);
 
-			CONS_Printf("Resuming download...\n");
-			file->currentsize = pauseddownload->currentsize;
-			file->receivedfragments = pauseddownload->receivedfragments;
+		// 0 is either srb2.srb or the gamestate...
+		if (filenum != 0 && CL_ResumeDownload(file))
+		{
+			// Acknowledge everything we kept, so the server skips it
 			file->ackresendposition = 0;
-
-			free(pauseddownload);
-			pauseddownload = NULL;
 		}
 		else
 		{
-			CL_AbortDownloadResume();
+			char partname[MAX_WADPATH + 8];
+
+			CL_PartFileName(partname, file);
+			remove(partname);
 
 			file->file = fopen(filename, "wb");
 			if (!file->file)
 				I_Error("Can't create file %s: %s", filename, strerror(errno));
 
-			CONS_Printf("\r%s...\n",filename);
-
 			file->currentsize = 0;
-			file->totalsize = LONG(pak->filesize);
 			file->ackresendposition = UINT32_MAX; // Only used for resumed downloads
 
-			file->receivedfragments = calloc(file->totalsize / fragmentsize + 1, sizeof(*file->receivedfragments));
-			if (!file->receivedfragments)
+			file->receivedfragments = calloc(NumFragments(file), sizeof(*file->receivedfragments));
+			file->chunkhashes = calloc(NumFragments(file) / FILECHUNKFRAGMENTS + 1, sizeof(*file->chunkhashes));
+			if (!file->receivedfragments || !file->chunkhashes)
 				I_Error("FileSendTicker: No more memory\n");
 		}
 
@@ -1513,7 +1853,10 @@ void PT_FileFragment(void)
 
 		if (!file->receivedfragments[fragmentpos / fragmentsize]) // Not received yet
 		{
-			file->receivedfragments[fragmentpos / fragmentsize] = true;
+			UINT32 fragment = fragmentpos / fragmentsize;
+
+			file->receivedfragments[fragment] = true;
+			file->chunkhashes[fragment / FILECHUNKFRAGMENTS] += FragmentHash(fragment, pak->data, boundedfragmentsize);
 
 			// We can receive packets in the wrong order, anyway all OSes support gaped files
 			fseek(file->file, fragmentpos, SEEK_SET);
@@ -1529,8 +1872,17 @@ void PT_FileFragment(void)
 				fclose(file->file);
 				file->file = NULL;
 				free(file->receivedfragments);
+				free(file->chunkhashes);
+				file->chunkhashes = NULL;
 				free(file->ackpacket);
 				file->status = FS_FOUND;
+				if (filenum != 0)
+				{
+					char partname[MAX_WADPATH + 8];
+
+					CL_PartFileName(partname, file);
+					remove(partname);
+				}
 				file->justdownloaded = true;
 				CONS_Printf(M_GetText("Downloading %s...(done)\n"),
 					filename);
@@ -1605,7 +1957,7 @@ boolean SendingFile(INT32 node)
 void SV_AbortSendFiles(INT32 node)
 {
 	while (transfer[node].txlist)
-		SV_EndFileSend(node);
+		SV_EndFileSend(node, transfer[node].txlist);
 }
 
 void CloseNetFile(void)
@@ -1620,43 +1972,45 @@ void CloseNetFile(void)
 		if (fileneeded[i].status == FS_DOWNLOADING && fileneeded[i].file)
 		{
 			fclose(fileneeded[i].file);
+			fileneeded[i].file = NULL;
 			free(fileneeded[i].ackpacket);
 
-			if (!pauseddownload && i != 0) // 0 is either srb2.srb or the gamestate...
+			if (i != 0) // 0 is either srb2.srb or the gamestate...
 			{
 				// Don't remove the file, save it for later in case we resume the download
-				pauseddownload = malloc(sizeof(*pauseddownload));
-				if (!pauseddownload)
-					I_Error("CloseNetFile: No more memory\n");
-
-				strcpy(pauseddownload->filename, fileneeded[i].filename);
-				memcpy(pauseddownload->md5sum, fileneeded[i].md5sum, 16);
-				pauseddownload->currentsize = fileneeded[i].currentsize;
-				pauseddownload->receivedfragments = fileneeded[i].receivedfragments;
-				pauseddownload->fragmentsize = fileneeded[i].fragmentsize;
+				CL_SavePartialDownload(&fileneeded[i]);
 			}
 			else
 			{
-				free(fileneeded[i].receivedfragments);
 				// File is not complete delete it
 				remove(fileneeded[i].filename);
 			}
+
+			free(fileneeded[i].receivedfragments);
+			free(fileneeded[i].chunkhashes);
+			fileneeded[i].chunkhashes = NULL;
 		}
 }
 
 void Command_Downloads_f(void)
 {
-	INT32 node;
+	INT32 node, i;
+	filetx_t *f;
 
 	for (node = 0; node < MAXNETNODES; node++)
-		if (transfer[node].txlist
-		&& transfer[node].txlist->ram == SF_FILE) // Node is downloading a file?
+		for (i = 0; (f = SV_FileInFlight(&transfer[node], i)) != NULL; i++)
 		{
-			const char *name = transfer[node].txlist->id.filename;
-			UINT32 position = transfer[node].ackedsize;
-			UINT32 size = transfer[node].txlist->size;
+			const char *name;
+			UINT32 position, size;
 			char ratecolor;
 
+			if (f->ram != SF_FILE) // Node is downloading a file?
+				continue;
+
+			name = f->id.filename;
+			position = min(f->ackedsize, f->size);
+			size = f->size;
+
 			// Avoid division by zero errors
 			if (!size)
 				size = 1;
@@ -1787,54 +2141,144 @@ static size_t curlwrite_data(void *ptr, size_t size, size_t nmemb, FILE *stream)
 
 static int curlprogress_callback(void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
 {
+	curltransfer_t *ct = clientp;
 	time_t curtime;
+	INT32 i;
 
-	(void)clientp;
 	(void)ultotal;
 	(void)ulnow; // Function prototype requires these but we won't use, so just discard
 
 	curtime = time(NULL);
 
-	curl_dlnow = dlnow;
-	curl_dltotal = dltotal;
+	ct->dlnow = dlnow;
+	ct->dltotal = dltotal;
 
-	if (curtime > curl_starttime)
+	getbytes = 0;
+	for (i = 0; i < MAXCURLTRANSFERS; i++)
 	{
-		getbytes = curl_dlnow / (curtime - curl_starttime); // To-do: Make this more accurate???
+		ct = &curl_transfer[i];
+		if (ct->handle && curtime > ct->starttime)
+			getbytes += ct->dlnow / (curtime - ct->starttime); // To-do: Make this more accurate???
 	}
-	else
+	return 0;
+}
+
+// An interrupted HTTP download is only continued if this marker says
+// the file on disk is the start of the exact file being asked for;
+// anything else with the same name (an older version of the addon,
+// say) gets downloaded again from scratch.
+#define HTTPPARTFILEMAGIC "RRHT"
+#define HTTPPARTFILEVERSION 1
+#define HTTPPARTFILELENGTH (4 + 1 + 16 + 4)
+
+static void CL_HTTPPartFileName(char *out, const fileneeded_t *file)
+{
+	snprintf(out, MAX_WADPATH + 8, "%s.hpart", file->filename);
+}
+
+static void CL_SaveHTTPPartial(const fileneeded_t *file)
+{
+	char partname[MAX_WADPATH + 8];
+	UINT8 buffer[HTTPPARTFILELENGTH];
+	UINT8 *p = buffer;
+	FILE *f;
+
+	WRITEMEM(p, HTTPPARTFILEMAGIC, 4);
+	WRITEUINT8(p, HTTPPARTFILEVERSION);
+	WRITEMEM(p, file->md5sum, 16);
+	WRITEUINT32(p, file->totalsize);
+
+	CL_HTTPPartFileName(partname, file);
+	f = fopen(partname, "wb");
+	if (f)
 	{
-		getbytes = 0;
+		if (fwrite(buffer, 1, sizeof buffer, f) != sizeof buffer)
+			CONS_Alert(CONS_WARNING, "Can't write %s, the download will restart next time\n", partname);
+		fclose(f);
 	}
-	return 0;
 }
 
-void CURLPrepareFile(const char* url, int dfilenum)
+static boolean CL_CheckHTTPPartial(const fileneeded_t *file)
+{
+	char partname[MAX_WADPATH + 8];
+	UINT8 buffer[HTTPPARTFILELENGTH];
+	UINT8 *p = buffer;
+	boolean ok;
+	FILE *f;
+
+	CL_HTTPPartFileName(partname, file);
+	f = fopen(partname, "rb");
+	if (!f)
+		return false;
+
+	ok = (fread(buffer, 1, sizeof buffer, f) == sizeof buffer);
+	fclose(f);
+
+	if (!ok || memcmp(p, HTTPPARTFILEMAGIC, 4) || p[4] != HTTPPARTFILEVERSION)
+		return false;
+	p += 5;
+	if (memcmp(p, file->md5sum, 16))
+		return false;
+	p += 16;
+	return READUINT32(p) == file->totalsize;
+}
+
+static void CL_RemoveHTTPPartial(const fileneeded_t *file)
+{
+	char partname[MAX_WADPATH + 8];
+
+	CL_HTTPPartFileName(partname, file);
+	remove(partname);
+}
+
+boolean CURLPrepareFile(const char* url, int dfilenum)
 {
 	HTTP_login *login;
+	curltransfer_t *ct = NULL;
+	char partname[MAX_WADPATH + 8];
+	INT32 i;
 
 #ifdef PARANOIA
 	if (M_CheckParm("-nodownload"))
 		I_Error("Attempted to download files in -nodownload mode");
 #endif
 
-	curl_global_init(CURL_GLOBAL_ALL);
+	for (i = 0; i < MAXCURLTRANSFERS; i++)
+		if (!curl_transfer[i].handle)
+		{
+			ct = &curl_transfer[i];
+			break;
+		}
+
+	if (!ct)
+		return false;
+
+	if (!multi_handle)
+	{
+		curl_global_init(CURL_GLOBAL_ALL);
+		multi_handle = curl_multi_init();
+		if (!multi_handle)
+			return false;
+	}
 
-	http_handle = curl_easy_init();
-	multi_handle = curl_multi_init();
+	ct->handle = curl_easy_init();
 
-	if (http_handle && multi_handle)
+	if (ct->handle)
 	{
+		fileneeded_t *file = &fileneeded[dfilenum];
+		CURL *http_handle = ct->handle;
+		long resumefrom = 0;
+
 		I_mkdir(downloaddir, 0755);
 
-		curl_curfile = &fileneeded[dfilenum];
-		curl_realname = curl_curfile->filename;
-		nameonly(curl_realname);
+		ct->file = file;
+		nameonly(file->filename);
 
-		curl_origfilesize = curl_curfile->currentsize;
-		curl_origtotalfilesize = curl_curfile->totalsize;
+		ct->origfilesize = file->currentsize;
+		ct->origtotalfilesize = file->totalsize;
+		ct->dlnow = ct->dltotal = 0;
 
-		curl_easy_setopt(http_handle, CURLOPT_URL, va("%s/%s", url, curl_realname));
+		curl_easy_setopt(http_handle, CURLOPT_URL, va("%s/%s", url, file->filename));
 
 		// Only allow HTTP and HTTPS
 #if LIBCURL_VERSION_MAJOR > 7 || (LIBCURL_VERSION_MAJOR == 7 && LIBCURL_VERSION_MINOR >= 85)
@@ -1858,23 +2302,57 @@ void CURLPrepareFile(const char* url, int dfilenum)
 
 		curl_easy_setopt(http_handle, CURLOPT_FAILONERROR, 1L);
 
-		CONS_Printf("Downloading %s from %s\n", curl_realname, url);
+		CONS_Printf("Downloading %s from %s\n", file->filename, url);
+
+		strcatbf(file->filename, downloaddir, "/");
+
+		// A file left by an interrupted HTTP download is contiguous, so it
+		// can be continued. One left by the internal downloader has gaps.
+		CL_PartFileName(partname, file);
+		if (FIL_FileExists(partname))
+		{
+			remove(partname);
+		}
+		else if (CL_CheckHTTPPartial(file) && (file->file = fopen(file->filename, "rb")) != NULL)
+		{
+			fseek(file->file, 0, SEEK_END);
+			resumefrom = ftell(file->file);
+			fclose(file->file);
+
+			if (resumefrom < 0 || (UINT32)resumefrom >= file->totalsize)
+				resumefrom = 0;
+		}
+
+		ct->resumefrom = resumefrom;
+		if (resumefrom)
+		{
+			CONS_Printf("Resuming download at %ldK...\n", resumefrom >> 10);
+			file->file = fopen(file->filename, "ab");
+			curl_easy_setopt(http_handle, CURLOPT_RESUME_FROM_LARGE, (curl_off_t)resumefrom);
+		}
+		else
+		{
+			file->file = fopen(file->filename, "wb");
+		}
+
+		CL_SaveHTTPPartial(file);
 
-		strcatbf(curl_curfile->filename, downloaddir, "/");
-		curl_curfile->file = fopen(curl_curfile->filename, "wb");
-		curl_easy_setopt(http_handle, CURLOPT_WRITEDATA, curl_curfile->file);
+		curl_easy_setopt(http_handle, CURLOPT_WRITEDATA, file->file);
 		curl_easy_setopt(http_handle, CURLOPT_WRITEFUNCTION, curlwrite_data);
 		curl_easy_setopt(http_handle, CURLOPT_NOPROGRESS, 0L);
 		curl_easy_setopt(http_handle, CURLOPT_XFERINFOFUNCTION, curlprogress_callback);
+		curl_easy_setopt(http_handle, CURLOPT_XFERINFODATA, ct);
 
-		curl_curfile->status = FS_DOWNLOADING;
+		file->status = FS_DOWNLOADING;
 		lastfilenum = dfilenum;
 		curl_multi_add_handle(multi_handle, http_handle);
 
 		curl_multi_perform(multi_handle, &curl_runninghandles);
-		curl_starttime = time(NULL);
+		ct->starttime = time(NULL);
 		curl_running = true;
 	}
+
+	return true;
 }
 
 void CURLGetFile(void)
@@ -1886,8 +2364,11 @@ void CURLGetFile(void)
 	CURL *e;
 	int msgs_left; /* how many messages are left */
 	const char *easy_handle_error;
-	long response_code = 0;
+	long response_code;
 	static char *filename;
+	curltransfer_t *ct;
+	fileneeded_t *file;
+	INT32 i;
 
     if (curl_runninghandles)
     {
@@ -1901,8 +2382,15 @@ void CURLGetFile(void)
 			CONS_Alert(CONS_WARNING, "curl_multi_wait() failed, code %d.\n", mc);
 			return;
 		}
-		curl_curfile->currentsize = curl_dlnow;
-		curl_curfile->totalsize = curl_dltotal;
+
+		for (i = 0; i < MAXCURLTRANSFERS; i++)
+		{
+			ct = &curl_transfer[i];
+			if (!ct->handle)
+				continue;
+			ct->file->currentsize = ct->resumefrom + ct->dlnow;
+			ct->file->totalsize = ct->resumefrom + ct->dltotal;
+		}
     }
 
     /* See how the transfers went */
@@ -1912,48 +2400,81 @@ void CURLGetFile(void)
 		{
 			e = m->easy_handle;
 			easyres = m->data.result;
-			filename = Z_StrDup(curl_realname);
+			response_code = 0;
+
+			ct = NULL;
+			for (i = 0; i < MAXCURLTRANSFERS; i++)
+				if (curl_transfer[i].handle == e)
+					ct = &curl_transfer[i];
+			if (!ct)
+				continue;
+
+			file = ct->file;
+			filename = Z_StrDup(file->filename);
 			nameonly(filename);
-			if (easyres != CURLE_OK)
+			fclose(file->file);
+
+			if (easyres == CURLE_RANGE_ERROR)
+			{
+				// The server can't continue the file, so get all of it again
+				CONS_Printf("Can't resume the download of %s, restarting\n", filename);
+				remove(file->filename);
+				CL_RemoveHTTPPartial(file);
+				nameonly(file->filename);
+				file->status = FS_NOTFOUND;
+				file->currentsize = ct->origfilesize;
+				file->totalsize = ct->origtotalfilesize;
+				curl_transfers++; // It will be counted off again
+			}
+			else if (easyres != CURLE_OK)
 			{
 				if (easyres == CURLE_HTTP_RETURNED_ERROR)
+				{
 					curl_easy_getinfo(e, CURLINFO_RESPONSE_CODE, &response_code);
+					remove(file->filename);
+					CL_RemoveHTTPPartial(file);
+				}
+				// Otherwise, keep what we got for the next try
 
 				easy_handle_error = (response_code) ? va("HTTP reponse code %ld", response_code) : curl_easy_strerror(easyres);
-				curl_curfile->status = FS_FALLBACK;
-				curl_curfile->currentsize = curl_origfilesize;
-				curl_curfile->totalsize = curl_origtotalfilesize;
+				file->status = FS_FALLBACK;
+				file->currentsize = ct->origfilesize;
+				file->totalsize = ct->origtotalfilesize;
 				curl_failedwebdownload = true;
-				fclose(curl_curfile->file);
-				remove(curl_curfile->filename);
 				CONS_Printf(M_GetText("Failed to download %s (%s)\n"), filename, easy_handle_error);
 			}
 			else
 			{
-				fclose(curl_curfile->file);
+				// Complete either way, so there is nothing left to resume
+				CL_RemoveHTTPPartial(file);
 
-				if (checkfilemd5(curl_curfile->filename, curl_curfile->md5sum) == FS_MD5SUMBAD)
+				if (checkfilemd5(file->filename, file->md5sum) == FS_MD5SUMBAD)
 				{
 					CONS_Alert(CONS_ERROR, M_GetText("HTTP Download of %s finished but is corrupt or has been modified\n"), filename);
-					curl_curfile->status = FS_FALLBACK;
+					file->status = FS_FALLBACK;
 					curl_failedwebdownload = true;
 				}
 				else
 				{
 					CONS_Printf(M_GetText("Finished HTTP download of %s\n"), filename);
 					downloadcompletednum++;
-					downloadcompletedsize += curl_curfile->totalsize;
-					curl_curfile->status = FS_FOUND;
+					downloadcompletedsize += file->totalsize;
+					file->status = FS_FOUND;
 				}
 			}
 
 
 			Z_Free(filename);
-			curl_curfile->file = NULL;
-			curl_running = false;
+			file->file = NULL;
 			curl_transfers--;
 			curl_multi_remove_handle(multi_handle, e);
 			curl_easy_cleanup(e);
+			memset(ct, 0, sizeof(*ct));
+
+			curl_running = false;
+			for (i = 0; i < MAXCURLTRANSFERS; i++)
+				if (curl_transfer[i].handle)
+					curl_running = true;
 
 			if (!curl_transfers)
 				break;
@@ -1963,6 +2484,7 @@ void CURLGetFile(void)
     if (!curl_transfers)
     {
 		curl_multi_cleanup(multi_handle);
+		multi_handle = NULL;
 		curl_global_cleanup();
     }
 }
@@ -53,6 +53,7 @@ struct fileneeded_t
 	// Used only for download
 	FILE *file;
 	boolean *receivedfragments;
+	UINT32 *chunkhashes; // Sum of the hashes of the fragments received, per chunk
 	UINT32 fragmentsize;
 	UINT8 iteration;
 	fileack_pak *ackpacket;
@@ -150,7 +151,6 @@ void MakePathDirs(char *path);
 
 void SV_AbortSendFiles(INT32 node);
 void CloseNetFile(void);
-void CL_AbortDownloadResume(void);
 
 void Command_Downloads_f(void);
 
@@ -165,7 +165,7 @@ void nameonly(char *s);
 size_t nameonlylength(const char *s);
 
 #ifdef HAVE_CURL
-void CURLPrepareFile(const char* url, int dfilenum);
+boolean CURLPrepareFile(const char* url, int dfilenum);
 void CURLGetFile(void);
 HTTP_login * CURLGetLogin (const char *url, HTTP_login ***return_prev_next);
 #endif
@@ -13,10 +13,13 @@
 /// \brief Demo recording and playback
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
+#include <vector>
 
 #include <tcb/span.hpp>
 #include <nlohmann/json.hpp>
+#include <zlib.h>
 
 #include "doomdef.h"
 #include "doomtype.h"
@@ -48,6 +51,7 @@
 #include "v_video.h"
 #include "lua_hook.h"
 #include "md5.h" // demo checksums
+#include "m_perfstats.h"
 #include "p_saveg.h" // savebuffer_t
 #include "g_party.h"
 
@@ -118,8 +122,20 @@ size_t copy_fixed_buf(void* p, const void* s, size_t n)
 
 static char demoname[MAX_WADPATH];
 static savebuffer_t demobuf = {0};
-static UINT8 *demotime_p, *demoinfo_p;
+static UINT8 *demotime_p, *demoinfo_p, *demobody_p;
 static UINT16 demoflags;
+
+// Shape of each recorded tic, so G_DeflateDemoStream can cut the
+// stream into columns without having to understand every record.
+struct demotic_t
+{
+	UINT32 extralen; // G_WriteDemoExtraData, up to and including DW_END
+	UINT16 cmdmask; // players with a ticcmd
+	UINT16 ghostmask; // players with a ghost tic
+};
+static_assert(MAXPLAYERS <= 16, "demotic_t masks are 16 bits");
+static std::vector<demotic_t> demotics;
+static std::vector<UINT32> demoghostlens; // every ghost tic, in stream order
 boolean demosynced = true; // console warning message
 
 struct demovars_s demo;
@@ -171,8 +187,13 @@ demoghost *ghosts = NULL;
 //   - Slope physics changed with a scaling fix
 // - 0x000C (Ring Racers v2.2)
 // - 0x000D (Ring Racers v2.3)
+// - 0x000E
+//   - Turning, angle and aiming are stored as the change
+//     from the previous tic, and the tic stream is split
+//     into per-player columns and deflated.
+//     See G_SplitDemoStream() and G_DeflateDemoStream().
 
-#define DEMOVERSION 0x000D
+#define DEMOVERSION 0x000E
 
 boolean G_CompatLevel(UINT16 level)
 {
@@ -459,6 +480,7 @@ void G_ReadDemoExtraData(void)
 void G_WriteDemoExtraData(void)
 {
 	INT32 i, j;
+	UINT8 *extra_p = demobuf.p;
 	char name[64];
 	static_assert(sizeof name >= std::max({MAXPLAYERNAME+1u, SKINNAMESIZE+1u, MAXCOLORNAME+1u}));
 
@@ -568,6 +590,28 @@ void G_WriteDemoExtraData(void)
 	}
 
 	WRITEUINT8(demobuf.p, DW_END);
+
+	// Every tic starts with its extradata
+	if (demobody_p)
+		demotics.push_back({static_cast<UINT32>(demobuf.p - extra_p), 0, 0});
+}
+
+// Since 0x000E, the analog axes are written as the change from the
+// previous tic. Turning and camera angle drift a little every tic, so
+// the small deltas compress far better than the absolute values.
+static INT16 G_ReadDemoAxis(INT16 old)
+{
+	INT16 value = READINT16(demobuf.p);
+
+	if (G_CompatLevel(0x000D))
+		return value;
+
+	return (INT16)(old + value);
+}
+
+static void G_WriteDemoAxis(INT16 value, INT16 old)
+{
+	WRITEINT16(demobuf.p, (INT16)(value - old));
 }
 
 void G_ReadDemoTiccmd(ticcmd_t *cmd, INT32 playernum)
@@ -582,15 +626,15 @@ void G_ReadDemoTiccmd(ticcmd_t *cmd, INT32 playernum)
 	if (ziptic & ZT_FWD)
 		oldcmd[playernum].forwardmove = READSINT8(demobuf.p);
 	if (ziptic & ZT_TURNING)
-		oldcmd[playernum].turning = READINT16(demobuf.p);
+		oldcmd[playernum].turning = G_ReadDemoAxis(oldcmd[playernum].turning);
 	if (ziptic & ZT_ANGLE)
-		oldcmd[playernum].angle = READINT16(demobuf.p);
+		oldcmd[playernum].angle = G_ReadDemoAxis(oldcmd[playernum].angle);
 	if (ziptic & ZT_THROWDIR)
 		oldcmd[playernum].throwdir = READINT16(demobuf.p);
 	if (ziptic & ZT_BUTTONS)
 		oldcmd[playernum].buttons = READUINT16(demobuf.p);
 	if (ziptic & ZT_AIMING)
-		oldcmd[playernum].aiming = READINT16(demobuf.p);
+		oldcmd[playernum].aiming = G_ReadDemoAxis(oldcmd[playernum].aiming);
 	if (ziptic & ZT_LATENCY)
 		oldcmd[playernum].latency = READUINT8(demobuf.p);
 	if (ziptic & ZT_FLAGS)
@@ -640,14 +684,14 @@ void G_WriteDemoTiccmd(ticcmd_t *cmd, INT32 playernum)
 
 	if (cmd->turning != oldcmd[playernum].turning)
 	{
-		WRITEINT16(demobuf.p,cmd->turning);
+		G_WriteDemoAxis(cmd->turning, oldcmd[playernum].turning);
 		oldcmd[playernum].turning = cmd->turning;
 		ziptic |= ZT_TURNING;
 	}
 
 	if (cmd->angle != oldcmd[playernum].angle)
 	{
-		WRITEINT16(demobuf.p,cmd->angle);
+		G_WriteDemoAxis(cmd->angle, oldcmd[playernum].angle);
 		oldcmd[playernum].angle = cmd->angle;
 		ziptic |= ZT_ANGLE;
 	}
@@ -668,7 +712,7 @@ void G_WriteDemoTiccmd(ticcmd_t *cmd, INT32 playernum)
 
 	if (cmd->aiming != oldcmd[playernum].aiming)
 	{
-		WRITEINT16(demobuf.p,cmd->aiming);
+		G_WriteDemoAxis(cmd->aiming, oldcmd[playernum].aiming);
 		oldcmd[playernum].aiming = cmd->aiming;
 		ziptic |= ZT_AIMING;
 	}
@@ -726,6 +770,9 @@ void G_WriteDemoTiccmd(ticcmd_t *cmd, INT32 playernum)
 		WRITEUINT16(botziptic_p, botziptic);
 	}
 
+	if (demobody_p && !demotics.empty())
+		demotics.back().cmdmask |= 1 << playernum;
+
 	// attention here for the ticcmd size!
 	// latest demos with mouse aiming byte in ticcmd
 	if (!(demoflags & DF_GHOST) && ziptic_p > demobuf.end - 9)
@@ -782,6 +829,7 @@ void G_WriteAllGhostTics(void)
 {
 	boolean toobig = false;
 	INT32 i, counter = leveltime;
+	UINT8 *ghost_p;
 	for (i = 0; i < MAXPLAYERS; i++)
 	{
 		if (!playeringame[i] || players[i].spectator)
@@ -796,8 +844,15 @@ void G_WriteAllGhostTics(void)
 			continue;
 
 		WRITEUINT8(demobuf.p, i);
+		ghost_p = demobuf.p;
 		G_WriteGhostTic(players[i].mo, i);
 
+		if (demobody_p && !demotics.empty())
+		{
+			demotics.back().ghostmask |= 1 << i;
+			demoghostlens.push_back(demobuf.p - ghost_p);
+		}
+
 		// attention here for the ticcmd size!
 		// latest demos with mouse aiming byte in ticcmd
 		if (demobuf.p >= demobuf.end - (13 + 9 + 9))
@@ -1642,9 +1697,10 @@ typedef struct rewindinfo_s {
 static tic_t currentrewindnum;
 static rewindinfo_t *rewindhead = NULL; // Reverse chronological order
 
-void G_InitDemoRewind(void)
+void G_InitDemoRewind(boolean clearkeyframes)
 {
-	CL_ClearRewinds();
+	if (clearkeyframes)
+		CL_ClearRewinds();
 
 	while (rewindhead)
 	{
@@ -1666,6 +1722,10 @@ void G_StoreRewindInfo(void)
 		return;
 	timetolog = 8;
 
+	// Already logged on an earlier pass through this part of the demo
+	if (rewindhead && rewindhead->leveltime >= leveltime)
+		return;
+
 	info = static_cast<rewindinfo_t*>(Z_Calloc(sizeof(rewindinfo_t), PU_STATIC, NULL));
 
 	for (i = 0; i < MAXPLAYERS; i++)
@@ -1782,9 +1842,14 @@ void G_ConfirmRewind(tic_t rewindtime)
 		sound_disabled = true; // Prevent sound spam
 		demo.rewinding = true;
 
-		rewind = CL_RewindToTime(rewindtime);
+		rewind = CL_FindRewindPoint(rewindtime);
 
-		if (rewind)
+		if (rewindtime >= leveltime && (rewind == NULL || rewind->leveltime <= leveltime))
+		{
+			// Seeking ahead of any keyframe; playing on from here is quickest.
+			paused = false;
+		}
+		else if (rewind && CL_LoadRewindPoint(rewind))
 		{
 			demobuf.p = demobuf.buffer + rewind->demopos;
 			memcpy(oldcmd, rewind->oldcmd, sizeof (oldcmd));
@@ -2382,6 +2447,11 @@ void G_BeginRecording(void)
 	if (demoflags & DF_LUAVARS)
 		LUA_Archive(&demobuf, false);
 
+	// the tic stream starts here, see G_DeflateDemoStream
+	demobody_p = demobuf.p;
+	demotics.clear();
+	demoghostlens.clear();
+
 	memset(&oldcmd,0,sizeof(oldcmd));
 	memset(&oldghost,0,sizeof(oldghost));
 	memset(&ghostext,0,sizeof(ghostext));
@@ -2446,6 +2516,395 @@ void G_SetDemoTime(UINT32 ptime, UINT32 plap)
 	demotime_p = NULL;
 }
 
+// Since 0x000E, everything from the end of the player list (and Lua
+// variables) up to and including DEMOMARKER is stored as
+//   UINT32 raw length, UINT32 column length, UINT32 deflated length
+// followed by the deflated columns (see G_SplitDemoStream). A deflated
+// length of 0 means the stream is stored raw instead.
+// Extrainfo stays uncompressed behind it, so the replay hut can still
+// seek straight to it through the offset in the header.
+
+// The tic stream interleaves every player's ticcmd with everyone
+// else's, so the same field of the same player only comes back every
+// few dozen bytes. Pulled apart into one column per player and field,
+// the (already delta coded) values sit next to each other and deflate
+// packs them far tighter.
+enum
+{
+	DEMOCOL_TICS, // UINT16 ticcmd mask, UINT16 ghost mask for every tic
+	DEMOCOL_LENGTHS, // extradata and ghost tic lengths
+	DEMOCOL_EXTRA,
+	DEMOCOL_TAIL, // whatever follows the last whole tic, like DEMOMARKER
+	DEMOCOL_PLAYERS,
+};
+
+struct demofield_t
+{
+	UINT16 flag;
+	UINT8 size;
+};
+
+// Same order as G_WriteDemoTiccmd
+static const demofield_t demoticfields[] = {
+	{ZT_FWD, 1},
+	{ZT_TURNING, 2},
+	{ZT_ANGLE, 2},
+	{ZT_THROWDIR, 2},
+	{ZT_BUTTONS, 2},
+	{ZT_AIMING, 2},
+	{ZT_LATENCY, 1},
+	{ZT_FLAGS, 1},
+};
+
+static const demofield_t demobotfields[] = {
+	{ZT_BOT_TURN, 1},
+	{ZT_BOT_SPINDASH, 1},
+	{ZT_BOT_ITEM, 1},
+};
+
+// Columns of each player, starting at DEMOCOL_PLAYERS + playernum*NUMDEMOPCOLS
+enum
+{
+	DEMOPCOL_ZIPTIC,
+	DEMOPCOL_FIELDS,
+	DEMOPCOL_BOTZIPTIC = DEMOPCOL_FIELDS + std::size(demoticfields),
+	DEMOPCOL_BOTFIELDS,
+	DEMOPCOL_GHOST = DEMOPCOL_BOTFIELDS + std::size(demobotfields),
+	NUMDEMOPCOLS
+};
+
+#define NUMDEMOCOLS (DEMOCOL_PLAYERS + MAXPLAYERS*NUMDEMOPCOLS)
+#define DEMOCOLHEADER (4 * (1 + NUMDEMOCOLS)) // UINT32 tic count, UINT32 length of each column
+
+struct democursor_t
+{
+	const UINT8 *p, *end;
+};
+
+static void G_WriteDemoVarint(std::vector<UINT8> &col, UINT32 value)
+{
+	while (value >= 0x80)
+	{
+		col.push_back((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	col.push_back(value);
+}
+
+static boolean G_ReadDemoVarint(democursor_t *col, UINT32 *value)
+{
+	UINT8 shift;
+
+	*value = 0;
+	for (shift = 0; shift < 32 && col->p < col->end; shift += 7)
+	{
+		*value |= (UINT32)(*col->p & 0x7F) << shift;
+		if (!(*col->p++ & 0x80))
+			return true;
+	}
+	return false;
+}
+
+// Moves n bytes of the tic stream to the end of a column
+static boolean G_SplitDemoBytes(democursor_t *stream, std::vector<UINT8> &col, size_t n)
+{
+	if ((size_t)(stream->end - stream->p) < n)
+		return false;
+
+	col.insert(col.end(), stream->p, stream->p + n);
+	stream->p += n;
+	return true;
+}
+
+// Moves n bytes of a column back into the tic stream
+static boolean G_JoinDemoBytes(democursor_t *col, savebuffer_t *stream, size_t n)
+{
+	if ((size_t)(col->end - col->p) < n || (size_t)(stream->end - stream->p) < n)
+		return false;
+
+	M_Memcpy(stream->p, col->p, n);
+	col->p += n;
+	stream->p += n;
+	return true;
+}
+
+static boolean G_SplitDemoFields(democursor_t *stream, std::vector<UINT8> *cols, tcb::span<const demofield_t> fields)
+{
+	UINT16 ziptic;
+	size_t i;
+
+	if (stream->end - stream->p < 2)
+		return false;
+
+	ziptic = stream->p[0] | (stream->p[1] << 8);
+	G_SplitDemoBytes(stream, cols[0], 2);
+
+	for (i = 0; i < fields.size(); i++)
+	{
+		if ((ziptic & fields[i].flag) && !G_SplitDemoBytes(stream, cols[1 + i], fields[i].size))
+			return false;
+	}
+
+	return true;
+}
+
+static boolean G_JoinDemoFields(democursor_t *cols, savebuffer_t *stream, tcb::span<const demofield_t> fields)
+{
+	UINT16 ziptic;
+	size_t i;
+
+	if (cols[0].end - cols[0].p < 2)
+		return false;
+
+	ziptic = cols[0].p[0] | (cols[0].p[1] << 8);
+	if (!G_JoinDemoBytes(&cols[0], stream, 2))
+		return false;
+
+	for (i = 0; i < fields.size(); i++)
+	{
+		if ((ziptic & fields[i].flag) && !G_JoinDemoBytes(&cols[1 + i], stream, fields[i].size))
+			return false;
+	}
+
+	return true;
+}
+
+static boolean G_SplitDemoTiccmd(democursor_t *stream, std::vector<UINT8> *cols)
+{
+	const UINT8 *ziptic_p = stream->p;
+
+	if (!G_SplitDemoFields(stream, &cols[DEMOPCOL_ZIPTIC], demoticfields))
+		return false;
+
+	if (!((ziptic_p[0] | (ziptic_p[1] << 8)) & ZT_BOT))
+		return true;
+
+	return G_SplitDemoFields(stream, &cols[DEMOPCOL_BOTZIPTIC], demobotfields);
+}
+
+static boolean G_JoinDemoTiccmd(democursor_t *cols, savebuffer_t *stream)
+{
+	const UINT8 *ziptic_p = stream->p;
+
+	if (!G_JoinDemoFields(&cols[DEMOPCOL_ZIPTIC], stream, demoticfields))
+		return false;
+
+	if (!((ziptic_p[0] | (ziptic_p[1] << 8)) & ZT_BOT))
+		return true;
+
+	return G_JoinDemoFields(&cols[DEMOPCOL_BOTZIPTIC], stream, demobotfields);
+}
+
+// Cuts the recorded tic stream into columns, following the shape
+// logged in demotics. Should the log and the stream ever disagree,
+// the rest of the stream just goes into DEMOCOL_TAIL as it is.
+static std::vector<UINT8> G_SplitDemoStream(const UINT8 *raw, size_t rawlen)
+{
+	std::vector<UINT8> cols[NUMDEMOCOLS];
+	std::vector<UINT8> out;
+	democursor_t stream = {raw, raw + rawlen};
+	size_t ghost = 0, nextghost, sizes[NUMDEMOCOLS];
+	UINT32 tic;
+	UINT8 *p;
+	INT32 i;
+
+	for (tic = 0; tic < demotics.size(); tic++)
+	{
+		const demotic_t &t = demotics[tic];
+		const UINT8 *start = stream.p;
+		boolean whole;
+
+		for (i = 0; i < NUMDEMOCOLS; i++)
+			sizes[i] = cols[i].size();
+
+		whole = G_SplitDemoBytes(&stream, cols[DEMOCOL_EXTRA], t.extralen);
+
+		for (i = 0; whole && i < MAXPLAYERS; i++)
+		{
+			if (t.cmdmask & (1 << i))
+				whole = G_SplitDemoTiccmd(&stream, &cols[DEMOCOL_PLAYERS + i*NUMDEMOPCOLS]);
+		}
+
+		nextghost = ghost;
+		for (i = 0; whole && i < MAXPLAYERS; i++)
+		{
+			if (!(t.ghostmask & (1 << i)))
+				continue;
+
+			whole = (nextghost < demoghostlens.size() && stream.p < stream.end && *stream.p++ == i
+				&& G_SplitDemoBytes(&stream, cols[DEMOCOL_PLAYERS + i*NUMDEMOPCOLS + DEMOPCOL_GHOST], demoghostlens[nextghost++]));
+		}
+
+		if (!whole || stream.p >= stream.end || *stream.p++ != 0xFF)
+		{
+			for (i = 0; i < NUMDEMOCOLS; i++)
+				cols[i].resize(sizes[i]);
+			stream.p = start;
+			break;
+		}
+
+		cols[DEMOCOL_TICS].push_back(t.cmdmask & 0xFF);
+		cols[DEMOCOL_TICS].push_back(t.cmdmask >> 8);
+		cols[DEMOCOL_TICS].push_back(t.ghostmask & 0xFF);
+		cols[DEMOCOL_TICS].push_back(t.ghostmask >> 8);
+
+		G_WriteDemoVarint(cols[DEMOCOL_LENGTHS], t.extralen);
+		for (; ghost < nextghost; ghost++)
+			G_WriteDemoVarint(cols[DEMOCOL_LENGTHS], demoghostlens[ghost]);
+	}
+
+	cols[DEMOCOL_TAIL].assign(stream.p, stream.end);
+
+	out.resize(DEMOCOLHEADER);
+	p = out.data();
+	WRITEUINT32(p, tic);
+	for (i = 0; i < NUMDEMOCOLS; i++)
+		WRITEUINT32(p, cols[i].size());
+	for (i = 0; i < NUMDEMOCOLS; i++)
+		out.insert(out.end(), cols[i].begin(), cols[i].end());
+
+	return out;
+}
+
+// Interleaves the columns back into exactly rawlen bytes of tic stream
+static boolean G_JoinDemoStream(const UINT8 *columns, size_t len, UINT8 *raw, size_t rawlen)
+{
+	democursor_t cols[NUMDEMOCOLS];
+	const UINT8 *p = columns, *col_p;
+	savebuffer_t stream = {0};
+	UINT32 numtics, tic, collen, extralen, ghostlen;
+	UINT16 cmdmask, ghostmask;
+	INT32 i;
+
+	if (len < DEMOCOLHEADER)
+		return false;
+
+	numtics = READUINT32(p);
+	col_p = columns + DEMOCOLHEADER;
+	for (i = 0; i < NUMDEMOCOLS; i++)
+	{
+		collen = READUINT32(p);
+		if ((size_t)(columns + len - col_p) < collen)
+			return false;
+		cols[i].p = col_p;
+		cols[i].end = col_p += collen;
+	}
+
+	stream.buffer = stream.p = raw;
+	stream.end = raw + rawlen;
+
+	for (tic = 0; tic < numtics; tic++)
+	{
+		if (cols[DEMOCOL_TICS].end - cols[DEMOCOL_TICS].p < 4)
+			return false;
+		cmdmask = READUINT16(cols[DEMOCOL_TICS].p);
+		ghostmask = READUINT16(cols[DEMOCOL_TICS].p);
+
+		if (!G_ReadDemoVarint(&cols[DEMOCOL_LENGTHS], &extralen)
+			|| !G_JoinDemoBytes(&cols[DEMOCOL_EXTRA], &stream, extralen))
+			return false;
+
+		for (i = 0; i < MAXPLAYERS; i++)
+		{
+			if ((cmdmask & (1 << i)) && !G_JoinDemoTiccmd(&cols[DEMOCOL_PLAYERS + i*NUMDEMOPCOLS], &stream))
+				return false;
+		}
+
+		for (i = 0; i < MAXPLAYERS; i++)
+		{
+			if (!(ghostmask & (1 << i)))
+				continue;
+
+			if (stream.p >= stream.end || !G_ReadDemoVarint(&cols[DEMOCOL_LENGTHS], &ghostlen))
+				return false;
+			WRITEUINT8(stream.p, i);
+			if (!G_JoinDemoBytes(&cols[DEMOCOL_PLAYERS + i*NUMDEMOPCOLS + DEMOPCOL_GHOST], &stream, ghostlen))
+				return false;
+		}
+
+		if (stream.p >= stream.end)
+			return false;
+		WRITEUINT8(stream.p, 0xFF);
+	}
+
+	if (!G_JoinDemoBytes(&cols[DEMOCOL_TAIL], &stream, cols[DEMOCOL_TAIL].end - cols[DEMOCOL_TAIL].p))
+		return false;
+
+	// Every column has to be used up, and the stream filled exactly
+	for (i = 0; i < NUMDEMOCOLS; i++)
+	{
+		if (cols[i].p != cols[i].end)
+			return false;
+	}
+
+	return stream.p == stream.end;
+}
+
+static void G_DeflateDemoStream(void)
+{
+	size_t bodypos = demobody_p - demobuf.buffer;
+	size_t infopos = *(UINT32 *)demoinfo_p;
+	size_t rawlen = infopos - bodypos;
+	size_t infolen = (demobuf.p - demobuf.buffer) - infopos;
+	std::vector<UINT8> columns = G_SplitDemoStream(demobody_p, rawlen);
+	std::vector<UINT8> check(rawlen);
+	uLongf packedlen = compressBound(columns.size());
+	savebuffer_t packed = {0};
+	UINT8 *header;
+
+	P_SaveBufferAlloc(&packed, bodypos + 12 + std::max<size_t>(packedlen, rawlen) + infolen);
+	M_Memcpy(packed.buffer, demobuf.buffer, bodypos);
+	packed.p = packed.buffer + bodypos + 12;
+
+	// A replay that can't be read back is worse than a big one
+	if (!G_JoinDemoStream(columns.data(), columns.size(), check.data(), rawlen)
+		|| memcmp(check.data(), demobody_p, rawlen) != 0
+		|| compress2(packed.p, &packedlen, columns.data(), columns.size(), Z_BEST_COMPRESSION) != Z_OK
+		|| packedlen >= rawlen)
+	{
+		M_Memcpy(packed.p, demobody_p, rawlen);
+		packedlen = 0;
+	}
+
+	header = packed.buffer + bodypos;
+	WRITEUINT32(header, rawlen);
+	WRITEUINT32(header, packedlen ? columns.size() : 0);
+	WRITEUINT32(header, packedlen);
+	packed.p += (packedlen ? packedlen : rawlen);
+
+	CONS_Debug(DBG_DEMO, "Demo tic stream: %s bytes raw, %s tics in %s bytes of columns, %s bytes deflated\n",
+		sizeu1(rawlen), sizeu2(demotics.size()), sizeu3(columns.size()), sizeu4(packedlen));
+
+	if (cht_debug & DBG_DEMO)
+	{
+		// For comparison, what deflating the interleaved stream gets
+		uLongf flatlen = compressBound(rawlen);
+		std::vector<UINT8> flat(flatlen);
+
+		if (compress2(flat.data(), &flatlen, demobody_p, rawlen, Z_BEST_COMPRESSION) == Z_OK)
+			CONS_Debug(DBG_DEMO, "Demo tic stream: %s bytes deflated without columns\n", sizeu1(flatlen));
+	}
+
+	demotics.clear();
+	demotics.shrink_to_fit();
+	demoghostlens.clear();
+	demoghostlens.shrink_to_fit();
+
+	// Move the header pointers over to the new buffer
+	demoinfo_p = packed.buffer + (demoinfo_p - demobuf.buffer);
+	*(UINT32 *)demoinfo_p = packed.p - packed.buffer;
+	if (demotime_p)
+		demotime_p = packed.buffer + (demotime_p - demobuf.buffer);
+
+	M_Memcpy(packed.p, demobuf.buffer + infopos, infolen);
+	packed.p += infolen;
+
+	Z_Free(demobuf.buffer);
+	demobuf = packed;
+	Z_SetUser(demobuf.buffer, (void**)&demobuf.buffer);
+	demobody_p = NULL;
+}
+
 // Returns bitfield:
 // 1 == new demo has lower time
 // 2 == new demo has higher score
@@ -2530,6 +2989,7 @@ UINT8 G_CmpDemoTime(char *oldname, char *newname)
 	case 0x000A: // 2.0, 2.1
 	case 0x000B: // 2.2 indev (staff ghosts)
 	case 0x000C: // 2.2
+	case 0x000D: // 2.3
 		break;
 	// too old, cannot support.
 	default:
@@ -2682,6 +3142,7 @@ void G_LoadDemoInfo(menudemo_t *pdemo, boolean allownonmultiplayer)
 	case 0x000A: // 2.0, 2.1
 	case 0x000B: // 2.2 indev (staff ghosts)
 	case 0x000C: // 2.2
+	case 0x000D: // 2.3
 		if (P_SaveBufferRemaining(&info) < 64)
 		{
 			goto corrupt;
@@ -2919,6 +3380,54 @@ badreplay:
 	P_SaveBufferFree(&info);
 }
 
+// Expands the tic stream written by G_DeflateDemoStream. On success,
+// buf holds the untouched header followed by the raw tic stream (the
+// extrainfo is dropped) and *p points at the start of the stream.
+static boolean G_InflateDemoStream(savebuffer_t *buf, UINT8 **p, INT32 tag)
+{
+	size_t bodypos = *p - buf->buffer;
+	savebuffer_t raw = {0};
+	std::vector<UINT8> columns;
+	UINT32 rawlen, columnlen, packedlen;
+	uLongf outlen;
+
+	if (buf->end - *p < 12)
+		return false;
+
+	rawlen = READUINT32(*p);
+	columnlen = READUINT32(*p);
+	packedlen = READUINT32(*p);
+
+	if (rawlen == 0 || (size_t)(buf->end - *p) < (packedlen ? packedlen : rawlen))
+		return false;
+
+	// The columns only add a few bytes of bookkeeping per tic
+	if (packedlen && (columnlen < DEMOCOLHEADER || (columnlen - DEMOCOLHEADER) / 4 > rawlen))
+		return false;
+
+	P_SaveBufferZAlloc(&raw, bodypos + rawlen, tag, NULL);
+	M_Memcpy(raw.buffer, buf->buffer, bodypos);
+
+	if (packedlen == 0)
+		M_Memcpy(raw.buffer + bodypos, *p, rawlen);
+	else
+	{
+		columns.resize(columnlen);
+		outlen = columnlen;
+		if (uncompress(columns.data(), &outlen, *p, packedlen) != Z_OK || outlen != columnlen
+			|| !G_JoinDemoStream(columns.data(), columnlen, raw.buffer + bodypos, rawlen))
+		{
+			P_SaveBufferFree(&raw);
+			return false;
+		}
+	}
+
+	Z_Free(buf->buffer);
+	*buf = raw;
+	*p = buf->p = buf->buffer + bodypos;
+	return true;
+}
+
 //
 // G_PlayDemo
 //
@@ -2958,7 +3467,8 @@ void G_DoPlayDemoEx(const char *defdemoname, lumpnum_t deflumpnum)
 	boolean skiperrors = true;
 #endif
 
-	G_InitDemoRewind();
+	// Restarting the current demo keeps its keyframes, they still match demobuf.
+	G_InitDemoRewind(defdemoname != NULL || deflumpnum != LUMPERROR);
 
 	gtname[MAXGAMETYPELENGTH-1] = '\0';
 
@@ -3112,6 +3622,7 @@ void G_DoPlayDemoEx(const char *defdemoname, lumpnum_t deflumpnum)
 	case 0x000A: // 2.0, 2.1
 	case 0x000B: // 2.2 indev (staff ghosts)
 	case 0x000C: // 2.2
+	case 0x000D: // 2.3
 		break;
 	// too old, cannot support.
 	default:
@@ -3487,6 +3998,22 @@ void G_DoPlayDemoEx(const char *defdemoname, lumpnum_t deflumpnum)
 		LUA_UnArchive(&demobuf, false);
 	}
 
+	// A restarted demo was already inflated the first time around.
+	if (demo.version >= 0x000E && (defdemoname != NULL || deflumpnum != LUMPERROR)
+		&& !G_InflateDemoStream(&demobuf, &demobuf.p, PU_STATIC))
+	{
+		snprintf(msg, 1024, M_GetText("%s has a corrupt tic stream.\n"), pdemoname);
+		CONS_Alert(CONS_ERROR, "%s", msg);
+		M_StartMessage("Demo Playback", msg, NULL, MM_NOTHING, NULL, "Return to Menu");
+		Z_Free(demo.skinlist);
+		demo.skinlist = NULL;
+		Z_Free(pdemoname);
+		Z_Free(demobuf.buffer);
+		demo.playback = false;
+		return;
+	}
+	Z_SetUser(demobuf.buffer, (void**)&demobuf.buffer);
+
 	splitscreen = 0;
 
 	if (demo.attract == DEMO_ATTRACT_TITLE)
@@ -3577,6 +4104,7 @@ void G_AddGhost(savebuffer_t *buffer, const char *defdemoname)
 	case 0x000A: // 2.0, 2.1
 	case 0x000B: // 2.2 indev (staff ghosts)
 	case 0x000C: // 2.2
+	case 0x000D: // 2.3
 		break;
 	// too old, cannot support.
 	default:
@@ -3730,6 +4258,14 @@ void G_AddGhost(savebuffer_t *buffer, const char *defdemoname)
 		return;
 	}
 
+	if (ghostversion >= 0x000E && !G_InflateDemoStream(buffer, &p, PU_LEVEL))
+	{
+		CONS_Alert(CONS_NOTICE, M_GetText("Failed to add ghost %s: Corrupt tic stream\n"), defdemoname);
+		Z_Free(skinlist);
+		P_SaveBufferFree(buffer);
+		return;
+	}
+
 
 	gh = static_cast<demoghost*>(Z_Calloc(sizeof(demoghost), PU_LEVEL, NULL));
 	gh->sizes = ghostsizes;
@@ -3840,6 +4376,7 @@ staffbrief_t *G_GetStaffGhostBrief(UINT8 *buffer)
 		case 0x000A: // 2.0, 2.1
 		case 0x000B: // 2.2 indev (staff ghosts)
 		case 0x000C: // 2.2
+		case 0x000D: // 2.3
 			break;
 
 		// too old, cannot support.
@@ -3930,6 +4467,121 @@ fail:
 //
 static INT32 restorecv_vidwait;
 
+// Simulation cost gathered from every tic of a timed demo
+static struct
+{
+	std::vector<precise_t> ptickertimes;
+	precise_t thlisttimes[NUM_ACTIVETHINKERLISTS];
+	precise_t acstime;
+	precise_t luatime;
+	UINT64 luamobjhooks;
+	UINT64 checkpositioncalls;
+	int maxcheckpositioncalls;
+} timedemostats;
+
+static void G_ResetTimeDemoStats(void)
+{
+	timedemostats.ptickertimes.clear();
+	memset(timedemostats.thlisttimes, 0, sizeof timedemostats.thlisttimes);
+	timedemostats.acstime = 0;
+	timedemostats.luatime = 0;
+	timedemostats.luamobjhooks = 0;
+	timedemostats.checkpositioncalls = 0;
+	timedemostats.maxcheckpositioncalls = 0;
+}
+
+// Called after P_Ticker while timing a demo
+void G_SampleTimeDemoTic(void)
+{
+	size_t i;
+
+	timedemostats.ptickertimes.push_back(ps_pticker_time);
+
+	for (i = 0; i < NUM_ACTIVETHINKERLISTS; i++)
+		timedemostats.thlisttimes[i] += ps_thlist_times[i];
+
+	timedemostats.acstime += ps_acs_time;
+	timedemostats.luatime += ps_lua_thinkframe_time;
+	timedemostats.luamobjhooks += ps_lua_mobjhooks;
+	timedemostats.checkpositioncalls += ps_checkposition_calls;
+	timedemostats.maxcheckpositioncalls = std::max(timedemostats.maxcheckpositioncalls, ps_checkposition_calls);
+}
+
+// Appends the timing results as a line of JSON to timedemo.json
+static void G_WriteTimeDemoJSON(INT32 demotime)
+{
+	using json = nlohmann::json;
+
+	const double usecs = 1000000.0 / I_GetPrecisePrecision();
+	std::vector<precise_t> sorted = timedemostats.ptickertimes;
+	const size_t tics = sorted.size();
+	const char *jsonpath = va("%s" PATHSEP "%s", srb2home, "timedemo.json");
+	json result;
+	FILE *f;
+
+	std::sort(sorted.begin(), sorted.end());
+
+	// nearest-rank percentile, in microseconds
+	auto percentile = [&](double p) -> double
+	{
+		if (tics == 0)
+			return 0.0;
+		size_t rank = static_cast<size_t>(std::ceil(p * tics));
+		return sorted[std::clamp<size_t>(rank, 1, tics) - 1] * usecs;
+	};
+
+	double totalpticker = 0.0;
+	for (precise_t t : sorted)
+		totalpticker += t * usecs;
+
+	result["id"] = timedemo_csv_id;
+	result["demo"] = timedemo_name;
+	result["map"] = G_BuildMapName(gamemap);
+	result["version"] = {{"branch", compbranch}, {"revision", comprevision}};
+	result["nodraw"] = static_cast<bool>(nodrawers);
+	result["ticrate"] = TICRATE;
+	result["leveltime"] = leveltime;
+	result["seconds"] = static_cast<double>(demotime) / TICRATE;
+	result["frames"] = framecount;
+	result["tics"] = tics;
+	result["pticker_us"] = {
+		{"total", totalpticker},
+		{"mean", tics ? totalpticker / tics : 0.0},
+		{"p50", percentile(0.50)},
+		{"p95", percentile(0.95)},
+		{"p99", percentile(0.99)},
+		{"max", tics ? sorted.back() * usecs : 0.0},
+	};
+	result["thinkers_us"] = {
+		{"polyobjects", timedemostats.thlisttimes[THINK_POLYOBJ] * usecs},
+		{"main", timedemostats.thlisttimes[THINK_MAIN] * usecs},
+		{"mobjs", timedemostats.thlisttimes[THINK_MOBJ] * usecs},
+		{"dynslopes", timedemostats.thlisttimes[THINK_DYNSLOPE] * usecs},
+	};
+	result["acs_us"] = timedemostats.acstime * usecs;
+	result["lua_thinkframe_us"] = timedemostats.luatime * usecs;
+	result["lua_mobjhooks"] = timedemostats.luamobjhooks;
+	result["checkposition_calls"] = {
+		{"total", timedemostats.checkpositioncalls},
+		{"mean", tics ? static_cast<double>(timedemostats.checkpositioncalls) / tics : 0.0},
+		{"max", timedemostats.maxcheckpositioncalls},
+	};
+
+	f = fopen(jsonpath, "a");
+
+	if (f)
+	{
+		fprintf(f, "%s\n", result.dump().c_str());
+		fclose(f);
+		CONS_Printf("Timedemo results saved to '%s'\n", jsonpath);
+	}
+	else
+	{
+		// Just print the JSON output to console
+		CONS_Printf("%s\n", result.dump().c_str());
+	}
+}
+
 void G_TimeDemo(const char *name)
 {
 	nodrawers = M_CheckParm("-nodraw");
@@ -3941,6 +4593,7 @@ void G_TimeDemo(const char *name)
 	g_singletics = true;
 	framecount = 0;
 	demostarttime = I_GetTime();
+	G_ResetTimeDemoStats();
 	G_DeferedPlayDemo(name);
 }
 
@@ -3949,6 +4602,7 @@ void G_DoneLevelLoad(void)
 	CONS_Printf(M_GetText("Loaded level in %f sec\n"), (double)(I_GetTime() - demostarttime) / TICRATE);
 	framecount = 0;
 	demostarttime = I_GetTime();
+	G_ResetTimeDemoStats();
 }
 
 /*
@@ -4028,6 +4682,12 @@ static void G_StopTimingDemo(void)
 		}
 	}
 
+	// JSON timedemo results, including the cost of the simulation alone
+	if (timedemo_json)
+	{
+		G_WriteTimeDemoJSON(demotime);
+	}
+
 	if (restorecv_vidwait != cv_vidwait.value)
 		CV_SetValue(&cv_vidwait, restorecv_vidwait);
 
@@ -4152,6 +4812,12 @@ void G_SaveDemo(void)
 	}
 	WRITEUINT8(demobuf.p, DW_END); // Mark end of demo extra data.
 
+	if (demobody_p && demoinfo_p)
+	{
+		G_DeflateDemoStream();
+		p = demobuf.buffer+16;
+	}
+
 	M_Memcpy(p, demo.titlename, 64); // Write demo title here
 	p += 64;
 
@@ -187,7 +187,7 @@ void G_ConsAllGhostTics(void);
 void G_ConsGhostTic(INT32 playernum);
 void G_GhostTicker(void);
 
-void G_InitDemoRewind(void);
+void G_InitDemoRewind(boolean clearkeyframes);
 void G_StoreRewindInfo(void);
 void G_PreviewRewind(tic_t previewtime);
 void G_ConfirmRewind(tic_t rewindtime);
@@ -232,6 +232,7 @@ void G_AddGhost(savebuffer_t *buffer, const char *defdemoname);
 staffbrief_t *G_GetStaffGhostBrief(UINT8 *buffer);
 void G_FreeGhosts(void);
 void G_DoneLevelLoad(void);
+void G_SampleTimeDemoTic(void);
 
 void G_StopDemo(void);
 boolean G_CheckDemoStatus(void);
@@ -75,6 +75,7 @@
 #include "k_objects.h"
 #include "k_credits.h"
 #include "g_gamedata.h"
+#include "m_perfstats.h"
 
 #ifdef HAVE_DISCORDRPC
 #include "discord.h"
@@ -1916,7 +1917,11 @@ void G_Ticker(boolean run)
 		case GS_LEVEL:
 			if (demo.attract)
 				F_AttractDemoTicker();
+			ps_pticker_time = I_GetPreciseTime();
 			P_Ticker(run); // tic the game
+			ps_pticker_time = I_GetPreciseTime() - ps_pticker_time;
+			if (demo.timing && run)
+				G_SampleTimeDemoTic();
 			F_TextPromptTicker();
 			AM_Ticker();
 			HU_Ticker();
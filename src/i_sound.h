@@ -170,6 +170,37 @@ void I_UpdateSongLagConditions (void);
 */
 boolean I_LoadSong(char *data, size_t len);
 
+/**	\brief	Starts loading a song in the background, so a later
+	::I_LoadPrefetchedSong doesn't have to decode its headers on the
+	game thread. Only one song is prefetched at a time.
+
+	\param	name	song name, to match against ::I_LoadPrefetchedSong
+	\param	data	pointer to song data, copied before this returns
+	\param	len	len of data
+
+	\return	true if the song is loading
+*/
+boolean I_PrefetchSong(const char *name, char *data, size_t len);
+
+/**	\brief	Same as ::I_LoadSong, with the song from ::I_PrefetchSong.
+	Waits for the load to finish if it hasn't yet.
+
+	\param	name	song name
+
+	\return	false if the song wasn't prefetched or couldn't be loaded;
+		the caller should use ::I_LoadSong instead
+*/
+boolean I_LoadPrefetchedSong(const char *name);
+
+/**	\brief	Forgets the song from ::I_PrefetchSong, unless it's the one
+	named. Never waits; a song that's still loading is kept.
+
+	\param	keep	song name to hold on to, or NULL
+
+	\return	void
+*/
+void I_DropPrefetchedSong(const char *keep);
+
 /**	\brief	See ::I_LoadSong, then think backwards
 
 	\param	handle	song handle
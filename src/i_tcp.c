@@ -14,6 +14,7 @@
 ///        Just use ifdef for OS-dependent parts.
 
 #include "i_tcp_detail.h"
+#include "i_tcp_thread.h"
 #include "i_system.h"
 #include "i_time.h"
 #include "i_net.h"
@@ -38,23 +39,6 @@
 
 #define DEFAULTPORT "5029"
 
-#ifdef USE_WINSOCK
-	typedef SOCKET SOCKET_TYPE;
-	#define ERRSOCKET (SOCKET_ERROR)
-#else
-	#if (defined (__unix__) && !defined (MSDOS)) || defined (__APPLE__) || defined (__HAIKU__)
-		typedef int SOCKET_TYPE;
-	#else
-		typedef unsigned long SOCKET_TYPE;
-	#endif
-	#define ERRSOCKET (-1)
-#endif
-
-// define socklen_t in Windows if it is not already defined
-#ifdef USE_WINSOCK1
-	typedef int socklen_t;
-#endif
-
 typedef struct
 {
 	mysockaddr_t address;
@@ -420,15 +404,80 @@ static boolean hole_punch(ssize_t c)
 	}
 }
 
+// Finds the node for a datagram already in doomcom->data.
+// Returns true if it came from a new node, false in all other cases.
+static boolean SOCK_AcceptPacket(SOCKET_TYPE socket, mysockaddr_t *fromaddress, socklen_t fromlen, ssize_t c)
+{
+	int j;
+
+	doomcom->remotenode = -1; // no packet
+
+#ifdef USE_STUN
+	if (STUN_got_response(doomcom->data, c))
+	{
+		return false;
+	}
+#endif
+
+	if (hole_punch(c))
+	{
+		return false;
+	}
+
+	// find remote node number
+	for (j = 1; j <= MAXNETNODES; j++) //include LAN
+	{
+		if (SOCK_cmpaddr(fromaddress, &clientaddress[j], 0))
+		{
+			doomcom->remotenode = (INT16)j; // good packet from a game player
+			doomcom->datalength = (INT16)c;
+			nodesocket[j] = socket;
+			return false;
+		}
+	}
+	// not found
+
+	// find a free slot
+	j = getfreenode();
+	if (j > 0)
+	{
+		M_Memcpy(&clientaddress[j], fromaddress, fromlen);
+		nodesocket[j] = socket;
+		DEBFILE(va("New node detected: node:%d address:%s\n", j,
+				SOCK_GetNodeAddress(j)));
+		doomcom->remotenode = (INT16)j; // good packet from a game player
+		doomcom->datalength = (INT16)c;
+
+		return true;
+	}
+	else
+		DEBFILE("New node detected: No more free slots\n");
+
+	return false;
+}
+
 // Returns true if a packet was received from a new node, false in all other cases
 static boolean SOCK_Get(void)
 {
 	size_t n;
-	int j;
 	ssize_t c;
 	mysockaddr_t fromaddress;
 	socklen_t fromlen;
 
+	if (I_NetThreadActive())
+	{
+		static tcppacket_t packet;
+
+		if (!I_NetThreadReceive(&packet))
+		{
+			doomcom->remotenode = -1; // no packet
+			return false;
+		}
+
+		M_Memcpy(doomcom->data, packet.data, packet.length);
+		return SOCK_AcceptPacket(packet.socket, &packet.address, packet.addresslen, packet.length);
+	}
+
 	for (n = 0; n < mysocketses; n++)
 	{
 		fromlen = (socklen_t)sizeof(fromaddress);
@@ -436,46 +485,7 @@ static boolean SOCK_Get(void)
 			(void *)&fromaddress, &fromlen);
 		if (c > 0)
 		{
-#ifdef USE_STUN
-			if (STUN_got_response(doomcom->data, c))
-			{
-				break;
-			}
-#endif
-
-			if (hole_punch(c))
-			{
-				break;
-			}
-
-			// find remote node number
-			for (j = 1; j <= MAXNETNODES; j++) //include LAN
-			{
-				if (SOCK_cmpaddr(&fromaddress, &clientaddress[j], 0))
-				{
-					doomcom->remotenode = (INT16)j; // good packet from a game player
-					doomcom->datalength = (INT16)c;
-					nodesocket[j] = mysockets[n];
-					return false;
-				}
-			}
-			// not found
-
-			// find a free slot
-			j = getfreenode();
-			if (j > 0)
-			{
-				M_Memcpy(&clientaddress[j], &fromaddress, fromlen);
-				nodesocket[j] = mysockets[n];
-				DEBFILE(va("New node detected: node:%d address:%s\n", j,
-						SOCK_GetNodeAddress(j)));
-				doomcom->remotenode = (INT16)j; // good packet from a game player
-				doomcom->datalength = (INT16)c;
-
-				return true;
-			}
-			else
-				DEBFILE("New node detected: No more free slots\n");
+			return SOCK_AcceptPacket(mysockets[n], &fromaddress, fromlen, c);
 		}
 	}
 
@@ -511,6 +521,9 @@ static boolean SOCK_CanSend(void)
 	fd_set tset;
 	int wselect;
 
+	if (I_NetThreadActive())
+		return I_NetThreadCanSend();
+
 	if(!FD_CPY(&masterset, &tset, mysockets, mysocketses))
 		return false;
 	wselect = select(255, NULL, &tset, NULL, &timeval_for_select);
@@ -525,6 +538,9 @@ static boolean SOCK_CanGet(void)
 	fd_set tset;
 	int rselect;
 
+	if (I_NetThreadActive())
+		return I_NetThreadCanReceive();
+
 	if(!FD_CPY(&masterset, &tset, mysockets, mysocketses))
 		return false;
 	rselect = select(255, &tset, NULL, NULL, &timeval_for_select);
@@ -534,7 +550,7 @@ static boolean SOCK_CanGet(void)
 }
 #endif
 
-static inline ssize_t SOCK_SendToAddr(SOCKET_TYPE socket, mysockaddr_t *sockaddr)
+static inline ssize_t SOCK_SendToAddr(SOCKET_TYPE socket, mysockaddr_t *sockaddr, boolean reporterror)
 {
 	socklen_t d4 = (socklen_t)sizeof(struct sockaddr_in);
 #ifdef HAVE_IPV6
@@ -551,6 +567,21 @@ static inline ssize_t SOCK_SendToAddr(SOCKET_TYPE socket, mysockaddr_t *sockaddr
 		default:       d = da; break;
 	}
 
+	if (I_NetThreadActive())
+	{
+		static tcppacket_t packet;
+
+		packet.socket = socket;
+		packet.address = *sockaddr;
+		packet.addresslen = d;
+		packet.reporterror = reporterror;
+		packet.length = doomcom->datalength;
+		M_Memcpy(packet.data, doomcom->data, doomcom->datalength);
+		I_NetThreadSend(&packet);
+
+		return doomcom->datalength;
+	}
+
 	return sendto(socket, (char *)&doomcom->data, doomcom->datalength, 0, &sockaddr->any, d);
 }
 
@@ -562,6 +593,14 @@ static void SOCK_Send(void)
 	if (!nodeconnected[doomcom->remotenode])
 		return;
 
+	if (I_NetThreadActive())
+	{
+		// Sends are asynchronous, so this is an error from an earlier packet
+		int e = I_NetThreadSendError();
+		if (e != 0)
+			I_Error("SOCK_Send, error sending #%u: %s", e, strerror(e));
+	}
+
 	if (doomcom->remotenode == BROADCASTADDR)
 	{
 		for (i = 0; i < mysocketses; i++)
@@ -569,7 +608,7 @@ static void SOCK_Send(void)
 			for (j = 0; j < broadcastaddresses; j++)
 			{
 				if (myfamily[i] == broadcastaddress[j].any.sa_family)
-					SOCK_SendToAddr(mysockets[i], &broadcastaddress[j]);
+					SOCK_SendToAddr(mysockets[i], &broadcastaddress[j], false);
 			}
 		}
 		return;
@@ -579,13 +618,13 @@ static void SOCK_Send(void)
 		for (i = 0; i < mysocketses; i++)
 		{
 			if (myfamily[i] == clientaddress[doomcom->remotenode].any.sa_family)
-				SOCK_SendToAddr(mysockets[i], &clientaddress[doomcom->remotenode]);
+				SOCK_SendToAddr(mysockets[i], &clientaddress[doomcom->remotenode], false);
 		}
 		return;
 	}
 	else
 	{
-		c = SOCK_SendToAddr(nodesocket[doomcom->remotenode], &clientaddress[doomcom->remotenode]);
+		c = SOCK_SendToAddr(nodesocket[doomcom->remotenode], &clientaddress[doomcom->remotenode], true);
 	}
 
 	if (c == ERRSOCKET)
@@ -1009,6 +1048,9 @@ boolean I_InitTcpDriver(void)
 static void SOCK_CloseSocket(void)
 {
 	size_t i;
+
+	I_StopNetThread();
+
 	for (i=0; i < MAXNETNODES+1; i++)
 	{
 		if (mysockets[i] != (SOCKET_TYPE)ERRSOCKET
@@ -1174,7 +1216,14 @@ static boolean SOCK_OpenSocket(void)
 
 	// build the socket but close it first
 	SOCK_CloseSocket();
-	return UDP_Socket();
+	if (!UDP_Socket())
+		return false;
+
+	// Dedicated hosts running many instances can move socket I/O off the game thread
+	if (M_CheckParm("-netthread"))
+		I_StartNetThread(mysockets, mysocketses);
+
+	return true;
 }
 
 // https://github.com/jameds/holepunch/blob/master/holepunch.c#L75
@@ -119,6 +119,23 @@ extern "C" {
 #include "doomtype.h"
 #include "i_tcp.h"
 
+#ifdef USE_WINSOCK
+	typedef SOCKET SOCKET_TYPE;
+	#define ERRSOCKET (SOCKET_ERROR)
+#else
+	#if (defined (__unix__) && !defined (MSDOS)) || defined (__APPLE__) || defined (__HAIKU__)
+		typedef int SOCKET_TYPE;
+	#else
+		typedef unsigned long SOCKET_TYPE;
+	#endif
+	#define ERRSOCKET (-1)
+#endif
+
+// define socklen_t in Windows if it is not already defined
+#ifdef USE_WINSOCK1
+	typedef int socklen_t;
+#endif
+
 union mysockaddr_t
 {
 	struct sockaddr     any;
@@ -0,0 +1,310 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  i_tcp_thread.cpp
+/// \brief Optional thread that does the socket I/O for i_tcp.c
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "i_tcp_thread.h"
+
+#if !defined (USE_WINSOCK)
+#include <poll.h>
+#endif
+
+#include "core/spsc_ring.hpp"
+
+namespace
+{
+
+// Packets queued in each direction. A full incoming ring drops, the
+// same as a full socket buffer would.
+constexpr size_t kRingSize = 256;
+
+// Datagrams moved per recvmmsg/sendmmsg call.
+constexpr int kBatchSize = 32;
+
+// How long the thread sleeps on the sockets when it has nothing to
+// send. This is the worst case delay added to an outgoing packet.
+constexpr int kWaitMs = 1;
+
+struct NetThread
+{
+	std::vector<SOCKET_TYPE> sockets;
+	srb2::SpScRing<tcppacket_t> incoming {kRingSize};
+	srb2::SpScRing<tcppacket_t> outgoing {kRingSize};
+	std::atomic<bool> stop {false};
+	std::atomic<int> senderror {0};
+	std::thread thread;
+
+	// Only touched by the network thread
+	tcppacket_t batch[kBatchSize];
+};
+
+std::unique_ptr<NetThread> g_net;
+
+void wait_for_sockets(const NetThread& net)
+{
+#ifdef USE_WINSOCK
+	fd_set set;
+	struct timeval timeout = {0, kWaitMs * 1000};
+
+	FD_ZERO(&set);
+	for (SOCKET_TYPE s : net.sockets)
+	{
+		FD_SET(s, &set);
+	}
+	select(0, &set, NULL, NULL, &timeout);
+#else
+	struct pollfd fds[MAXNETNODES+1];
+	size_t count = net.sockets.size();
+
+	for (size_t i = 0; i < count; i++)
+	{
+		fds[i].fd = net.sockets[i];
+		fds[i].events = POLLIN;
+		fds[i].revents = 0;
+	}
+	poll(fds, count, kWaitMs);
+#endif
+}
+
+// Fills net.batch with datagrams from s, returns how many were read.
+int receive_batch(NetThread& net, SOCKET_TYPE s)
+{
+	int count = 0;
+
+#ifdef __linux__
+	struct mmsghdr msgs[kBatchSize] = {};
+	struct iovec iov[kBatchSize];
+
+	for (int i = 0; i < kBatchSize; i++)
+	{
+		iov[i].iov_base = net.batch[i].data;
+		iov[i].iov_len = MAXPACKETLENGTH;
+		msgs[i].msg_hdr.msg_name = &net.batch[i].address;
+		msgs[i].msg_hdr.msg_namelen = sizeof(mysockaddr_t);
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	count = recvmmsg(s, msgs, kBatchSize, MSG_DONTWAIT, NULL);
+	if (count <= 0)
+	{
+		return 0;
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		net.batch[i].addresslen = msgs[i].msg_hdr.msg_namelen;
+		net.batch[i].length = static_cast<INT16>(msgs[i].msg_len);
+	}
+#else
+	while (count < kBatchSize)
+	{
+		tcppacket_t& packet = net.batch[count];
+		socklen_t fromlen = sizeof(mysockaddr_t);
+		ssize_t c = recvfrom(s, packet.data, MAXPACKETLENGTH, 0, &packet.address.any, &fromlen);
+
+		if (c < 0)
+		{
+			break;
+		}
+
+		packet.addresslen = fromlen;
+		packet.length = static_cast<INT16>(c);
+		count++;
+	}
+#endif
+
+	for (int i = 0; i < count; i++)
+	{
+		net.batch[i].socket = s;
+	}
+
+	return count;
+}
+
+void receive(NetThread& net)
+{
+	for (SOCKET_TYPE s : net.sockets)
+	{
+		int count;
+
+		do
+		{
+			count = receive_batch(net, s);
+
+			for (int i = 0; i < count; i++)
+			{
+				// Empty datagrams are only ever hole punching noise
+				if (net.batch[i].length > 0)
+				{
+					net.incoming.try_push(net.batch[i]);
+				}
+			}
+		} while (count == kBatchSize);
+	}
+}
+
+void send_failed(NetThread& net, const tcppacket_t& packet, int e)
+{
+	int none = 0;
+
+	if (!packet.reporterror || e == ECONNREFUSED || e == EWOULDBLOCK)
+	{
+		return;
+	}
+
+	net.senderror.compare_exchange_strong(none, e);
+}
+
+// Sends count packets of net.batch that all go through socket s.
+void send_batch(NetThread& net, tcppacket_t* packets, int count, SOCKET_TYPE s)
+{
+#ifdef __linux__
+	struct mmsghdr msgs[kBatchSize] = {};
+	struct iovec iov[kBatchSize];
+	int done = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		iov[i].iov_base = packets[i].data;
+		iov[i].iov_len = packets[i].length;
+		msgs[i].msg_hdr.msg_name = &packets[i].address;
+		msgs[i].msg_hdr.msg_namelen = packets[i].addresslen;
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	while (done < count)
+	{
+		int sent = sendmmsg(s, msgs + done, count - done, 0);
+
+		if (sent < 0)
+		{
+			// Skip the packet that failed and carry on with the rest
+			send_failed(net, packets[done], errno);
+			done++;
+		}
+		else
+		{
+			done += sent;
+		}
+	}
+#else
+	for (int i = 0; i < count; i++)
+	{
+		if (sendto(s, packets[i].data, packets[i].length, 0, &packets[i].address.any, packets[i].addresslen) < 0)
+		{
+			send_failed(net, packets[i], errno);
+		}
+	}
+#endif
+}
+
+void send(NetThread& net)
+{
+	int count = 0;
+	int start = 0;
+
+	while (count < kBatchSize && net.outgoing.try_pop(net.batch[count]))
+	{
+		count++;
+	}
+
+	// One call per run of packets on the same socket
+	for (int i = 1; i <= count; i++)
+	{
+		if (i == count || net.batch[i].socket != net.batch[start].socket)
+		{
+			send_batch(net, &net.batch[start], i - start, net.batch[start].socket);
+			start = i;
+		}
+	}
+}
+
+void net_thread_main(NetThread* net)
+{
+	while (!net->stop.load(std::memory_order_relaxed))
+	{
+		if (net->outgoing.empty())
+		{
+			wait_for_sockets(*net);
+		}
+
+		send(*net);
+		receive(*net);
+	}
+}
+
+} // namespace
+
+boolean I_StartNetThread(const SOCKET_TYPE *sockets, size_t numsockets)
+{
+	I_StopNetThread();
+
+	if (numsockets == 0)
+	{
+		return false;
+	}
+
+	g_net = std::make_unique<NetThread>();
+	g_net->sockets.assign(sockets, sockets + numsockets);
+	g_net->thread = std::thread(net_thread_main, g_net.get());
+
+	return true;
+}
+
+void I_StopNetThread(void)
+{
+	if (!g_net)
+	{
+		return;
+	}
+
+	g_net->stop.store(true, std::memory_order_relaxed);
+	g_net->thread.join();
+	g_net.reset();
+}
+
+boolean I_NetThreadActive(void)
+{
+	return g_net != nullptr;
+}
+
+boolean I_NetThreadReceive(tcppacket_t *packet)
+{
+	return g_net->incoming.try_pop(*packet);
+}
+
+void I_NetThreadSend(const tcppacket_t *packet)
+{
+	while (!g_net->outgoing.try_push(*packet))
+	{
+		std::this_thread::yield();
+	}
+}
+
+boolean I_NetThreadCanReceive(void)
+{
+	return !g_net->incoming.empty();
+}
+
+boolean I_NetThreadCanSend(void)
+{
+	return !g_net->outgoing.full();
+}
+
+int I_NetThreadSendError(void)
+{
+	return g_net->senderror.exchange(0);
+}
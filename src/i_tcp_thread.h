@@ -0,0 +1,60 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  i_tcp_thread.h
+/// \brief Optional thread that does the socket I/O for i_tcp.c
+///
+///        The game thread keeps the node tables and everything above
+///        them. It only exchanges raw datagrams with the network
+///        thread, through one ring in each direction.
+
+#ifndef __I_TCP_THREAD__
+#define __I_TCP_THREAD__
+
+#include "i_tcp_detail.h"
+#include "i_net.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct tcppacket_t
+{
+	SOCKET_TYPE socket; // received on / send through
+	mysockaddr_t address; // sender / destination
+	socklen_t addresslen;
+	boolean reporterror; // outgoing: remember errors for I_NetThreadSendError
+	INT16 length;
+	char data[MAXPACKETLENGTH];
+};
+
+// Starts servicing the given sockets on a new thread.
+boolean I_StartNetThread(const SOCKET_TYPE *sockets, size_t numsockets);
+
+// Stops and joins the thread. Must be called before its sockets close.
+void I_StopNetThread(void);
+
+boolean I_NetThreadActive(void);
+
+// Takes the oldest received datagram. Returns false if there is none.
+boolean I_NetThreadReceive(tcppacket_t *packet);
+
+// Queues a datagram, waiting for room if the ring is full.
+void I_NetThreadSend(const tcppacket_t *packet);
+
+boolean I_NetThreadCanReceive(void);
+boolean I_NetThreadCanSend(void);
+
+// Returns the errno of the first failed send since the last call, or 0.
+int I_NetThreadSendError(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
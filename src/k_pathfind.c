@@ -20,6 +20,21 @@ static const size_t DEFAULT_NODEARRAY_CAPACITY = 8U;
 static const size_t DEFAULT_OPENSET_CAPACITY   = 8U;
 static const size_t DEFAULT_CLOSEDSET_CAPACITY = 8U;
 
+// Working memory for K_PathfindAStar. It's kept between searches so that pathfinding doesn't have to go
+// through the zone allocator every time, and only grows when a search needs more than any before it.
+static struct
+{
+	pathfindnode_t *nodes;        // Every node seen by the current search
+	boolean        *closed;       // Parallel to nodes, whether the node has already been evaluated
+	size_t         nodescount;
+	size_t         nodescapacity;
+	bheap_t        openset;
+	UINT32         *slotgeneration; // Per node index, the search generation that last wrote slotnode
+	size_t         *slotnode;       // Per node index, where its node is in nodes
+	size_t         slotscapacity;
+	UINT32         generation;
+} pathfindarena;
+
 
 /*--------------------------------------------------
 	static UINT32 K_NodeGetFScore(const pathfindnode_t *const node)
@@ -112,37 +127,203 @@ static pathfindnode_t *K_NodesArrayContainsNodeData(
 }
 
 /*--------------------------------------------------
-	static boolean K_ClosedsetContainsNode(pathfindnode_t **closedset, pathfindnode_t *node, size_t closedsetcount)
+	static void K_PathfindReserveNodes(size_t capacity)
 
-		Checks whether the Closedset contains a node. Searches from the end to the start for speed reasons.
+		Makes sure the persistent nodes arena can hold at least capacity nodes. Must only be called before a search
+		starts, as it doesn't fix up any pointers into the arena.
 
 	Input Arguments:-
-		closedset      - The closed set within the A* algorithm
-		node           - The node to check is within the closed set
-		closedsetcount - The current size of the closedset
+		capacity - The number of nodes the arena needs to be able to hold
 
 	Return:-
-		True if the node is in the closed set, false if it isn't
+		None
 --------------------------------------------------*/
-static boolean K_ClosedsetContainsNode(pathfindnode_t **closedset, pathfindnode_t *node, size_t closedsetcount)
+static void K_PathfindReserveNodes(size_t capacity)
 {
-	boolean nodeisinclosedset = false;
-	size_t i = 0U;
+	if (capacity > pathfindarena.nodescapacity)
+	{
+		pathfindarena.nodes = Z_Realloc(pathfindarena.nodes, capacity * sizeof(pathfindnode_t), PU_STATIC, NULL);
+		pathfindarena.closed = Z_Realloc(pathfindarena.closed, capacity * sizeof(boolean), PU_STATIC, NULL);
 
-	I_Assert(closedset != NULL);
-	I_Assert(node != NULL);
-	// It is more likely that we'll find the node we are looking for from the end of the array
-	// Yes, the for loop looks weird, remember that size_t is unsigned and we want to check 0, after it hits 0 it
-	// will loop back up to SIZE_MAX
-	for (i = closedsetcount - 1U; i < closedsetcount; i--)
+		if (pathfindarena.nodes == NULL || pathfindarena.closed == NULL)
+		{
+			I_Error("K_PathfindAStar: Out of memory allocating nodes array.");
+		}
+
+		pathfindarena.nodescapacity = capacity;
+	}
+}
+
+/*--------------------------------------------------
+	static void K_PathfindGrowNodes(pathfindnode_t **currentnode)
+
+		Doubles the size of the nodes arena in the middle of a search, fixing up every pointer into it.
+
+	Input Arguments:-
+		currentnode - The node currently being evaluated, updated if the arena moved
+
+	Return:-
+		None
+--------------------------------------------------*/
+static void K_PathfindGrowNodes(pathfindnode_t **currentnode)
+{
+	pathfindnode_t *oldnodes = pathfindarena.nodes;
+	size_t arrayindex = 0U;
+	size_t j = 0U;
+
+	K_PathfindReserveNodes(pathfindarena.nodescapacity * 2);
+
+	// Need to update pointers in openset, and node "camefrom" if nodes moved.
+	if (pathfindarena.nodes != oldnodes)
 	{
-		if (closedset[i] == node)
+		for (j = 0U; j < pathfindarena.openset.count; j++)
 		{
-			nodeisinclosedset = true;
-			break;
+			arrayindex = ((pathfindnode_t *)(pathfindarena.openset.array[j].data)) - oldnodes;
+			pathfindarena.openset.array[j].data = &pathfindarena.nodes[arrayindex];
+		}
+		for (j = 0U; j < pathfindarena.nodescount; j++)
+		{
+			if (pathfindarena.nodes[j].camefrom != NULL)
+			{
+				arrayindex = pathfindarena.nodes[j].camefrom - oldnodes;
+				pathfindarena.nodes[j].camefrom = &pathfindarena.nodes[arrayindex];
+			}
+		}
+
+		arrayindex = *currentnode - oldnodes;
+		*currentnode = &pathfindarena.nodes[arrayindex];
+	}
+}
+
+/*--------------------------------------------------
+	static void K_PathfindResetSlots(size_t numslots)
+
+		Starts a new generation of the node index slots, growing them to fit numslots if needed. Slots stamped with an
+		older generation are treated as empty, so nothing needs clearing between searches.
+
+	Input Arguments:-
+		numslots - The number of node indexes the setup can return
+
+	Return:-
+		None
+--------------------------------------------------*/
+static void K_PathfindResetSlots(size_t numslots)
+{
+	if (numslots > pathfindarena.slotscapacity)
+	{
+		pathfindarena.slotgeneration = Z_Realloc(pathfindarena.slotgeneration, numslots * sizeof(UINT32), PU_STATIC, NULL);
+		pathfindarena.slotnode = Z_Realloc(pathfindarena.slotnode, numslots * sizeof(size_t), PU_STATIC, NULL);
+
+		if (pathfindarena.slotgeneration == NULL || pathfindarena.slotnode == NULL)
+		{
+			I_Error("K_PathfindAStar: Out of memory allocating node slots.");
+		}
+
+		// New slots must not match any generation, including one that is already running
+		memset(&pathfindarena.slotgeneration[pathfindarena.slotscapacity], 0,
+			(numslots - pathfindarena.slotscapacity) * sizeof(UINT32));
+		pathfindarena.slotscapacity = numslots;
+	}
+
+	pathfindarena.generation++;
+
+	if (pathfindarena.generation == 0U)
+	{
+		// Wrapped around, old stamps could match again
+		memset(pathfindarena.slotgeneration, 0, pathfindarena.slotscapacity * sizeof(UINT32));
+		pathfindarena.generation = 1U;
+	}
+}
+
+/*--------------------------------------------------
+	static pathfindnode_t *K_PathfindFindNode(
+		const pathfindsetup_t *const pathfindsetup,
+		void *nodedata,
+		size_t *slot)
+
+		Finds the node that was created for nodedata during the current search.
+
+	Input Arguments:-
+		pathfindsetup - The setup for the pathfinding given
+		nodedata      - The node data to look for
+		slot          - Return location for the node's index slot, SIZE_MAX if it doesn't have one
+
+	Return:-
+		The pathfind node that has the data if there is one. NULL if it hasn't been seen yet.
+--------------------------------------------------*/
+static pathfindnode_t *K_PathfindFindNode(
+	const pathfindsetup_t *const pathfindsetup,
+	void *nodedata,
+	size_t *slot)
+{
+	*slot = SIZE_MAX;
+
+	if (pathfindsetup->getnodeindex != NULL)
+	{
+		*slot = pathfindsetup->getnodeindex(nodedata);
+	}
+
+	if (*slot < pathfindsetup->numnodeindexes)
+	{
+		if (pathfindarena.slotgeneration[*slot] == pathfindarena.generation)
+		{
+			return &pathfindarena.nodes[pathfindarena.slotnode[*slot]];
 		}
+
+		return NULL;
+	}
+
+	*slot = SIZE_MAX;
+	return K_NodesArrayContainsNodeData(pathfindarena.nodes, nodedata, pathfindarena.nodescount);
+}
+
+/*--------------------------------------------------
+	static pathfindnode_t *K_PathfindAddNode(
+		const pathfindsetup_t *const pathfindsetup,
+		void *nodedata,
+		size_t slot,
+		pathfindnode_t *camefrom,
+		UINT32 gscore)
+
+		Creates a new node in the nodes arena and pushes it onto the open set.
+
+	Input Arguments:-
+		pathfindsetup - The setup for the pathfinding given
+		nodedata      - The data of the new node
+		slot          - The node's index slot from K_PathfindFindNode
+		camefrom      - The node's predecessor
+		gscore        - The accumulated distance from the start to the node
+
+	Return:-
+		The newly created node
+--------------------------------------------------*/
+static pathfindnode_t *K_PathfindAddNode(
+	const pathfindsetup_t *const pathfindsetup,
+	void *nodedata,
+	size_t slot,
+	pathfindnode_t *camefrom,
+	UINT32 gscore)
+{
+	pathfindnode_t *newnode = &pathfindarena.nodes[pathfindarena.nodescount];
+
+	newnode->heapindex = SIZE_MAX;
+	newnode->nodedata  = nodedata;
+	newnode->camefrom  = camefrom;
+	newnode->gscore    = gscore;
+	newnode->hscore    = pathfindsetup->getheuristic(nodedata, pathfindsetup->endnodedata);
+
+	pathfindarena.closed[pathfindarena.nodescount] = false;
+
+	if (slot != SIZE_MAX)
+	{
+		pathfindarena.slotgeneration[slot] = pathfindarena.generation;
+		pathfindarena.slotnode[slot] = pathfindarena.nodescount;
 	}
-	return nodeisinclosedset;
+
+	pathfindarena.nodescount++;
+	K_BHeapPush(&pathfindarena.openset, newnode, K_NodeGetFScore(newnode), K_NodeUpdateHeapIndex);
+
+	return newnode;
 }
 
 /*--------------------------------------------------
@@ -316,11 +497,7 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 		}
 		else
 		{
-			bheap_t        openset                 = {0};
 			bheapitem_t    poppedbheapitem         = {0};
-			pathfindnode_t *nodesarray             = NULL;
-			pathfindnode_t **closedset             = NULL;
-			pathfindnode_t *newnode                = NULL;
 			pathfindnode_t *currentnode            = NULL;
 			pathfindnode_t *connectingnode         = NULL;
 			void           **connectingnodesdata   = NULL;
@@ -328,7 +505,7 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 			UINT32         *connectingnodecosts    = NULL;
 			size_t         numconnectingnodes      = 0U;
 			size_t         connectingnodeheapindex = 0U;
-			size_t         nodesarraycount         = 0U;
+			size_t         connectingnodeslot      = SIZE_MAX;
 			size_t         closedsetcount          = 0U;
 			size_t         i                       = 0U;
 			UINT32         tentativegscore         = 0U;
@@ -346,42 +523,33 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 			{
 				pathfindsetup->closedsetcapacity = DEFAULT_CLOSEDSET_CAPACITY;
 			}
-
-			// Allocate the necessary memory
-			nodesarray = Z_Calloc(pathfindsetup->nodesarraycapacity * sizeof(pathfindnode_t), PU_STATIC, NULL);
-			if (nodesarray == NULL)
+			if (pathfindsetup->getnodeindex == NULL)
 			{
-				I_Error("K_PathfindAStar: Out of memory allocating nodes array.");
+				pathfindsetup->numnodeindexes = 0U;
 			}
-			closedset = Z_Calloc(pathfindsetup->closedsetcapacity * sizeof(pathfindnode_t*), PU_STATIC, NULL);
-			if (closedset == NULL)
+
+			// Make sure the working memory is big enough. With every node indexed, a search can never see more
+			// nodes than there are indexes (plus an unindexed start node), so the arena won't move mid-search.
+			K_PathfindReserveNodes(max(pathfindsetup->nodesarraycapacity, pathfindsetup->numnodeindexes + 1U));
+			K_PathfindResetSlots(pathfindsetup->numnodeindexes);
+			pathfindarena.nodescount = 0U;
+
+			if (pathfindarena.openset.array == NULL)
 			{
-				I_Error("K_PathfindAStar: Out of memory allocating closed set.");
+				K_BHeapInit(&pathfindarena.openset, pathfindsetup->opensetcapacity);
 			}
-			K_BHeapInit(&openset, pathfindsetup->opensetcapacity);
+			pathfindarena.openset.count = 0U;
 
 			// Create the first node and add it to the open set
-			newnode            = &nodesarray[nodesarraycount];
-			newnode->heapindex = SIZE_MAX;
-			newnode->nodedata  = pathfindsetup->startnodedata;
-			newnode->camefrom  = NULL;
-			newnode->gscore    = 0U;
-			newnode->hscore    = pathfindsetup->getheuristic(newnode->nodedata, pathfindsetup->endnodedata);
-			nodesarraycount++;
-			K_BHeapPush(&openset, newnode, K_NodeGetFScore(newnode), K_NodeUpdateHeapIndex);
-
-			// update openset capacity if it changed
-			if (openset.capacity != pathfindsetup->opensetcapacity)
-			{
-				pathfindsetup->opensetcapacity = openset.capacity;
-			}
+			K_PathfindFindNode(pathfindsetup, pathfindsetup->startnodedata, &connectingnodeslot);
+			K_PathfindAddNode(pathfindsetup, pathfindsetup->startnodedata, connectingnodeslot, NULL, 0U);
 
 			// Go through each node in the openset, adding new ones from each node to it
 			// this continues until a path is found or there are no more nodes to check
-			while (openset.count > 0U)
+			while (pathfindarena.openset.count > 0U)
 			{
 				// pop the best node off of the openset
-				K_BHeapPop(&openset, &poppedbheapitem);
+				K_BHeapPop(&pathfindarena.openset, &poppedbheapitem);
 				currentnode = (pathfindnode_t*)poppedbheapitem.data;
 
 				if (pathfindsetup->getfinished(currentnode, pathfindsetup) == true)
@@ -391,18 +559,7 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 				}
 
 				// Place the node we just popped into the closed set, as we are now evaluating it
-				if (closedsetcount >= pathfindsetup->closedsetcapacity)
-				{
-					// Need to reallocate closedset to fit another node
-					pathfindsetup->closedsetcapacity = pathfindsetup->closedsetcapacity * 2;
-					closedset =
-						Z_Realloc(closedset, pathfindsetup->closedsetcapacity * sizeof(pathfindnode_t*), PU_STATIC, NULL);
-					if (closedset == NULL)
-					{
-						I_Error("K_PathfindAStar: Out of memory reallocating closed set.");
-					}
-				}
-				closedset[closedsetcount] = currentnode;
+				pathfindarena.closed[currentnode - pathfindarena.nodes] = true;
 				closedsetcount++;
 
 				// Get the needed data for the next nodes from the current node
@@ -441,13 +598,13 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 							tentativegscore = currentnode->gscore + connectingnodecosts[i];
 
 							// find this data in the nodes array if it's been generated before
-							connectingnode = K_NodesArrayContainsNodeData(nodesarray, checknodedata, nodesarraycount);
+							connectingnode = K_PathfindFindNode(pathfindsetup, checknodedata, &connectingnodeslot);
 
 							if (connectingnode != NULL)
 							{
 								// The connecting node has been seen before, so it must be in either the closedset (skip it)
 								// or the openset (re-evaluate it's gscore)
-								if (K_ClosedsetContainsNode(closedset, connectingnode, closedsetcount) == true)
+								if (pathfindarena.closed[connectingnode - pathfindarena.nodes] == true)
 								{
 									continue;
 								}
@@ -458,11 +615,11 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 									connectingnode->camefrom = currentnode;
 
 									connectingnodeheapindex =
-										K_BHeapContains(&openset, connectingnode, connectingnode->heapindex);
+										K_BHeapContains(&pathfindarena.openset, connectingnode, connectingnode->heapindex);
 									if (connectingnodeheapindex != SIZE_MAX)
 									{
 										K_UpdateBHeapItemValue(
-											&openset.array[connectingnodeheapindex], K_NodeGetFScore(connectingnode));
+											&pathfindarena.openset.array[connectingnodeheapindex], K_NodeGetFScore(connectingnode));
 									}
 									else
 									{
@@ -474,68 +631,30 @@ boolean K_PathfindAStar(path_t *const path, pathfindsetup_t *const pathfindsetup
 							else
 							{
 								// Node is not created yet, so it hasn't been seen so far
-								// Reallocate nodesarray if it's full
-								if (nodesarraycount >= pathfindsetup->nodesarraycapacity)
+								// Grow the nodes arena if it's full
+								if (pathfindarena.nodescount >= pathfindarena.nodescapacity)
 								{
-									pathfindnode_t *nodesarrayrealloc = NULL;
-									pathfindsetup->nodesarraycapacity = pathfindsetup->nodesarraycapacity * 2;
-									nodesarrayrealloc = Z_Realloc(nodesarray, pathfindsetup->nodesarraycapacity * sizeof(pathfindnode_t), PU_STATIC, NULL);
-
-									if (nodesarrayrealloc == NULL)
-									{
-										I_Error("K_PathfindAStar: Out of memory reallocating nodes array.");
-									}
-
-									// Need to update pointers in closedset, openset, and node "camefrom" if nodesarray moved.
-									if (nodesarray != nodesarrayrealloc)
-									{
-										size_t j = 0U;
-										size_t arrayindex = 0U;
-										for (j = 0U; j < closedsetcount; j++)
-										{
-											arrayindex = closedset[j] - nodesarray;
-											closedset[j] = &nodesarrayrealloc[arrayindex];
-										}
-										for (j = 0U; j < openset.count; j++)
-										{
-											arrayindex = ((pathfindnode_t *)(openset.array[j].data)) - nodesarray;
-											openset.array[j].data = &nodesarrayrealloc[arrayindex];
-										}
-										for (j = 0U; j < nodesarraycount; j++)
-										{
-											if (nodesarrayrealloc[j].camefrom != NULL)
-											{
-												arrayindex = nodesarrayrealloc[j].camefrom - nodesarray;
-												nodesarrayrealloc[j].camefrom = &nodesarrayrealloc[arrayindex];
-											}
-										}
-
-										arrayindex = currentnode - nodesarray;
-										currentnode = &nodesarrayrealloc[arrayindex];
-									}
-
-									nodesarray = nodesarrayrealloc;
+									K_PathfindGrowNodes(&currentnode);
 								}
 
 								// Create the new node and add it to the nodes array and open set
-								newnode            = &nodesarray[nodesarraycount];
-								newnode->heapindex = SIZE_MAX;
-								newnode->nodedata  = checknodedata;
-								newnode->camefrom  = currentnode;
-								newnode->gscore    = tentativegscore;
-								newnode->hscore    = pathfindsetup->getheuristic(newnode->nodedata, pathfindsetup->endnodedata);
-								nodesarraycount++;
-								K_BHeapPush(&openset, newnode, K_NodeGetFScore(newnode), K_NodeUpdateHeapIndex);
+								K_PathfindAddNode(pathfindsetup, checknodedata, connectingnodeslot, currentnode, tentativegscore);
 							}
 						}
 					}
 				}
 			}
 
-			// Clean up the memory
-			K_BHeapFree(&openset);
-			Z_Free(closedset);
-			Z_Free(nodesarray);
+			// Report back how big the structures got, so the caller can size the next search better
+			while (pathfindarena.nodescount > pathfindsetup->nodesarraycapacity)
+			{
+				pathfindsetup->nodesarraycapacity = pathfindsetup->nodesarraycapacity * 2;
+			}
+			while (closedsetcount > pathfindsetup->closedsetcapacity)
+			{
+				pathfindsetup->closedsetcapacity = pathfindsetup->closedsetcapacity * 2;
+			}
+			pathfindsetup->opensetcapacity = max(pathfindsetup->opensetcapacity, pathfindarena.openset.capacity);
 		}
 	}
 
@@ -36,6 +36,10 @@ typedef boolean(*getnodetraversablefunc)(void*, void*);
 // function pointer for getting if a node is our pathfinding end point
 typedef boolean(*getpathfindfinishedfunc)(void*, void*);
 
+// function pointer for getting a node's dense index from its base data, in the range [0, numnodeindexes)
+// should return SIZE_MAX for data that doesn't have an index
+typedef size_t(*getnodeindexfunc)(void*);
+
 
 // A pathfindnode contains information about a node from the pathfinding
 // heapindex is only used within the pathfinding algorithm itself, and is always 0 after it is completed
@@ -59,6 +63,7 @@ struct path_t {
 // should be setup by the caller before starting pathfinding
 // base capacities will be 8 if they aren't setup, missing callback functions will cause an error.
 // Can be accessed after the pathfinding is complete to get the final capacities of them
+// getnodeindex is optional, if it's setup nodes are looked up by index instead of searching every node seen so far
 struct pathfindsetup_t {
 	size_t opensetcapacity;
 	size_t closedsetcapacity;
@@ -71,6 +76,8 @@ struct pathfindsetup_t {
 	getnodeheuristicfunc getheuristic;
 	getnodetraversablefunc gettraversable;
 	getpathfindfinishedfunc getfinished;
+	size_t numnodeindexes;
+	getnodeindexfunc getnodeindex;
 };
 
 
@@ -24,6 +24,9 @@
 #include "cxxutil.hpp"
 
 #include <algorithm>
+#include <functional>
+#include <queue>
+#include <utility>
 #include <vector>
 
 #include <fmt/format.h>
@@ -53,6 +56,57 @@ static size_t baseopensetsize    = OPENSET_BASE_SIZE;
 static size_t baseclosedsetsize  = CLOSEDSET_BASE_SIZE;
 static size_t basenodesarraysize = NODESARRAY_BASE_SIZE;
 
+// Size of a cell of the waypoint grid, in map units
+#define WAYPOINTGRID_CELLSIZE (512)
+
+// A uniform grid over the waypoints, built at map load and rebuilt before the next search whenever a waypoint mobj
+// moves or changes size. The distance checks for finding waypoints near an mobj work in whole map units, so the grid
+// does too. Both tables are stored as one flat array of waypoint heap indexes,
+// with a start offset per cell, and every cell lists its waypoints in heap order.
+struct waypointgrid_t
+{
+	INT32 originx;
+	INT32 originy;
+	INT32 width;
+	INT32 height;
+	boolean dirty;
+
+	// Waypoints by the cell their mobj is in
+	std::vector<UINT32> centerstart;
+	std::vector<UINT32> centers;
+
+	// Waypoints by every cell their radius touches
+	std::vector<UINT32> coverstart;
+	std::vector<UINT32> covers;
+};
+
+static waypointgrid_t waypointgrid;
+static std::vector<UINT32> waypointcandidates;
+
+static void K_SetupWaypointGrid(void);
+
+// Which of the finish line distance tables to use
+enum
+{
+	FINISHDIST_NOSHORTCUTS,
+	FINISHDIST_SHORTCUTS,
+	NUMFINISHDISTS
+};
+
+// The distance from every waypoint to the finish line, along the same routes the pathfinding takes. Each waypoint
+// also keeps the next waypoint of its route, which makes the routes a tree rooted at the finish line. When a waypoint
+// is disabled, only the part of the tree under it needs recalculating.
+struct finishdistances_t
+{
+	std::vector<UINT32> dist[NUMFINISHDISTS];
+	std::vector<UINT32> next[NUMFINISHDISTS];
+
+	// Whether each waypoint was enabled when the distances were calculated
+	std::vector<UINT8> enabled;
+};
+
+static finishdistances_t finishdistances;
+
 
 /*--------------------------------------------------
 	waypoint_t *K_GetFinishLineWaypoint(void)
@@ -299,6 +353,107 @@ INT32 K_GetTrackComplexity(void)
 	return trackcomplexity;
 }
 
+/*--------------------------------------------------
+	static INT32 K_GatherCoveringWaypoints(INT32 x, INT32 y)
+
+		Adds every waypoint whose radius may reach the point to the search candidates.
+
+	Input Arguments:-
+		x - X position, in whole map units
+		y - Y position, in whole map units
+
+	Return:-
+		The largest radius of the added waypoints, in whole map units.
+--------------------------------------------------*/
+static INT32 K_GatherCoveringWaypoints(INT32 x, INT32 y)
+{
+	const INT32 cx = x - waypointgrid.originx;
+	const INT32 cy = y - waypointgrid.originy;
+	INT32 maxradius = 0;
+
+	if (cx < 0 || cy < 0 || cx >= waypointgrid.width * WAYPOINTGRID_CELLSIZE
+		|| cy >= waypointgrid.height * WAYPOINTGRID_CELLSIZE)
+	{
+		return maxradius;
+	}
+
+	const size_t cell = static_cast<size_t>(cy / WAYPOINTGRID_CELLSIZE) * waypointgrid.width + (cx / WAYPOINTGRID_CELLSIZE);
+
+	for (UINT32 i = waypointgrid.coverstart[cell]; i < waypointgrid.coverstart[cell + 1]; i++)
+	{
+		const UINT32 index = waypointgrid.covers[i];
+
+		maxradius = std::max(maxradius, waypointheap[index].mobj->radius / FRACUNIT);
+		waypointcandidates.push_back(index);
+	}
+
+	return maxradius;
+}
+
+/*--------------------------------------------------
+	static boolean K_GatherWaypointsInRange(INT32 x, INT32 y, INT32 range)
+
+		Adds every waypoint that is no further than range from the point on either axis to the search candidates.
+		Waypoints in the same grid cells as those are added too.
+
+	Input Arguments:-
+		x     - X position, in whole map units
+		y     - Y position, in whole map units
+		range - Distance to search, in whole map units
+
+	Return:-
+		True if every waypoint was added.
+--------------------------------------------------*/
+static boolean K_GatherWaypointsInRange(INT32 x, INT32 y, INT32 range)
+{
+	const INT32 x1 = x - range - waypointgrid.originx;
+	const INT32 x2 = x + range - waypointgrid.originx;
+	const INT32 y1 = y - range - waypointgrid.originy;
+	const INT32 y2 = y + range - waypointgrid.originy;
+
+	if (waypointgrid.width == 0 || waypointgrid.height == 0)
+	{
+		return true;
+	}
+
+	if (x2 < 0 || y2 < 0 || x1 >= waypointgrid.width * WAYPOINTGRID_CELLSIZE
+		|| y1 >= waypointgrid.height * WAYPOINTGRID_CELLSIZE)
+	{
+		// The whole area is off the grid, so no waypoints can be in it
+		return false;
+	}
+
+	const INT32 cx1 = std::max(x1, 0) / WAYPOINTGRID_CELLSIZE;
+	const INT32 cx2 = std::min(x2 / WAYPOINTGRID_CELLSIZE, waypointgrid.width - 1);
+	const INT32 cy1 = std::max(y1, 0) / WAYPOINTGRID_CELLSIZE;
+	const INT32 cy2 = std::min(y2 / WAYPOINTGRID_CELLSIZE, waypointgrid.height - 1);
+
+	for (INT32 cy = cy1; cy <= cy2; cy++)
+	{
+		const size_t row = static_cast<size_t>(cy) * waypointgrid.width;
+
+		waypointcandidates.insert(
+			waypointcandidates.end(),
+			waypointgrid.centers.begin() + waypointgrid.centerstart[row + cx1],
+			waypointgrid.centers.begin() + waypointgrid.centerstart[row + cx2 + 1]
+		);
+	}
+
+	return (cx1 == 0 && cy1 == 0 && cx2 == waypointgrid.width - 1 && cy2 == waypointgrid.height - 1);
+}
+
+/*--------------------------------------------------
+	static void K_SortWaypointCandidates(void)
+
+		Puts the search candidates back into heap order and drops duplicates, so that searching them breaks ties
+		the same way as searching the whole heap would.
+--------------------------------------------------*/
+static void K_SortWaypointCandidates(void)
+{
+	std::sort(waypointcandidates.begin(), waypointcandidates.end());
+	waypointcandidates.erase(std::unique(waypointcandidates.begin(), waypointcandidates.end()), waypointcandidates.end());
+}
+
 /*--------------------------------------------------
 	waypoint_t *K_GetClosestWaypointToMobj(mobj_t *const mobj)
 
@@ -314,26 +469,54 @@ waypoint_t *K_GetClosestWaypointToMobj(mobj_t *const mobj)
 	}
 	else
 	{
-		size_t     i              = 0U;
+		const INT32 x = mobj->x / FRACUNIT;
+		const INT32 y = mobj->y / FRACUNIT;
+		INT32      range          = WAYPOINTGRID_CELLSIZE;
+		boolean    exhaustive     = false;
 		waypoint_t *checkwaypoint = NULL;
 		fixed_t    closestdist    = INT32_MAX;
 		fixed_t    checkdist      = INT32_MAX;
 
-		for (i = 0; i < numwaypoints; i++)
+		if (waypointgrid.dirty)
 		{
-			checkwaypoint = &waypointheap[i];
+			K_SetupWaypointGrid();
+		}
 
-			checkdist = P_AproxDistance(
-				(mobj->x / FRACUNIT) - (checkwaypoint->mobj->x / FRACUNIT),
-				(mobj->y / FRACUNIT) - (checkwaypoint->mobj->y / FRACUNIT));
-			checkdist = P_AproxDistance(checkdist, (mobj->z / FRACUNIT) - (checkwaypoint->mobj->z / FRACUNIT));
+		// Distances are never shorter than the difference on either axis, so once something closer than the search
+		// range is found, nothing outside of it can beat it. Widen the search until that happens.
+		do
+		{
+			closestwaypoint = NULL;
+			closestdist = INT32_MAX;
+
+			waypointcandidates.clear();
+			exhaustive = K_GatherWaypointsInRange(x, y, range);
+			K_SortWaypointCandidates();
 
-			if (checkdist < closestdist)
+			for (UINT32 index : waypointcandidates)
 			{
-				closestwaypoint = checkwaypoint;
-				closestdist = checkdist;
+				checkwaypoint = &waypointheap[index];
+
+				checkdist = P_AproxDistance(
+					(mobj->x / FRACUNIT) - (checkwaypoint->mobj->x / FRACUNIT),
+					(mobj->y / FRACUNIT) - (checkwaypoint->mobj->y / FRACUNIT));
+				checkdist = P_AproxDistance(checkdist, (mobj->z / FRACUNIT) - (checkwaypoint->mobj->z / FRACUNIT));
+
+				if (checkdist < closestdist)
+				{
+					closestwaypoint = checkwaypoint;
+					closestdist = checkdist;
+				}
+			}
+
+			if (closestwaypoint != NULL && closestdist <= range)
+			{
+				break;
 			}
+
+			range *= 2;
 		}
+		while (exhaustive == false);
 	}
 
 	return closestwaypoint;
@@ -354,9 +537,7 @@ static void K_CompareOverlappingWaypoint
 		fixed_t     *const bestfindist)
 {
 	const boolean useshortcuts = false;
-	const boolean huntbackwards = false;
-	boolean pathfindsuccess = false;
-	path_t pathtofinish = {0};
+	UINT32 disttofinish = UINT32_MAX;
 
 	if (K_GetWaypointIsShortcut(*bestwaypoint) == false
 		&& K_GetWaypointIsShortcut(checkwaypoint) == true)
@@ -365,18 +546,15 @@ static void K_CompareOverlappingWaypoint
 		return;
 	}
 
-	pathfindsuccess =
-		K_PathfindToWaypoint(checkwaypoint, finishline, &pathtofinish, useshortcuts, huntbackwards);
+	disttofinish = K_GetWaypointDistanceToFinish(checkwaypoint, useshortcuts);
 
-	if (pathfindsuccess == true)
+	if (disttofinish != UINT32_MAX)
 	{
-		if ((INT32)(pathtofinish.totaldist) < *bestfindist)
+		if ((INT32)(disttofinish) < *bestfindist)
 		{
 			*bestwaypoint = checkwaypoint;
-			*bestfindist = pathtofinish.totaldist;
+			*bestfindist = disttofinish;
 		}
-
-		Z_Free(pathtofinish.array);
 	}
 }
 
@@ -487,17 +665,53 @@ waypoint_t *K_GetBestWaypointForMobj(mobj_t *const mobj, waypoint_t *const hint)
 			}
 		};
 
-		if (hint != NULL)
+		const INT32 x = mobj->x / FRACUNIT;
+		const INT32 y = mobj->y / FRACUNIT;
+		INT32 range = WAYPOINTGRID_CELLSIZE;
+		boolean exhaustive = false;
+
+		if (waypointgrid.dirty)
 		{
-			// The hint is a waypoint that is already known to be close to the player. It is used to exclude
-			// most of the other waypoints by distance so fewer expensive sight checks are performed.
-			sort_waypoint(hint);
+			K_SetupWaypointGrid();
 		}
 
-		for (size_t i = 0U; i < numwaypoints; i++)
+		// Only waypoints whose radius reaches the mobj can be overlapping, and their radius bounds how far away the
+		// closest waypoint can be and still matter for them. Anything further than that and further than the closest
+		// waypoint found can be skipped without changing the result, so search the grid out to there.
+		waypointcandidates.clear();
+		range = std::max(range, K_GatherCoveringWaypoints(x, y));
+
+		do
 		{
-			sort_waypoint(&waypointheap[i]);
+			bestwaypoint = NULL;
+			closestdist = INT32_MAX;
+			bestfindist = INT32_MAX;
+
+			waypointcandidates.clear();
+			K_GatherCoveringWaypoints(x, y);
+			exhaustive = K_GatherWaypointsInRange(x, y, range);
+			K_SortWaypointCandidates();
+
+			if (hint != NULL)
+			{
+				// The hint is a waypoint that is already known to be close to the player. It is used to exclude
+				// most of the other waypoints by distance so fewer expensive sight checks are performed.
+				sort_waypoint(hint);
+			}
+
+			for (UINT32 index : waypointcandidates)
+			{
+				sort_waypoint(&waypointheap[index]);
+			}
+
+			if (bestfindist != INT32_MAX || (bestwaypoint != NULL && closestdist <= range))
+			{
+				break;
+			}
+
+			range *= 2;
 		}
+		while (exhaustive == false);
 	}
 
 	return bestwaypoint;
@@ -935,6 +1149,31 @@ static void K_UpdateNodesArrayBaseSize(size_t newnodesarraysize)
 	}
 }
 
+/*--------------------------------------------------
+	static size_t K_WaypointPathfindGetIndex(void *data)
+
+		Gets the index of a waypoint in the waypoint heap. For pathfinding only.
+
+	Input Arguments:-
+		data - Should point to a waypoint_t
+
+	Return:-
+		The heap index of the waypoint, SIZE_MAX if it isn't part of the heap.
+--------------------------------------------------*/
+static size_t K_WaypointPathfindGetIndex(void *data)
+{
+	const uintptr_t address = reinterpret_cast<uintptr_t>(data);
+	const uintptr_t heapstart = reinterpret_cast<uintptr_t>(waypointheap);
+
+	// Copies of waypoints (like the fake finish line used for the circuit length) live outside the heap
+	if (waypointheap == NULL || address < heapstart || address >= heapstart + numwaypoints * sizeof(waypoint_t))
+	{
+		return SIZE_MAX;
+	}
+
+	return static_cast<waypoint_t *>(data) - waypointheap;
+}
+
 /*--------------------------------------------------
 	static void **K_WaypointPathfindGetNext(void *data, size_t *numconnections)
 
@@ -1365,6 +1604,8 @@ boolean K_PathfindToWaypoint(
 		pathfindsetup.getheuristic       = heuristicfunc;
 		pathfindsetup.gettraversable     = traversablefunc;
 		pathfindsetup.getfinished        = finishedfunc;
+		pathfindsetup.numnodeindexes     = numwaypoints;
+		pathfindsetup.getnodeindex       = K_WaypointPathfindGetIndex;
 
 		pathfound = K_PathfindAStar(returnpath, &pathfindsetup);
 
@@ -1441,6 +1682,8 @@ boolean K_PathfindThruCircuit(
 		pathfindsetup.getheuristic       = heuristicfunc;
 		pathfindsetup.gettraversable     = traversablefunc;
 		pathfindsetup.getfinished        = finishedfunc;
+		pathfindsetup.numnodeindexes     = numwaypoints;
+		pathfindsetup.getnodeindex       = K_WaypointPathfindGetIndex;
 
 		pathfound = K_PathfindAStar(returnpath, &pathfindsetup);
 
@@ -1517,6 +1760,8 @@ boolean K_PathfindThruCircuitSpawnable(
 		pathfindsetup.getheuristic       = heuristicfunc;
 		pathfindsetup.gettraversable     = traversablefunc;
 		pathfindsetup.getfinished        = finishedfunc;
+		pathfindsetup.numnodeindexes     = numwaypoints;
+		pathfindsetup.getnodeindex       = K_WaypointPathfindGetIndex;
 
 		pathfound = K_PathfindAStar(returnpath, &pathfindsetup);
 
@@ -1528,6 +1773,338 @@ boolean K_PathfindThruCircuitSpawnable(
 	return pathfound;
 }
 
+/*--------------------------------------------------
+	static boolean K_FinishDistanceCanTraverse(size_t from, size_t to, size_t table)
+
+		Checks if a route may go from one waypoint to the next. Matches the traversable functions used for
+		pathfinding, but uses the enabled state the finish line distances were calculated with.
+
+	Input Arguments:-
+		from  - Heap index of the waypoint the route is coming from
+		to    - Heap index of the waypoint the route is going to
+		table - Which finish line distance table this is for
+
+	Return:-
+		True if the route may go from one to the other, false otherwise.
+--------------------------------------------------*/
+static boolean K_FinishDistanceCanTraverse(size_t from, size_t to, size_t table)
+{
+	if (finishdistances.enabled[to] == false)
+	{
+		return false;
+	}
+
+	if (table == FINISHDIST_SHORTCUTS)
+	{
+		return true;
+	}
+
+	return (K_GetWaypointIsShortcut(&waypointheap[to]) == false || K_GetWaypointIsShortcut(&waypointheap[from]) == true);
+}
+
+/*--------------------------------------------------
+	static void K_PropagateFinishDistances(size_t table, std::vector<std::pair<UINT32, UINT32>> &&queue)
+
+		Spreads distances to the finish line backwards through the waypoints, Dijkstra style. Waypoints are only ever
+		improved, so it is used both for the initial setup and for patching up the tables after a change.
+
+	Input Arguments:-
+		table - Which finish line distance table to update
+		queue - Distance and heap index pairs of waypoints that have changed
+--------------------------------------------------*/
+static void K_PropagateFinishDistances(size_t table, std::vector<std::pair<UINT32, UINT32>> &&queue)
+{
+	using entry_t = std::pair<UINT32, UINT32>;
+
+	std::vector<UINT32> &dist = finishdistances.dist[table];
+	std::vector<UINT32> &next = finishdistances.next[table];
+	std::priority_queue<entry_t, std::vector<entry_t>, std::greater<entry_t>> openset(std::greater<entry_t>(), std::move(queue));
+
+	while (openset.empty() == false)
+	{
+		const entry_t top = openset.top();
+		const UINT32 index = top.second;
+		const waypoint_t *const waypoint = &waypointheap[index];
+
+		openset.pop();
+
+		if (top.first != dist[index])
+		{
+			// Stale entry, this waypoint was improved after it was queued
+			continue;
+		}
+
+		for (size_t i = 0U; i < waypoint->numprevwaypoints; i++)
+		{
+			const UINT32 previndex = static_cast<UINT32>(waypoint->prevwaypoints[i] - waypointheap);
+			const UINT32 cost = waypoint->prevwaypointdistances[i];
+
+			if (K_FinishDistanceCanTraverse(previndex, index, table) == false)
+			{
+				continue;
+			}
+
+			if (cost >= UINT32_MAX - dist[index])
+			{
+				continue;
+			}
+
+			if (dist[index] + cost < dist[previndex])
+			{
+				dist[previndex] = dist[index] + cost;
+				next[previndex] = index;
+				openset.emplace(dist[previndex], previndex);
+			}
+		}
+	}
+}
+
+/*--------------------------------------------------
+	static void K_SetupFinishDistances(void)
+
+		Calculates the distance from every waypoint to the finish line from scratch.
+--------------------------------------------------*/
+static void K_SetupFinishDistances(void)
+{
+	finishdistances.enabled.resize(numwaypoints);
+
+	for (size_t i = 0U; i < numwaypoints; i++)
+	{
+		finishdistances.enabled[i] = K_GetWaypointIsEnabled(&waypointheap[i]);
+	}
+
+	for (size_t table = 0U; table < NUMFINISHDISTS; table++)
+	{
+		finishdistances.dist[table].assign(numwaypoints, UINT32_MAX);
+		finishdistances.next[table].assign(numwaypoints, UINT32_MAX);
+
+		// The pathfinding refuses to route to a finish line that isn't connected both ways
+		if (finishline == NULL || finishline->numnextwaypoints == 0U || finishline->numprevwaypoints == 0U)
+		{
+			continue;
+		}
+
+		const UINT32 finishindex = static_cast<UINT32>(finishline - waypointheap);
+
+		finishdistances.dist[table][finishindex] = 0U;
+		K_PropagateFinishDistances(table, {{0U, finishindex}});
+	}
+}
+
+/*--------------------------------------------------
+	static void K_UpdateFinishDistances(size_t changed)
+
+		Updates the finish line distances after a waypoint has been enabled or disabled.
+
+	Input Arguments:-
+		changed - Heap index of the waypoint that changed
+--------------------------------------------------*/
+static void K_UpdateFinishDistances(size_t changed)
+{
+	const waypoint_t *const waypoint = &waypointheap[changed];
+
+	for (size_t table = 0U; table < NUMFINISHDISTS; table++)
+	{
+		std::vector<UINT32> &dist = finishdistances.dist[table];
+		std::vector<UINT32> &next = finishdistances.next[table];
+
+		if (finishdistances.enabled[changed])
+		{
+			// Enabling only opens up routes through this waypoint, so continue on from it.
+			if (dist[changed] != UINT32_MAX)
+			{
+				K_PropagateFinishDistances(table, {{dist[changed], static_cast<UINT32>(changed)}});
+			}
+
+			continue;
+		}
+
+		// Disabling cuts off every waypoint whose route went through this one. The waypoint itself keeps its own
+		// distance, as the route's starting waypoint is never checked.
+		std::vector<UINT32> cutoff;
+		std::vector<UINT8> iscutoff(numwaypoints, false);
+
+		for (size_t i = 0U; i < waypoint->numprevwaypoints; i++)
+		{
+			const UINT32 previndex = static_cast<UINT32>(waypoint->prevwaypoints[i] - waypointheap);
+
+			if (next[previndex] == changed && iscutoff[previndex] == false)
+			{
+				iscutoff[previndex] = true;
+				cutoff.push_back(previndex);
+			}
+		}
+
+		for (size_t i = 0U; i < cutoff.size(); i++)
+		{
+			const waypoint_t *const cutwaypoint = &waypointheap[cutoff[i]];
+
+			for (size_t j = 0U; j < cutwaypoint->numprevwaypoints; j++)
+			{
+				const UINT32 previndex = static_cast<UINT32>(cutwaypoint->prevwaypoints[j] - waypointheap);
+
+				if (next[previndex] == cutoff[i] && iscutoff[previndex] == false && previndex != changed)
+				{
+					iscutoff[previndex] = true;
+					cutoff.push_back(previndex);
+				}
+			}
+		}
+
+		for (UINT32 index : cutoff)
+		{
+			dist[index] = UINT32_MAX;
+			next[index] = UINT32_MAX;
+		}
+
+		// Reconnect them to the best of the routes that weren't affected, then let that spread
+		std::vector<std::pair<UINT32, UINT32>> queue;
+
+		for (UINT32 index : cutoff)
+		{
+			const waypoint_t *const cutwaypoint = &waypointheap[index];
+
+			for (size_t i = 0U; i < cutwaypoint->numnextwaypoints; i++)
+			{
+				const UINT32 nextindex = static_cast<UINT32>(cutwaypoint->nextwaypoints[i] - waypointheap);
+				const UINT32 cost = cutwaypoint->nextwaypointdistances[i];
+
+				if (iscutoff[nextindex] || dist[nextindex] == UINT32_MAX
+					|| K_FinishDistanceCanTraverse(index, nextindex, table) == false
+					|| cost >= UINT32_MAX - dist[nextindex])
+				{
+					continue;
+				}
+
+				if (dist[nextindex] + cost < dist[index])
+				{
+					dist[index] = dist[nextindex] + cost;
+					next[index] = nextindex;
+				}
+			}
+
+			if (dist[index] != UINT32_MAX)
+			{
+				queue.emplace_back(dist[index], index);
+			}
+		}
+
+		K_PropagateFinishDistances(table, std::move(queue));
+	}
+}
+
+/*--------------------------------------------------
+	UINT32 K_GetWaypointDistanceToFinish(waypoint_t *const waypoint, const boolean useshortcuts)
+
+		See header file for description.
+--------------------------------------------------*/
+UINT32 K_GetWaypointDistanceToFinish(waypoint_t *const waypoint, const boolean useshortcuts)
+{
+	const size_t table = useshortcuts ? FINISHDIST_SHORTCUTS : FINISHDIST_NOSHORTCUTS;
+
+	// Only waypoints in the heap have a distance. K_SetupCircuitLength pathfinds from a copy of the finish line.
+	if (waypoint == NULL || waypoint < waypointheap || waypoint >= waypointheap + finishdistances.dist[table].size())
+	{
+		return UINT32_MAX;
+	}
+
+	const size_t index = waypoint - waypointheap;
+
+	if (waypoint->numnextwaypoints == 0U)
+	{
+		// The pathfinding gives up on waypoints that lead nowhere, even the finish line itself
+		return UINT32_MAX;
+	}
+
+	return finishdistances.dist[table][index];
+}
+
+/*--------------------------------------------------
+	void K_UpdateWaypointPosition(mobj_t *const waypointmobj)
+
+		See header file for description.
+--------------------------------------------------*/
+void K_UpdateWaypointPosition(mobj_t *const waypointmobj)
+{
+	(void)waypointmobj;
+
+	if (waypointgrid.width == 0)
+	{
+		// Not built yet, it will see the new position when it is
+		return;
+	}
+
+	// Rebuilding is cheap next to a search that misses the moved waypoint, and waypoints rarely move
+	waypointgrid.dirty = true;
+}
+
+/*--------------------------------------------------
+	void K_UpdateWaypointEnabled(mobj_t *const waypointmobj)
+
+		See header file for description.
+--------------------------------------------------*/
+void K_UpdateWaypointEnabled(mobj_t *const waypointmobj)
+{
+	waypoint_t *waypoint = NULL;
+	size_t index = SIZE_MAX;
+
+	if (waypointheap == NULL || finishdistances.enabled.size() != numwaypoints)
+	{
+		// Still setting up, the distances will be worked out after
+		return;
+	}
+
+	waypoint = K_SearchWaypointHeapForMobj(waypointmobj);
+
+	if (waypoint == NULL)
+	{
+		return;
+	}
+
+	index = K_GetWaypointHeapIndex(waypoint);
+
+	if (finishdistances.enabled[index] == K_GetWaypointIsEnabled(waypoint))
+	{
+		return;
+	}
+
+	finishdistances.enabled[index] = K_GetWaypointIsEnabled(waypoint);
+	K_UpdateFinishDistances(index);
+}
+
+/*--------------------------------------------------
+	void K_RefreshWaypointDistances(void)
+
+		See header file for description.
+--------------------------------------------------*/
+void K_RefreshWaypointDistances(void)
+{
+	if (waypointheap == NULL)
+	{
+		return;
+	}
+
+	if (finishdistances.enabled.size() == numwaypoints)
+	{
+		size_t i;
+
+		for (i = 0U; i < numwaypoints; i++)
+		{
+			if (finishdistances.enabled[i] != K_GetWaypointIsEnabled(&waypointheap[i]))
+			{
+				break;
+			}
+		}
+
+		if (i == numwaypoints)
+		{
+			return;
+		}
+	}
+
+	K_SetupFinishDistances();
+}
+
 /*--------------------------------------------------
 	waypoint_t *K_GetNextWaypointToDestination(
 		waypoint_t *const sourcewaypoint,
@@ -1583,6 +2160,13 @@ waypoint_t *K_GetNextWaypointToDestination(
 		{
 			nextwaypoint = sourcewaypoint->prevwaypoints[0];
 		}
+		else if ((huntbackwards == false) && (destinationwaypoint == finishline)
+			&& (K_GetWaypointDistanceToFinish(sourcewaypoint, useshortcuts) != UINT32_MAX))
+		{
+			// Routes to the finish line are already known
+			const size_t table = useshortcuts ? FINISHDIST_SHORTCUTS : FINISHDIST_NOSHORTCUTS;
+			nextwaypoint = &waypointheap[finishdistances.next[table][sourcewaypoint - waypointheap]];
+		}
 		else
 		{
 			path_t                     pathtowaypoint  = {0};
@@ -1615,6 +2199,8 @@ waypoint_t *K_GetNextWaypointToDestination(
 			pathfindsetup.getheuristic       = heuristicfunc;
 			pathfindsetup.gettraversable     = traversablefunc;
 			pathfindsetup.getfinished        = finishedfunc;
+			pathfindsetup.numnodeindexes     = numwaypoints;
+			pathfindsetup.getnodeindex       = K_WaypointPathfindGetIndex;
 
 			pathfindsuccess = K_PathfindAStar(&pathtowaypoint, &pathfindsetup);
 
@@ -2732,6 +3318,118 @@ static INT32 K_CalculateTrackComplexity(void)
 
 }; // namespace
 
+/*--------------------------------------------------
+	static void K_SetupWaypointGrid(void)
+
+		Buckets every waypoint into the waypoint grid, both by its position and by the area its radius covers.
+		Called again when a waypoint has moved since the last time, see K_UpdateWaypointPosition.
+--------------------------------------------------*/
+static void K_SetupWaypointGrid(void)
+{
+	INT32 minx = INT32_MAX, miny = INT32_MAX;
+	INT32 maxx = INT32_MIN, maxy = INT32_MIN;
+	size_t i;
+
+	waypointgrid.dirty = false;
+
+	if (numwaypoints == 0U)
+	{
+		return;
+	}
+
+	for (i = 0; i < numwaypoints; i++)
+	{
+		const mobj_t *mobj = waypointheap[i].mobj;
+		const INT32 x = mobj->x / FRACUNIT;
+		const INT32 y = mobj->y / FRACUNIT;
+		const INT32 rad = std::max(mobj->radius / FRACUNIT, 0);
+
+		minx = std::min(minx, x - rad);
+		miny = std::min(miny, y - rad);
+		maxx = std::max(maxx, x + rad);
+		maxy = std::max(maxy, y + rad);
+	}
+
+	waypointgrid.originx = minx;
+	waypointgrid.originy = miny;
+	waypointgrid.width = ((maxx - minx) / WAYPOINTGRID_CELLSIZE) + 1;
+	waypointgrid.height = ((maxy - miny) / WAYPOINTGRID_CELLSIZE) + 1;
+
+	const size_t numcells = static_cast<size_t>(waypointgrid.width) * waypointgrid.height;
+
+	auto cell_range = [](INT32 lo, INT32 hi, INT32 origin, INT32 size, INT32 *first, INT32 *last)
+	{
+		*first = std::clamp((lo - origin) / WAYPOINTGRID_CELLSIZE, 0, size - 1);
+		*last = std::clamp((hi - origin) / WAYPOINTGRID_CELLSIZE, 0, size - 1);
+	};
+
+	// Count, then fill. Walking the heap in order keeps every cell sorted by heap index.
+	auto bucket = [&](std::vector<UINT32> &start, std::vector<UINT32> &list, boolean cover)
+	{
+		start.assign(numcells + 1, 0);
+
+		for (int pass = 0; pass < 2; pass++)
+		{
+			for (i = 0; i < numwaypoints; i++)
+			{
+				const mobj_t *mobj = waypointheap[i].mobj;
+				const INT32 x = mobj->x / FRACUNIT;
+				const INT32 y = mobj->y / FRACUNIT;
+				const INT32 rad = cover ? std::max(mobj->radius / FRACUNIT, 0) : 0;
+				INT32 cx1, cx2, cy1, cy2;
+
+				cell_range(x - rad, x + rad, waypointgrid.originx, waypointgrid.width, &cx1, &cx2);
+				cell_range(y - rad, y + rad, waypointgrid.originy, waypointgrid.height, &cy1, &cy2);
+
+				for (INT32 cy = cy1; cy <= cy2; cy++)
+				{
+					for (INT32 cx = cx1; cx <= cx2; cx++)
+					{
+						const size_t cell = static_cast<size_t>(cy) * waypointgrid.width + cx;
+
+						if (pass == 0)
+						{
+							start[cell + 1]++;
+						}
+						else
+						{
+							list[start[cell]++] = static_cast<UINT32>(i);
+						}
+					}
+				}
+			}
+
+			if (pass == 0)
+			{
+				for (size_t cell = 0; cell < numcells; cell++)
+				{
+					start[cell + 1] += start[cell];
+				}
+
+				list.resize(start[numcells]);
+			}
+			else
+			{
+				// The fill pass advanced every start to the next cell's start
+				for (size_t cell = numcells; cell > 0; cell--)
+				{
+					start[cell] = start[cell - 1];
+				}
+
+				start[0] = 0;
+			}
+		}
+	};
+
+	bucket(waypointgrid.centerstart, waypointgrid.centers, false);
+	bucket(waypointgrid.coverstart, waypointgrid.covers, true);
+
+	waypointcandidates.reserve(numwaypoints);
+
+	CONS_Debug(DBG_SETUP, "Waypoint grid: %dx%d cells, %s radius entries.\n",
+		waypointgrid.width, waypointgrid.height, sizeu1(waypointgrid.covers.size()));
+}
+
 /*--------------------------------------------------
 	boolean K_SetupWaypointList(void)
 
@@ -2760,6 +3458,8 @@ boolean K_SetupWaypointList(void)
 				K_SetupWaypoint(waypointmobj);
 			}
 
+			K_SetupWaypointGrid();
+
 			if (firstwaypoint == NULL)
 			{
 				CONS_Alert(CONS_ERROR, "No waypoints in map.\n");
@@ -2780,6 +3480,8 @@ boolean K_SetupWaypointList(void)
 					CONS_Alert(CONS_ERROR, "Circuit track waypoints do not form a circuit.\n");
 				}
 
+				K_SetupFinishDistances();
+
 				if (startingwaypoint != NULL)
 				{
 					K_CalculateTrackComplexity();
@@ -2808,6 +3510,9 @@ void K_ClearWaypoints(void)
 	numwaypointmobjs = 0U;
 	circuitlength    = 0U;
 	trackcomplexity  = 0U;
+
+	waypointgrid = {};
+	finishdistances = {};
 }
 
 /*--------------------------------------------------
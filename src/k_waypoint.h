@@ -357,6 +357,60 @@ waypoint_t *K_GetNextWaypointToDestination(
 	const boolean     huntbackwards);
 
 
+/*--------------------------------------------------
+	UINT32 K_GetWaypointDistanceToFinish(waypoint_t *const waypoint, const boolean useshortcuts);
+
+		Gets the length of the best route from a waypoint to the finish line, the same as the totaldist
+		K_PathfindToWaypoint would find. Distances for every waypoint are worked out once when the map loads, so
+		this doesn't pathfind.
+
+	Input Arguments:-
+		waypoint     - The waypoint to get the distance from
+		useshortcuts - Whether the route is allowed to use shortcut waypoints
+
+	Return:-
+		The distance to the finish line, UINT32_MAX if it can't be reached.
+--------------------------------------------------*/
+
+UINT32 K_GetWaypointDistanceToFinish(waypoint_t *const waypoint, const boolean useshortcuts);
+
+
+/*--------------------------------------------------
+	void K_UpdateWaypointPosition(mobj_t *const waypointmobj);
+
+		Must be called after a waypoint mobj moves or changes radius, so the waypoint grid used to find waypoints
+		near an mobj is rebuilt before the next search.
+
+	Input Arguments:-
+		waypointmobj - The waypoint mobj that was moved or resized
+--------------------------------------------------*/
+
+void K_UpdateWaypointPosition(mobj_t *const waypointmobj);
+
+
+/*--------------------------------------------------
+	void K_UpdateWaypointEnabled(mobj_t *const waypointmobj);
+
+		Must be called after changing whether a waypoint mobj is enabled, so the distances to the finish line can
+		be updated. Only the waypoints with routes affected by the change are recalculated.
+
+	Input Arguments:-
+		waypointmobj - The waypoint mobj that was enabled or disabled
+--------------------------------------------------*/
+
+void K_UpdateWaypointEnabled(mobj_t *const waypointmobj);
+
+
+/*--------------------------------------------------
+	void K_RefreshWaypointDistances(void);
+
+		Checks every waypoint for changes to whether it is enabled, and recalculates the distances to the finish
+		line if there were any. For after waypoint mobjs have been replaced wholesale, like loading a netgame.
+--------------------------------------------------*/
+
+void K_RefreshWaypointDistances(void);
+
+
 /*--------------------------------------------------
 	waypoint_t *K_SearchWaypointGraphForMobj(mobj_t *const mobj)
 
@@ -22,6 +22,7 @@
 #include "lua_libs.h"
 #include "lua_hud.h" // hud_running errors
 #include "lua_hook.h" // hook_cmd_running errors
+#include "k_waypoint.h"
 
 enum mobj_e {
 	mobj_valid = 0,
@@ -641,6 +642,8 @@ static int mobj_set(lua_State *L)
 		mo->radius = luaL_checkfixed(L, 3);
 		if (mo->radius < 0)
 			mo->radius = 0;
+		if (mo->type == MT_WAYPOINT)
+			K_UpdateWaypointPosition(mo);
 		P_CheckPosition(mo, mo->x, mo->y, NULL);
 		mo->floorz = g_tm.floorz;
 		mo->ceilingz = g_tm.ceilingz;
@@ -861,6 +864,8 @@ static int mobj_set(lua_State *L)
 		break;
 	case mobj_extravalue1:
 		mo->extravalue1 = luaL_checkinteger(L, 3);
+		if (mo->type == MT_WAYPOINT)
+			K_UpdateWaypointEnabled(mo); // extravalue1 is whether the waypoint is enabled
 		break;
 	case mobj_extravalue2:
 		mo->extravalue2 = luaL_checkinteger(L, 3);
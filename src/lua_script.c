@@ -835,6 +835,44 @@ void LUA_InvalidateUserdata(void *data)
 	lua_pop(gL, 1); // pop LREG_VALID
 }
 
+// When a lot of memory is freed at once, use this function to remove
+// everything it held from Lua in one pass, instead of one lookup per pointer.
+void LUA_InvalidateUserdataIf(boolean (*test)(void *data, void *arg), void *arg)
+{
+	void **userdata;
+	void *data;
+	if (!gL)
+		return;
+
+	lua_getfield(gL, LUA_REGISTRYINDEX, LREG_VALID);
+	I_Assert(lua_istable(gL, -1));
+	lua_getfield(gL, LUA_REGISTRYINDEX, LREG_EXTVARS);
+	I_Assert(lua_istable(gL, -1));
+	lua_pushnil(gL);
+	while (lua_next(gL, -3))
+	{
+		data = lua_touserdata(gL, -2);
+		if (test(data, arg))
+		{
+			// nullify any additional data
+			lua_pushlightuserdata(gL, data);
+			lua_pushnil(gL);
+			lua_rawset(gL, -5);
+
+			// invalidate the userdata
+			userdata = lua_touserdata(gL, -1);
+			*userdata = NULL;
+
+			// remove it from the registry, which is allowed while traversing
+			lua_pushvalue(gL, -2);
+			lua_pushnil(gL);
+			lua_rawset(gL, -6);
+		}
+		lua_pop(gL, 1); // keep the key for lua_next
+	}
+	lua_pop(gL, 2); // pop LREG_EXTVARS and LREG_VALID
+}
+
 // Invalidate level data arrays
 void LUA_InvalidateLevel(void)
 {
@@ -1700,14 +1738,11 @@ void LUA_UnArchive(savebuffer_t *save, boolean network)
 	{
 		do {
 			mobjnum = READUINT32(save->p); // read a mobjnum
-			for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
-			{
-				if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
-					continue;
-				if (((mobj_t *)th)->mobjnum != mobjnum) // find matching mobj
-					continue;
+			if (mobjnum == UINT32_MAX)
+				break;
+			th = (thinker_t *)P_FindNewPosition(mobjnum); // find matching mobj
+			if (th)
 				UnArchiveExtVars(&save->p, th); // apply variables
-			}
 		} while(mobjnum != UINT32_MAX); // repeat until end of mobjs marker.
 
 		LUA_HookNetArchive(NetUnArchive, save); // call the NetArchive hook in unarchive mode
@@ -102,6 +102,7 @@ lpushed_t LUA_RawPushUserdata(lua_State *L, void *data);
 int  LUA_PushServerPlayer(lua_State *L);
 
 void LUA_InvalidateUserdata(void *data);
+void LUA_InvalidateUserdataIf(boolean (*test)(void *data, void *arg), void *arg);
 
 void LUA_InvalidateLevel(void);
 void LUA_InvalidateMapthings(void);
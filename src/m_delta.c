@@ -0,0 +1,220 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_delta.c
+/// \brief Binary delta encoding of one buffer against another
+///
+/// The base is cut into fixed size blocks which are indexed by a rolling
+/// hash. The target is scanned with the same hash; every block hit is
+/// verified and grown in both directions, so data that only moved by a
+/// few bytes (an extra thinker, a longer string) still matches.
+///
+/// The stream is a list of (literal length, literal bytes, copy length,
+/// copy offset) records in variable length integers. It is not
+/// compressed by itself; callers are expected to run a general purpose
+/// compressor over it.
+
+#include "doomdef.h"
+#include "z_zone.h"
+#include "m_delta.h"
+
+#define DELTA_BLOCK 32
+#define DELTA_HASHBITS 16
+#define DELTA_MAXCHAIN 8
+#define DELTA_MULT 0x01000193u
+
+static UINT32 Delta_HashBlock(const UINT8 *p)
+{
+	UINT32 h = 0;
+	INT32 i;
+
+	for (i = 0; i < DELTA_BLOCK; i++)
+		h = h * DELTA_MULT + p[i];
+
+	return h;
+}
+
+static inline UINT32 Delta_Bucket(UINT32 h)
+{
+	return (h * 2654435761u) >> (32 - DELTA_HASHBITS);
+}
+
+static UINT8 *Delta_WriteVarint(UINT8 *p, size_t v)
+{
+	while (v >= 0x80)
+	{
+		*p++ = (UINT8)(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = (UINT8)v;
+	return p;
+}
+
+static boolean Delta_ReadVarint(const UINT8 **p, const UINT8 *end, size_t *v)
+{
+	size_t result = 0;
+	INT32 shift = 0;
+
+	while (*p < end && shift < (INT32)(sizeof (size_t) * 8))
+	{
+		UINT8 b = *(*p)++;
+		result |= (size_t)(b & 0x7F) << shift;
+		if (!(b & 0x80))
+		{
+			*v = result;
+			return true;
+		}
+		shift += 7;
+	}
+
+	return false;
+}
+
+size_t M_DeltaBound(size_t targetlen)
+{
+	// Every copy covers at least one block, and a record costs at most
+	// three varints of overhead.
+	return targetlen + (targetlen / DELTA_BLOCK + 2) * 3 * (sizeof (size_t) + 2);
+}
+
+size_t M_DeltaEncode(const UINT8 *base, size_t baselen, const UINT8 *target, size_t targetlen, UINT8 *out)
+{
+	UINT8 *p = out;
+	INT32 *head = NULL;
+	INT32 *next = NULL;
+	size_t nblocks = baselen / DELTA_BLOCK;
+	size_t lit = 0, i = 0;
+	UINT32 outmult = 1;
+	UINT32 h = 0;
+
+	if (nblocks > 0 && targetlen >= DELTA_BLOCK)
+	{
+		size_t b;
+
+		head = Z_Malloc(sizeof (*head) << DELTA_HASHBITS, PU_STATIC, NULL);
+		next = Z_Malloc(sizeof (*next) * nblocks, PU_STATIC, NULL);
+		memset(head, 0xFF, sizeof (*head) << DELTA_HASHBITS);
+
+		// Insert back to front, so chains are walked in base order.
+		for (b = nblocks; b-- > 0;)
+		{
+			UINT32 bucket = Delta_Bucket(Delta_HashBlock(base + b * DELTA_BLOCK));
+			next[b] = head[bucket];
+			head[bucket] = (INT32)b;
+		}
+
+		for (b = 1; b < DELTA_BLOCK; b++)
+			outmult *= DELTA_MULT;
+
+		h = Delta_HashBlock(target);
+	}
+
+	while (head != NULL && i + DELTA_BLOCK <= targetlen)
+	{
+		size_t bestlen = 0, bestoff = 0;
+		INT32 cand = head[Delta_Bucket(h)];
+		INT32 chain;
+
+		for (chain = 0; cand != -1 && chain < DELTA_MAXCHAIN; cand = next[cand], chain++)
+		{
+			size_t off = (size_t)cand * DELTA_BLOCK;
+			size_t len;
+
+			if (memcmp(base + off, target + i, DELTA_BLOCK) != 0)
+				continue;
+
+			len = DELTA_BLOCK;
+			while (i + len < targetlen && off + len < baselen && target[i + len] == base[off + len])
+				len++;
+
+			if (len > bestlen)
+			{
+				bestlen = len;
+				bestoff = off;
+			}
+		}
+
+		if (bestlen == 0)
+		{
+			if (i + DELTA_BLOCK < targetlen)
+				h = (h - target[i] * outmult) * DELTA_MULT + target[i + DELTA_BLOCK];
+			i++;
+			continue;
+		}
+
+		// Pull the match back over any literal bytes it also covers.
+		while (i > lit && bestoff > 0 && target[i - 1] == base[bestoff - 1])
+		{
+			i--;
+			bestoff--;
+			bestlen++;
+		}
+
+		p = Delta_WriteVarint(p, i - lit);
+		memcpy(p, target + lit, i - lit);
+		p += i - lit;
+		p = Delta_WriteVarint(p, bestlen);
+		p = Delta_WriteVarint(p, bestoff);
+
+		i += bestlen;
+		lit = i;
+
+		if (i + DELTA_BLOCK <= targetlen)
+			h = Delta_HashBlock(target + i);
+	}
+
+	// Whatever is left goes out as one last literal run.
+	if (lit < targetlen || p == out)
+	{
+		p = Delta_WriteVarint(p, targetlen - lit);
+		memcpy(p, target + lit, targetlen - lit);
+		p += targetlen - lit;
+	}
+
+	Z_Free(head);
+	Z_Free(next);
+
+	return p - out;
+}
+
+boolean M_DeltaDecode(const UINT8 *base, size_t baselen, const UINT8 *delta, size_t deltalen, UINT8 *target, size_t targetlen)
+{
+	const UINT8 *p = delta;
+	const UINT8 *end = delta + deltalen;
+	size_t out = 0;
+
+	while (true)
+	{
+		size_t litlen, copylen, copyoff;
+
+		if (!Delta_ReadVarint(&p, end, &litlen))
+			return false;
+		if (litlen > targetlen - out || litlen > (size_t)(end - p))
+			return false;
+
+		memcpy(target + out, p, litlen);
+		p += litlen;
+		out += litlen;
+
+		if (out == targetlen)
+			break;
+
+		if (!Delta_ReadVarint(&p, end, &copylen) || !Delta_ReadVarint(&p, end, &copyoff))
+			return false;
+		if (copylen > targetlen - out || copyoff > baselen || copylen > baselen - copyoff)
+			return false;
+
+		memcpy(target + out, base + copyoff, copylen);
+		out += copylen;
+
+		if (out == targetlen)
+			break;
+	}
+
+	return (p == end);
+}
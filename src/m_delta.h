@@ -0,0 +1,39 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  m_delta.h
+/// \brief Binary delta encoding of one buffer against another
+
+#ifndef M_DELTA_H
+#define M_DELTA_H
+
+#include "doomtype.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Worst case size of a delta produced for a target of the given length.
+size_t M_DeltaBound(size_t targetlen);
+
+// Encodes target as a sequence of literal runs and copies out of base.
+// out must hold at least M_DeltaBound(targetlen) bytes.
+// Returns the number of bytes written to out.
+size_t M_DeltaEncode(const UINT8 *base, size_t baselen, const UINT8 *target, size_t targetlen, UINT8 *out);
+
+// Rebuilds exactly targetlen bytes from a delta made by M_DeltaEncode.
+// Returns false if the delta is malformed or does not fit base.
+boolean M_DeltaDecode(const UINT8 *base, size_t baselen, const UINT8 *delta, size_t deltalen, UINT8 *target, size_t targetlen);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
+
+// EOF
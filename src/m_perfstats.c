@@ -53,14 +53,20 @@ precise_t ps_playerthink_time = 0;
 precise_t ps_botticcmd_time = 0;
 precise_t ps_thinkertime = 0;
 
+precise_t ps_pticker_time = 0;
 precise_t ps_thlist_times[NUM_ACTIVETHINKERLISTS];
 precise_t ps_acs_time = 0;
 
 int ps_checkposition_calls = 0;
+int ps_mobj_allocs = 0;
 
 precise_t ps_lua_thinkframe_time = 0;
 int ps_lua_mobjhooks = 0;
 
+precise_t ps_netsign_time = 0;
+precise_t ps_netverify_time = 0;
+int ps_netverify_calls = 0;
+
 // dynamically allocated resizeable array for thinkframe hook stats
 ps_hookinfo_t *thinkframe_hooks = NULL;
 int thinkframe_hooks_length = 0;
@@ -380,6 +386,14 @@ static void M_DrawTickStats(void)
 		{0}
 	};
 
+#ifdef SIGNGAMETRAFFIC
+	perfstatrow_t netcrypto_time_row[] = {
+		{"netsign", "Packet signing: ", &ps_netsign_time},
+		{"netvrfy", "Signature check:", &ps_netverify_time},
+		{0}
+	};
+#endif
+
 	perfstatrow_t thinkercount_row[] = {
 		{"thnkers", "Thinkers:       ", &thinkercount},
 		{0}
@@ -413,6 +427,10 @@ static void M_DrawTickStats(void)
 	perfstatrow_t misc_calls_row[] = {
 		{"lmhook", "Lua mobj hooks: ", &ps_lua_mobjhooks},
 		{"chkpos", "P_CheckPosition:", &ps_checkposition_calls},
+		{"mobjalc", "Mobj allocs:    ", &ps_mobj_allocs},
+#ifdef SIGNGAMETRAFFIC
+		{"sigchk", "Signatures:     ", &ps_netverify_calls},
+#endif
 		{0}
 	};
 
@@ -420,6 +438,9 @@ static void M_DrawTickStats(void)
 	perfstatcol_t          thinker_time_col  =  {24,  24, V_YELLOWMAP,          thinker_time_row};
 	perfstatcol_t detailed_thinker_time_col  =  {28,  28, V_YELLOWMAP, detailed_thinker_time_row};
 	perfstatcol_t    extra_thinker_time_col  =  {24,  24, V_YELLOWMAP,    extra_thinker_time_row};
+#ifdef SIGNGAMETRAFFIC
+	perfstatcol_t        netcrypto_time_col  =  {24,  24, V_YELLOWMAP,        netcrypto_time_row};
+#endif
 
 	perfstatcol_t          thinkercount_col  =  {90, 115, V_BLUEMAP,            thinkercount_row};
 	perfstatcol_t detailed_thinkercount_col  =  {94, 119, V_BLUEMAP,   detailed_thinkercount_row};
@@ -465,6 +486,9 @@ static void M_DrawTickStats(void)
 	M_DrawPerfTiming(&thinker_time_col);
 	M_DrawPerfTiming(&detailed_thinker_time_col);
 	M_DrawPerfTiming(&extra_thinker_time_col);
+#ifdef SIGNGAMETRAFFIC
+	M_DrawPerfTiming(&netcrypto_time_col);
+#endif
 
 	draw_row = 10;
 	M_DrawPerfCount(&thinkercount_col);
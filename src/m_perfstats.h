@@ -37,14 +37,20 @@ extern precise_t ps_playerthink_time;
 extern precise_t ps_botticcmd_time;
 extern precise_t ps_thinkertime;
 
+extern precise_t ps_pticker_time;
 extern precise_t ps_thlist_times[];
 extern precise_t ps_acs_time;
 
 extern int       ps_checkposition_calls;
+extern int       ps_mobj_allocs;
 
 extern precise_t ps_lua_thinkframe_time;
 extern int       ps_lua_mobjhooks;
 
+extern precise_t ps_netsign_time;
+extern precise_t ps_netverify_time;
+extern int       ps_netverify_calls;
+
 struct ps_hookinfo_t
 {
 	precise_t time_taken;
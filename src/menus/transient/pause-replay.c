@@ -229,8 +229,16 @@ void M_PlaybackRewind(INT32 choice)
 	CV_SetValue(&cv_playbackspeed, 1);
 #else
 	(void)choice;
-	G_DoPlayDemo(NULL); // Restart the current demo
-	M_ClearMenus(true);
+
+	// Jump back through the replay's keyframes;
+	// G_ConfirmRewind restarts the demo near the start.
+	if (leveltime > starttime + 5*TICRATE)
+		G_ConfirmRewind(leveltime - 5*TICRATE);
+	else
+	{
+		G_DoPlayDemo(NULL); // Restart the current demo
+		M_ClearMenus(true);
+	}
 #endif
 }
 
@@ -11,6 +11,7 @@
 #include "music_manager.hpp"
 #include "music_tune.hpp"
 
+#include "doomstat.h"
 #include "doomtype.h"
 #include "music.h"
 
@@ -469,3 +470,20 @@ void Music_ResetLevelVolume(void)
 {
 	g_tunes.level_volume(100, true);
 }
+
+void Music_PrefetchMap(UINT16 mapnum, boolean encore)
+{
+	if (mapnum >= nummapheaders || !mapheaderinfo[mapnum])
+	{
+		return;
+	}
+
+	const mapheader_t* mapheader = mapheaderinfo[mapnum];
+
+	g_tunes.prefetch(encore && mapheader->encoremusname_size ? mapheader->encoremusname[0] : mapheader->musname[0]);
+}
+
+void Music_DropPrefetch(const char* keep)
+{
+	g_tunes.drop_prefetch(keep);
+}
@@ -116,6 +116,15 @@ void Music_LevelVolume(int volume);
 // music is resuming after another tune ended.
 void Music_ResetLevelVolume(void);
 
+// Start loading a map's level music ahead of time, once it's
+// known which map is next. Alt music is picked when the map
+// loads, so only the first track is prefetched.
+void Music_PrefetchMap(UINT16 mapnum, boolean encore);
+
+// Once the level has picked its music, a prefetched song that
+// isn't it won't be played, so let it go.
+void Music_DropPrefetch(const char *keep);
+
 
 //
 // Query properties.
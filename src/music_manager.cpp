@@ -165,6 +165,28 @@ void TuneManager::pause_unpause() const
 	}
 }
 
+void TuneManager::prefetch(const char* song) const
+{
+	if (S_MusicDisabled() || song[0] == '\0' || current_song_ == song)
+	{
+		return;
+	}
+
+	lumpnum_t lumpnum = W_CheckNumForLongName(fmt::format("O_{}", song).c_str());
+
+	if (lumpnum == LUMPERROR)
+	{
+		return;
+	}
+
+	I_PrefetchSong(song, static_cast<char*>(W_CacheLumpNum(lumpnum, PU_MUSIC)), W_LumpLength(lumpnum));
+}
+
+void TuneManager::drop_prefetch(const char* keep) const
+{
+	I_DropPrefetchedSong(keep);
+}
+
 bool TuneManager::load() const
 {
 	lumpnum_t lumpnum = W_CheckNumForLongName(fmt::format("O_{}", current_song_).c_str());
@@ -174,6 +196,11 @@ bool TuneManager::load() const
 		return false;
 	}
 
+	if (I_LoadPrefetchedSong(current_song_.c_str()))
+	{
+		return true;
+	}
+
 	return I_LoadSong(static_cast<char*>(W_CacheLumpNum(lumpnum, PU_MUSIC)), W_LumpLength(lumpnum));
 }
 
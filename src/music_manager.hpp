@@ -59,6 +59,13 @@ public:
 	void tick();
 	void pause_unpause() const;
 
+	// Starts loading a song that is about to play, so the
+	// tick that switches to it doesn't have to.
+	void prefetch(const char* song) const;
+
+	// Forgets the prefetched song, unless it's keep.
+	void drop_prefetch(const char* keep) const;
+
 	void stop(Tune& tune)
 	{
 		tune.stop();
@@ -152,15 +152,10 @@ static void UFOUpdateDistanceToFinish(mobj_t *ufo)
 	if (nextWaypoint != NULL && finishLine != NULL)
 	{
 		const boolean useshortcuts = false;
-		const boolean huntbackwards = false;
-		boolean pathfindsuccess = false;
-		path_t pathtofinish = {0};
-
-		pathfindsuccess =
-			K_PathfindToWaypoint(nextWaypoint, finishLine, &pathtofinish, useshortcuts, huntbackwards);
+		const UINT32 disttofinish = K_GetWaypointDistanceToFinish(nextWaypoint, useshortcuts);
 
 		// Update the UFO's distance to the finish line if a path was found.
-		if (pathfindsuccess == true)
+		if (disttofinish != UINT32_MAX)
 		{
 			// Add euclidean distance to the next waypoint to the distancetofinish
 			UINT32 adddist;
@@ -172,8 +167,7 @@ static void UFOUpdateDistanceToFinish(mobj_t *ufo)
 
 			adddist = (UINT32)disttowaypoint;
 
-			ufo_distancetofinish(ufo) = pathtofinish.totaldist + adddist;
-			Z_Free(pathtofinish.array);
+			ufo_distancetofinish(ufo) = disttofinish + adddist;
 		}
 	}
 }
@@ -78,7 +78,6 @@ typedef enum
 	NUM_THINKERLISTS
 } thinklistnum_t; /**< Thinker lists. */
 extern thinker_t thlist[];
-extern mobj_t *mobjcache;
 
 void P_InitThinkers(void);
 void P_InvalidateThinkersWithoutInit(void);
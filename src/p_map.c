@@ -19,6 +19,7 @@
 #include "m_bbox.h"
 #include "m_random.h"
 #include "p_local.h"
+#include "p_synchash.h"
 #include "p_setup.h" // NiGHTS stuff
 #include "r_fps.h"
 #include "r_state.h"
@@ -4386,6 +4387,9 @@ boolean P_CheckSector(sector_t *sector, boolean crunch)
 	nofit = false;
 	crushchange = crunch;
 
+	// Every plane move ends up here
+	P_SyncHashSector(sector);
+
 	// killough 4/4/98: scan list front-to-back until empty or exhausted,
 	// restarting from beginning after each thing is processed. Avoids
 	// crashes, and is sure to examine all things in the sector, and only
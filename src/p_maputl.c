@@ -17,7 +17,9 @@
 #include "doomstat.h"
 
 #include "k_kart.h"
+#include "k_waypoint.h"
 #include "p_local.h"
+#include "p_synchash.h"
 #include "r_main.h"
 #include "r_data.h"
 #include "r_textures.h"
@@ -1208,6 +1210,14 @@ void P_SetThingPosition(mobj_t *thing)
 		else if (thing->z <= tfloorz)
 			thing->eflags |= MFE_JUSTSTEPPEDDOWN;
 	}
+
+	// Catches mobjs moved by something other than their own thinker
+	P_SyncHashMobj(thing);
+
+	if (thing->type == MT_WAYPOINT)
+	{
+		K_UpdateWaypointPosition(thing);
+	}
 }
 
 //
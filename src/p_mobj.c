@@ -19,6 +19,8 @@
 #include "st_stuff.h"
 #include "hu_stuff.h"
 #include "p_local.h"
+#include "p_mobjpool.h"
+#include "p_synchash.h"
 #include "p_setup.h"
 #include "r_fps.h"
 #include "r_main.h"
@@ -52,6 +54,7 @@
 #include "k_director.h"
 #include "m_easing.h"
 #include "k_podium.h"
+#include "k_waypoint.h"
 #include "g_party.h"
 
 actioncache_t actioncachehead;
@@ -64,8 +67,6 @@ mobj_t *waypointcap = NULL;
 // general purpose.
 mobj_t *trackercap = NULL;
 
-mobj_t *mobjcache = NULL;
-
 void P_InitCachedActions(void)
 {
 	actioncachehead.prev = actioncachehead.next = &actioncachehead;
@@ -4905,6 +4906,11 @@ void P_SetScale(mobj_t *mobj, fixed_t newscale)
 	mobj->radius = FixedMul(FixedDiv(mobj->radius, oldscale), newscale);
 	mobj->height = FixedMul(FixedDiv(mobj->height, oldscale), newscale);
 
+	if (mobj->type == MT_WAYPOINT && newscale != oldscale)
+	{
+		K_UpdateWaypointPosition(mobj);
+	}
+
 	player = mobj->player;
 
 	if (player)
@@ -10761,16 +10767,7 @@ mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
 		type = MT_RAY;
 	}
 
-	if (mobjcache != NULL)
-	{
-		mobj = mobjcache;
-		mobjcache = mobjcache->hnext;
-		memset(mobj, 0, sizeof(*mobj));
-	}
-	else
-	{
-		mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
-	}
+	mobj = P_MobjPoolAlloc();
 
 	// this is officially a mobj, declared as soon as possible.
 	mobj->thinker.function.acp1 = (actionf_p1)P_MobjThinker;
@@ -11249,6 +11246,8 @@ mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
 	if (P_IsTrackerType(mobj->type))
 		P_LinkTracker(mobj);
 
+	P_SyncHashMobj(mobj);
+
 	return mobj;
 }
 
@@ -11257,7 +11256,7 @@ static precipmobj_t *P_SpawnPrecipMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype
 	const mobjinfo_t *info = &mobjinfo[type];
 	state_t *st;
 	fixed_t start_z = INT32_MIN;
-	precipmobj_t *mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+	precipmobj_t *mobj = P_PrecipPoolAlloc();
 
 	mobj->type = type;
 	mobj->info = info;
@@ -11476,6 +11475,8 @@ void P_RemoveMobj(mobj_t *mobj)
 
 	mobj->health = 0; // Just because
 
+	P_SyncHashRemoveMobj(mobj);
+
 	// unlink from tid chains
 	P_RemoveThingTID(mobj);
 
@@ -11541,9 +11542,8 @@ void P_RemoveMobj(mobj_t *mobj)
 		INT32 prevreferences;
 		if (!mobj->thinker.references)
 		{
-			// no references, dump it directly in the mobj cache
-			mobj->hnext = mobjcache;
-			mobjcache = mobj;
+			// no references, give it straight back to the pool
+			P_MobjPoolFree(mobj);
 			return;
 		}
 
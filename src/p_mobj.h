@@ -450,6 +450,8 @@ struct mobj_t
 
 	INT32 po_movecount; // Polyobject carrying (NOT savegame, NOT Lua)
 
+	UINT32 synchash; // Share of the world hash, see p_synchash.c (NOT Lua)
+
 	// WARNING: New fields must be added separately to savegame and Lua.
 };
 
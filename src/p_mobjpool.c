@@ -0,0 +1,237 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_mobjpool.c
+/// \brief Slab pools for mobjs and precipitation mobjs
+///
+/// Particles and terrain effects spawn and remove mobjs all the time, so
+/// mobjs are carved out of slabs of slots and freed slots are reused
+/// before a new slab is made. Every slot has a fixed index and a
+/// generation that is bumped when it is freed; together they make the
+/// mobjnum, which netsaves use to find mobjs again without a search.
+
+#include <stddef.h>
+#include <stdalign.h>
+
+#include "doomdef.h"
+#include "lua_script.h"
+#include "m_perfstats.h"
+#include "p_local.h"
+#include "p_mobjpool.h"
+#include "z_zone.h"
+
+// Slots per slab
+#define POOLSLABSIZE 256
+
+// A mobjnum is the slot's index + 1 in the low bits and the
+// generation in the high bits, so 0 is never a valid mobjnum.
+#define MOBJNUMINDEXBITS 20
+#define MOBJNUMINDEXMASK ((1u << MOBJNUMINDEXBITS) - 1)
+#define MOBJNUMGENMASK ((1u << (32 - MOBJNUMINDEXBITS)) - 1)
+#define MAXPOOLSLOTS (MOBJNUMINDEXMASK - 1)
+
+#define POOLALIGN(x) (((x) + (alignof (max_align_t) - 1)) & ~(alignof (max_align_t) - 1))
+
+typedef struct
+{
+	UINT32 index;
+	UINT32 generation; // bumped every time the slot is freed
+	UINT32 prevfree, nextfree; // index + 1 in the free list, 0 ends it
+	boolean inuse;
+} poolslot_t;
+
+#define SLOTOBJECT(slot) ((void *)((UINT8 *)(slot) + POOLALIGN(sizeof (poolslot_t))))
+#define OBJECTSLOT(obj) ((poolslot_t *)((UINT8 *)(obj) - POOLALIGN(sizeof (poolslot_t))))
+
+typedef struct
+{
+	size_t slotsize; // header + object
+	UINT8 **slabs;
+	UINT32 numslabs;
+	UINT32 freehead; // index + 1 of the first free slot, 0 if none
+} mobjpool_t;
+
+static mobjpool_t mobjpool = {POOLALIGN(sizeof (poolslot_t)) + POOLALIGN(sizeof (mobj_t)), NULL, 0, 0};
+static mobjpool_t precippool = {POOLALIGN(sizeof (poolslot_t)) + POOLALIGN(sizeof (precipmobj_t)), NULL, 0, 0};
+
+UINT32 mobjpoolmisplaced = 0;
+
+static poolslot_t *Pool_Slot(const mobjpool_t *pool, UINT32 index)
+{
+	return (poolslot_t *)(pool->slabs[index / POOLSLABSIZE] + (index % POOLSLABSIZE) * pool->slotsize);
+}
+
+static void Pool_Clear(mobjpool_t *pool)
+{
+	// The slabs went with the level
+	pool->slabs = NULL;
+	pool->numslabs = 0;
+	pool->freehead = 0;
+}
+
+static void Pool_Grow(mobjpool_t *pool)
+{
+	UINT32 first = pool->numslabs * POOLSLABSIZE;
+	UINT32 i;
+
+	if (first + POOLSLABSIZE > MAXPOOLSLOTS)
+		I_Error("Pool_Grow: too many mobjs");
+
+	pool->slabs = Z_Realloc(pool->slabs, (pool->numslabs + 1) * sizeof *pool->slabs, PU_LEVEL, NULL);
+	pool->slabs[pool->numslabs++] = Z_Malloc(POOLSLABSIZE * pool->slotsize, PU_LEVEL, NULL);
+
+	// Push in reverse, so the lowest index comes out first
+	for (i = first + POOLSLABSIZE; i-- > first;)
+	{
+		poolslot_t *slot = Pool_Slot(pool, i);
+
+		slot->index = i;
+		slot->generation = 0;
+		slot->inuse = false;
+		slot->prevfree = 0;
+		slot->nextfree = pool->freehead;
+		if (pool->freehead)
+			Pool_Slot(pool, pool->freehead - 1)->prevfree = i + 1;
+		pool->freehead = i + 1;
+	}
+}
+
+static void Pool_Take(mobjpool_t *pool, poolslot_t *slot)
+{
+	if (slot->prevfree)
+		Pool_Slot(pool, slot->prevfree - 1)->nextfree = slot->nextfree;
+	else
+		pool->freehead = slot->nextfree;
+
+	if (slot->nextfree)
+		Pool_Slot(pool, slot->nextfree - 1)->prevfree = slot->prevfree;
+
+	slot->inuse = true;
+	memset(SLOTOBJECT(slot), 0, pool->slotsize - POOLALIGN(sizeof (poolslot_t)));
+	ps_mobj_allocs++;
+}
+
+static poolslot_t *Pool_Alloc(mobjpool_t *pool)
+{
+	poolslot_t *slot;
+
+	if (!pool->freehead)
+		Pool_Grow(pool);
+
+	slot = Pool_Slot(pool, pool->freehead - 1);
+	Pool_Take(pool, slot);
+	return slot;
+}
+
+static void Pool_Free(mobjpool_t *pool, void *obj)
+{
+	poolslot_t *slot = OBJECTSLOT(obj);
+
+	I_Assert(slot->inuse);
+
+	slot->inuse = false;
+	slot->generation++;
+	slot->prevfree = 0;
+	slot->nextfree = pool->freehead;
+	if (pool->freehead)
+		Pool_Slot(pool, pool->freehead - 1)->prevfree = slot->index + 1;
+	pool->freehead = slot->index + 1;
+}
+
+static UINT32 MobjNum(const poolslot_t *slot)
+{
+	return ((slot->generation & MOBJNUMGENMASK) << MOBJNUMINDEXBITS) | (slot->index + 1);
+}
+
+void P_ClearMobjPools(void)
+{
+	Pool_Clear(&mobjpool);
+	Pool_Clear(&precippool);
+	mobjpoolmisplaced = 0;
+}
+
+mobj_t *P_MobjPoolAlloc(void)
+{
+	poolslot_t *slot = Pool_Alloc(&mobjpool);
+	mobj_t *mobj = SLOTOBJECT(slot);
+
+	mobj->mobjnum = MobjNum(slot);
+	return mobj;
+}
+
+mobj_t *P_MobjPoolAllocNum(UINT32 mobjnum)
+{
+	UINT32 index = (mobjnum & MOBJNUMINDEXMASK) - 1;
+	poolslot_t *slot;
+	mobj_t *mobj;
+
+	if (mobjnum == 0 || index >= MAXPOOLSLOTS)
+	{
+		mobjpoolmisplaced++;
+		return P_MobjPoolAlloc();
+	}
+
+	while (index >= mobjpool.numslabs * POOLSLABSIZE)
+		Pool_Grow(&mobjpool);
+
+	slot = Pool_Slot(&mobjpool, index);
+	if (slot->inuse)
+	{
+		// Something left over from before the netsave has the slot. It
+		// can't keep the number, and this mobj has to be found the slow way.
+		((mobj_t *)SLOTOBJECT(slot))->mobjnum = 0;
+		mobjpoolmisplaced++;
+		mobj = P_MobjPoolAlloc();
+	}
+	else
+	{
+		slot->generation = mobjnum >> MOBJNUMINDEXBITS;
+		Pool_Take(&mobjpool, slot);
+		mobj = SLOTOBJECT(slot);
+	}
+
+	mobj->mobjnum = mobjnum;
+	return mobj;
+}
+
+void P_MobjPoolFree(mobj_t *mobj)
+{
+	// The slab outlives the mobj, so Z_Free won't do this for us
+	LUA_InvalidateUserdata(mobj);
+	Pool_Free(&mobjpool, mobj);
+}
+
+mobj_t *P_MobjFromNum(UINT32 mobjnum)
+{
+	UINT32 index = (mobjnum & MOBJNUMINDEXMASK) - 1;
+	poolslot_t *slot;
+	mobj_t *mobj;
+
+	if (mobjnum == 0 || index >= mobjpool.numslabs * POOLSLABSIZE)
+		return NULL;
+
+	slot = Pool_Slot(&mobjpool, index);
+	if (!slot->inuse)
+		return NULL;
+
+	mobj = SLOTOBJECT(slot);
+	if (mobj->mobjnum != mobjnum)
+		return NULL;
+
+	return mobj;
+}
+
+precipmobj_t *P_PrecipPoolAlloc(void)
+{
+	return SLOTOBJECT(Pool_Alloc(&precippool));
+}
+
+void P_PrecipPoolFree(precipmobj_t *mobj)
+{
+	Pool_Free(&precippool, mobj);
+}
@@ -0,0 +1,52 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_mobjpool.h
+/// \brief Slab pools for mobjs and precipitation mobjs
+
+#ifndef __P_MOBJPOOL__
+#define __P_MOBJPOOL__
+
+#include "doomtype.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Pool memory is PU_LEVEL, so this must follow Z_FreeTags(PU_LEVEL)
+void P_ClearMobjPools(void);
+
+// Returns a zeroed mobj. Its mobjnum is set from the slot's index and
+// how many times it was reused, so no two live mobjs share one. Only
+// the low 12 bits of the reuse count fit, so a number kept from a
+// long gone mobj can match a newer one in the same slot.
+mobj_t *P_MobjPoolAlloc(void);
+
+// Same, but takes the slot the number refers to if it is free, so
+// a netsave's mobjnums can be looked up with P_MobjFromNum. mobjnum
+// is set to the given number either way.
+mobj_t *P_MobjPoolAllocNum(UINT32 mobjnum);
+
+// Also invalidates any Lua userdata for the mobj
+void P_MobjPoolFree(mobj_t *mobj);
+
+// The mobj currently using the given mobjnum, or NULL
+mobj_t *P_MobjFromNum(UINT32 mobjnum);
+
+// How many mobjs since the last P_ClearMobjPools didn't get the
+// slot they asked P_MobjPoolAllocNum for
+extern UINT32 mobjpoolmisplaced;
+
+precipmobj_t *P_PrecipPoolAlloc(void);
+void P_PrecipPoolFree(precipmobj_t *mobj);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
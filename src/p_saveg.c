@@ -20,6 +20,8 @@
 #include "m_random.h"
 #include "m_misc.h"
 #include "p_local.h"
+#include "p_mobjpool.h"
+#include "p_synchash.h"
 #include "p_setup.h"
 #include "p_saveg.h"
 #include "r_data.h"
@@ -49,6 +51,7 @@
 #include "k_vote.h"
 #include "k_zvote.h"
 #include "k_endcam.h"
+#include "core/thread_pool.h"
 
 #include <tracy/tracy/TracyC.h>
 
@@ -2711,6 +2714,51 @@ static void UnArchiveLines(savebuffer_t *save)
 	}
 }
 
+// Only the sector shares of the world hash that differ from a fresh
+// hash are sent; see p_synchash.c.
+static void ArchiveSectorSyncHashes(savebuffer_t *save)
+{
+	UINT16 count = 0;
+	size_t i;
+
+	for (i = 0; i < numsectors; i++)
+	{
+		if (sectors[i].synchash != P_SectorSyncHash(&sectors[i]))
+			count++;
+	}
+
+	WRITEUINT16(save->p, count);
+
+	for (i = 0; i < numsectors && count > 0; i++)
+	{
+		if (sectors[i].synchash != P_SectorSyncHash(&sectors[i]))
+		{
+			WRITEUINT16(save->p, i);
+			WRITEUINT32(save->p, sectors[i].synchash);
+			count--;
+		}
+	}
+}
+
+static void UnArchiveSectorSyncHashes(savebuffer_t *save)
+{
+	UINT16 count;
+	size_t i;
+
+	for (i = 0; i < numsectors; i++)
+		sectors[i].synchash = P_SectorSyncHash(&sectors[i]);
+
+	count = READUINT16(save->p);
+
+	while (count--)
+	{
+		i = READUINT16(save->p);
+		if (i >= numsectors)
+			I_Error("Invalid sector number %s from server", sizeu1(i));
+		sectors[i].synchash = READUINT32(save->p);
+	}
+}
+
 static void P_NetArchiveWorld(savebuffer_t *save)
 {
 	TracyCZone(__zone, true);
@@ -2722,6 +2770,7 @@ static void P_NetArchiveWorld(savebuffer_t *save)
 
 	ArchiveSectors(save);
 	ArchiveLines(save);
+	ArchiveSectorSyncHashes(save);
 	R_ClearTextureNumCache(false);
 
 	TracyCZoneEnd(__zone);
@@ -2749,6 +2798,7 @@ static void P_NetUnArchiveWorld(savebuffer_t *save)
 
 	UnArchiveSectors(save);
 	UnArchiveLines(save);
+	UnArchiveSectorSyncHashes(save);
 
 	TracyCZoneEnd(__zone);
 }
@@ -2882,6 +2932,7 @@ typedef enum
 	MD3_REAPPEAR		= 1<<1,
 	MD3_PUNT_REF		= 1<<2,
 	MD3_OWNER			= 1<<3,
+	MD3_SYNCHASH		= 1<<4,
 } mobj_diff3_t;
 
 typedef enum
@@ -3208,6 +3259,8 @@ static void SaveMobjThinker(savebuffer_t *save, const thinker_t *th, const UINT8
 		diff3 |= MD3_PUNT_REF;
 	if (mobj->owner)
 		diff3 |= MD3_OWNER;
+	if (mobj->synchash != P_MobjSyncHash(mobj))
+		diff3 |= MD3_SYNCHASH;
 
 	if (diff3 != 0)
 		diff2 |= MD2_MORE;
@@ -3220,6 +3273,7 @@ static void SaveMobjThinker(savebuffer_t *save, const thinker_t *th, const UINT8
 		diff = MD_SPAWNPOINT;
 
 	WRITEUINT8(save->p, type);
+	WRITEUINT32(save->p, mobj->mobjnum); // first, so the loader can allocate the same slot
 	WRITEUINT32(save->p, diff);
 	if (diff & MD_MORE)
 		WRITEUINT32(save->p, diff2);
@@ -3500,8 +3554,10 @@ static void SaveMobjThinker(savebuffer_t *save, const thinker_t *th, const UINT8
 	{
 		WRITEUINT32(save->p, mobj->owner->mobjnum);
 	}
-
-	WRITEUINT32(save->p, mobj->mobjnum);
+	if (diff3 & MD3_SYNCHASH)
+	{
+		WRITEUINT32(save->p, mobj->synchash);
+	}
 }
 
 static void SaveNoEnemiesThinker(savebuffer_t *save, const thinker_t *th, const UINT8 type)
@@ -4001,7 +4057,324 @@ static void WriteMobjPointer(mobj_t *mobj)
 	WRITEUINT32(current_savebuffer->p, SaveMobjnum(mobj));
 }
 
-static void P_NetArchiveThinkers(savebuffer_t *save)
+static void SaveThinker(savebuffer_t *save, const thinker_t *th)
+{
+	if (th->function.acp1 == (actionf_p1)P_MobjThinker)
+	{
+		SaveMobjThinker(save, th, tc_mobj);
+		return;
+	}
+#ifdef PARANOIA
+	else if (th->function.acp1 == (actionf_p1)P_NullPrecipThinker);
+#endif
+	else if (th->function.acp1 == (actionf_p1)T_MoveCeiling)
+	{
+		SaveCeilingThinker(save, th, tc_ceiling);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_CrushCeiling)
+	{
+		SaveCeilingThinker(save, th, tc_crushceiling);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_MoveFloor)
+	{
+		SaveFloormoveThinker(save, th, tc_floor);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_LightningFlash)
+	{
+		SaveLightflashThinker(save, th, tc_flash);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_StrobeFlash)
+	{
+		SaveStrobeThinker(save, th, tc_strobe);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_Glow)
+	{
+		SaveGlowThinker(save, th, tc_glow);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_FireFlicker)
+	{
+		SaveFireflickerThinker(save, th, tc_fireflicker);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_MoveElevator)
+	{
+		SaveElevatorThinker(save, th, tc_elevator);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_ContinuousFalling)
+	{
+		SaveContinuousFallThinker(save, th, tc_continuousfalling);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_ThwompSector)
+	{
+		SaveThwompThinker(save, th, tc_thwomp);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_NoEnemiesSector)
+	{
+		SaveNoEnemiesThinker(save, th, tc_noenemies);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_EachTimeThinker)
+	{
+		SaveEachTimeThinker(save, th, tc_eachtime);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_RaiseSector)
+	{
+		SaveRaiseThinker(save, th, tc_raisesector);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_CameraScanner)
+	{
+		SaveElevatorThinker(save, th, tc_camerascanner);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_Scroll)
+	{
+		SaveScrollThinker(save, th, tc_scroll);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_Friction)
+	{
+		SaveFrictionThinker(save, th, tc_friction);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_Pusher)
+	{
+		SavePusherThinker(save, th, tc_pusher);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_BounceCheese)
+	{
+		SaveBounceCheeseThinker(save, th, tc_bouncecheese);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_StartCrumble)
+	{
+		SaveCrumbleThinker(save, th, tc_startcrumble);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_MarioBlock)
+	{
+		SaveMarioBlockThinker(save, th, tc_marioblock);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_MarioBlockChecker)
+	{
+		SaveMarioCheckThinker(save, th, tc_marioblockchecker);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_FloatSector)
+	{
+		SaveFloatThinker(save, th, tc_floatsector);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_LaserFlash)
+	{
+		SaveLaserThinker(save, th, tc_laserflash);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_LightFade)
+	{
+		SaveLightlevelThinker(save, th, tc_lightfade);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_ExecutorDelay)
+	{
+		SaveExecutorThinker(save, th, tc_executor);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_Disappear)
+	{
+		SaveDisappearThinker(save, th, tc_disappear);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_Fade)
+	{
+		SaveFadeThinker(save, th, tc_fade);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_FadeColormap)
+	{
+		SaveFadeColormapThinker(save, th, tc_fadecolormap);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PlaneDisplace)
+	{
+		SavePlaneDisplaceThinker(save, th, tc_planedisplace);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjRotate)
+	{
+		SavePolyrotatetThinker(save, th, tc_polyrotate);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjMove)
+	{
+		SavePolymoveThinker(save, th, tc_polymove);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjWaypoint)
+	{
+		SavePolywaypointThinker(save, th, tc_polywaypoint);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyDoorSlide)
+	{
+		SavePolyslidedoorThinker(save, th, tc_polyslidedoor);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyDoorSwing)
+	{
+		SavePolyswingdoorThinker(save, th, tc_polyswingdoor);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjFlag)
+	{
+		SavePolymoveThinker(save, th, tc_polyflag);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjDisplace)
+	{
+		SavePolydisplaceThinker(save, th, tc_polydisplace);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjRotDisplace)
+	{
+		SavePolyrotdisplaceThinker(save, th, tc_polyrotdisplace);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_PolyObjFade)
+	{
+		SavePolyfadeThinker(save, th, tc_polyfade);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_DynamicSlopeLine)
+	{
+		SaveDynamicLineSlopeThinker(save, th, tc_dynslopeline);
+		return;
+	}
+	else if (th->function.acp1 == (actionf_p1)T_DynamicSlopeVert)
+	{
+		SaveDynamicVertexSlopeThinker(save, th, tc_dynslopevert);
+		return;
+	}
+#ifdef PARANOIA
+	else
+		I_Assert(th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed); // wait garbage collection
+#endif
+}
+
+// The mobj list is most of a netsave. It is cut into slices that the
+// thread pool serializes into buffers of their own, while the main
+// thread writes the sections after it; P_JoinThinkerSlices then puts
+// everything back in list order. Saving a thinker only reads the
+// world, and mobjnums are assigned up front, so the slices are
+// independent of each other.
+#define THINKERSLICESIZE 256
+#define MAXTHINKERSLICES 8
+
+typedef struct
+{
+	const thinker_t *first;
+	const thinker_t *end;
+	savebuffer_t save;
+} thinkerslice_t;
+
+static thinkerslice_t thinkerslices[MAXTHINKERSLICES];
+static size_t numthinkerslices = 0;
+#ifdef HAVE_THREADS
+static srb2ctaskgroup_t *thinkerslicegroup = NULL;
+#endif
+
+static void SaveThinkerSlice(void *data)
+{
+	thinkerslice_t *slice = data;
+	const thinker_t *th;
+
+	for (th = slice->first; th != slice->end; th = th->next)
+		SaveThinker(&slice->save, th);
+}
+
+static void P_DispatchThinkerSlices(const thinker_t *list, UINT32 count)
+{
+	const thinker_t *th = list->next;
+	size_t i;
+
+	numthinkerslices = min(MAXTHINKERSLICES, max(1, count / THINKERSLICESIZE));
+
+	for (i = 0; i < numthinkerslices; i++)
+	{
+		thinkerslice_t *slice = &thinkerslices[i];
+		UINT32 n = (i == numthinkerslices - 1) ? UINT32_MAX : count / numthinkerslices;
+
+		slice->first = th;
+		while (th != list && n--)
+			th = th->next;
+		slice->end = th;
+
+		// Workers can't touch the zone, so the buffers are made here.
+		if (P_SaveBufferAlloc(&slice->save, NETSAVEGAMESIZE) == false)
+			I_Error("No more free memory for savegame");
+	}
+
+#ifdef HAVE_THREADS
+	if (numthinkerslices > 1)
+	{
+		thinkerslicegroup = I_ThreadPoolNewGroup();
+		for (i = 0; i < numthinkerslices; i++)
+			I_ThreadPoolSubmitGroup(thinkerslicegroup, SaveThinkerSlice, &thinkerslices[i]);
+		return;
+	}
+#endif
+
+	for (i = 0; i < numthinkerslices; i++)
+		SaveThinkerSlice(&thinkerslices[i]);
+}
+
+static void P_AppendSaveBuffer(savebuffer_t *save, savebuffer_t *from)
+{
+	size_t length = from->p - from->buffer;
+
+	if (length > from->size || length > P_SaveBufferRemaining(save))
+		I_Error("Savegame buffer overrun");
+
+	memcpy(save->p, from->buffer, length);
+	save->p += length;
+
+	P_SaveBufferFree(from);
+}
+
+static void P_JoinThinkerSlices(savebuffer_t *save, savebuffer_t *tail)
+{
+	size_t i;
+
+#ifdef HAVE_THREADS
+	if (thinkerslicegroup != NULL)
+	{
+		I_ThreadPoolWaitGroup(thinkerslicegroup);
+		thinkerslicegroup = NULL;
+	}
+#endif
+
+	for (i = 0; i < numthinkerslices; i++)
+		P_AppendSaveBuffer(save, &thinkerslices[i].save);
+	numthinkerslices = 0;
+
+	P_AppendSaveBuffer(save, tail);
+}
+
+// Everything up to the mobj list goes to save, the mobj list to the
+// thread pool, and the rest to tail.
+static void P_NetArchiveThinkers(savebuffer_t *save, savebuffer_t *tail)
 {
 	TracyCZone(__zone, true);
 
@@ -4015,225 +4388,26 @@ static void P_NetArchiveThinkers(savebuffer_t *save)
 	for (i = 0; i < NUM_THINKERLISTS; i++)
 	{
 		UINT32 numsaved = 0;
-		// save off the current thinkers
+		UINT32 numthinkers = 0;
+
 		for (th = thlist[i].next; th != &thlist[i]; th = th->next)
 		{
 			if (!(th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed
 			 || th->function.acp1 == (actionf_p1)P_NullPrecipThinker))
 				numsaved++;
+			numthinkers++;
+		}
 
-			if (th->function.acp1 == (actionf_p1)P_MobjThinker)
-			{
-				SaveMobjThinker(save, th, tc_mobj);
-				continue;
-			}
-	#ifdef PARANOIA
-			else if (th->function.acp1 == (actionf_p1)P_NullPrecipThinker);
-	#endif
-			else if (th->function.acp1 == (actionf_p1)T_MoveCeiling)
-			{
-				SaveCeilingThinker(save, th, tc_ceiling);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_CrushCeiling)
-			{
-				SaveCeilingThinker(save, th, tc_crushceiling);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_MoveFloor)
-			{
-				SaveFloormoveThinker(save, th, tc_floor);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_LightningFlash)
-			{
-				SaveLightflashThinker(save, th, tc_flash);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_StrobeFlash)
-			{
-				SaveStrobeThinker(save, th, tc_strobe);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_Glow)
-			{
-				SaveGlowThinker(save, th, tc_glow);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_FireFlicker)
-			{
-				SaveFireflickerThinker(save, th, tc_fireflicker);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_MoveElevator)
-			{
-				SaveElevatorThinker(save, th, tc_elevator);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_ContinuousFalling)
-			{
-				SaveContinuousFallThinker(save, th, tc_continuousfalling);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_ThwompSector)
-			{
-				SaveThwompThinker(save, th, tc_thwomp);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_NoEnemiesSector)
-			{
-				SaveNoEnemiesThinker(save, th, tc_noenemies);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_EachTimeThinker)
-			{
-				SaveEachTimeThinker(save, th, tc_eachtime);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_RaiseSector)
-			{
-				SaveRaiseThinker(save, th, tc_raisesector);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_CameraScanner)
-			{
-				SaveElevatorThinker(save, th, tc_camerascanner);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_Scroll)
-			{
-				SaveScrollThinker(save, th, tc_scroll);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_Friction)
-			{
-				SaveFrictionThinker(save, th, tc_friction);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_Pusher)
-			{
-				SavePusherThinker(save, th, tc_pusher);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_BounceCheese)
-			{
-				SaveBounceCheeseThinker(save, th, tc_bouncecheese);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_StartCrumble)
-			{
-				SaveCrumbleThinker(save, th, tc_startcrumble);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_MarioBlock)
-			{
-				SaveMarioBlockThinker(save, th, tc_marioblock);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_MarioBlockChecker)
-			{
-				SaveMarioCheckThinker(save, th, tc_marioblockchecker);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_FloatSector)
-			{
-				SaveFloatThinker(save, th, tc_floatsector);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_LaserFlash)
-			{
-				SaveLaserThinker(save, th, tc_laserflash);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_LightFade)
-			{
-				SaveLightlevelThinker(save, th, tc_lightfade);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_ExecutorDelay)
-			{
-				SaveExecutorThinker(save, th, tc_executor);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_Disappear)
-			{
-				SaveDisappearThinker(save, th, tc_disappear);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_Fade)
-			{
-				SaveFadeThinker(save, th, tc_fade);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_FadeColormap)
-			{
-				SaveFadeColormapThinker(save, th, tc_fadecolormap);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PlaneDisplace)
-			{
-				SavePlaneDisplaceThinker(save, th, tc_planedisplace);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjRotate)
-			{
-				SavePolyrotatetThinker(save, th, tc_polyrotate);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjMove)
-			{
-				SavePolymoveThinker(save, th, tc_polymove);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjWaypoint)
-			{
-				SavePolywaypointThinker(save, th, tc_polywaypoint);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyDoorSlide)
-			{
-				SavePolyslidedoorThinker(save, th, tc_polyslidedoor);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyDoorSwing)
-			{
-				SavePolyswingdoorThinker(save, th, tc_polyswingdoor);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjFlag)
-			{
-				SavePolymoveThinker(save, th, tc_polyflag);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjDisplace)
-			{
-				SavePolydisplaceThinker(save, th, tc_polydisplace);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjRotDisplace)
-			{
-				SavePolyrotdisplaceThinker(save, th, tc_polyrotdisplace);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_PolyObjFade)
-			{
-				SavePolyfadeThinker(save, th, tc_polyfade);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_DynamicSlopeLine)
-			{
-				SaveDynamicLineSlopeThinker(save, th, tc_dynslopeline);
-				continue;
-			}
-			else if (th->function.acp1 == (actionf_p1)T_DynamicSlopeVert)
-			{
-				SaveDynamicVertexSlopeThinker(save, th, tc_dynslopevert);
-				continue;
-			}
-#ifdef PARANOIA
-			else
-				I_Assert(th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed); // wait garbage collection
-#endif
+		if (i == THINK_MOBJ)
+		{
+			P_DispatchThinkerSlices(&thlist[i], numthinkers);
+			save = tail;
+		}
+		else
+		{
+			// save off the current thinkers
+			for (th = thlist[i].next; th != &thlist[i]; th = th->next)
+				SaveThinker(save, th);
 		}
 
 		CONS_Debug(DBG_NETPLAY, "%u thinkers saved in list %d\n", numsaved, i);
@@ -4290,6 +4464,9 @@ static void P_NetUnArchiveWaypoints(savebuffer_t *save)
 					CONS_Debug(DBG_GAMELOGIC, "waypoint mobj not found for %d\n", i);
 				}
 			}
+
+			// The waypoint mobjs may not be enabled the same as they were at map load
+			K_RefreshWaypointDistances();
 		}
 	}
 
@@ -4345,6 +4522,18 @@ mobj_t *P_FindNewPosition(UINT32 oldposition)
 	thinker_t *th;
 	mobj_t *mobj;
 
+	// Loaded mobjs take the pool slot their mobjnum refers to
+	mobj = P_MobjFromNum(oldposition);
+	if (mobj && mobj->thinker.function.acp1 != (actionf_p1)P_RemoveThinkerDelayed)
+		return mobj;
+
+	// Unless it was taken, then only a search will do
+	if (!mobjpoolmisplaced)
+	{
+		CONS_Debug(DBG_GAMELOGIC, "mobj %d not found\n", oldposition);
+		return NULL;
+	}
+
 	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
 	{
 		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
@@ -4399,6 +4588,7 @@ static inline pslope_t *LoadSlope(UINT32 slopeid)
 static thinker_t* LoadMobjThinker(savebuffer_t *save, actionf_p1 thinker)
 {
 	mobj_t *mobj;
+	UINT32 mobjnum;
 	UINT32 diff;
 	UINT32 diff2;
 	UINT32 diff3;
@@ -4407,6 +4597,7 @@ static thinker_t* LoadMobjThinker(savebuffer_t *save, actionf_p1 thinker)
 	ffloor_t *floorrover = NULL, *ceilingrover = NULL;
 	size_t j;
 
+	mobjnum = READUINT32(save->p);
 	diff = READUINT32(save->p);
 	if (diff & MD_MORE)
 		diff2 = READUINT32(save->p);
@@ -4446,13 +4637,13 @@ static thinker_t* LoadMobjThinker(savebuffer_t *save, actionf_p1 thinker)
 			return NULL;
 		}
 
-		mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+		mobj = P_MobjPoolAllocNum(mobjnum);
 
 		mobj->spawnpoint = &mapthings[spawnpointnum];
 		mapthings[spawnpointnum].mobj = mobj;
 	}
 	else
-		mobj = Z_Calloc(sizeof (*mobj), PU_LEVEL, NULL);
+		mobj = P_MobjPoolAllocNum(mobjnum);
 
 	// declare this as a valid mobj as soon as possible.
 	mobj->thinker.function.acp1 = thinker;
@@ -4786,6 +4977,14 @@ static thinker_t* LoadMobjThinker(savebuffer_t *save, actionf_p1 thinker)
 	{
 		mobj->owner = (mobj_t *)(size_t)READUINT32(save->p);
 	}
+	if (diff3 & MD3_SYNCHASH)
+	{
+		mobj->synchash = READUINT32(save->p);
+	}
+	else
+	{
+		mobj->synchash = P_MobjSyncHash(mobj);
+	}
 
 	// link tid set earlier
 	P_AddThingTID(mobj);
@@ -4793,8 +4992,6 @@ static thinker_t* LoadMobjThinker(savebuffer_t *save, actionf_p1 thinker)
 	// set sprev, snext, bprev, bnext, subsector
 	P_SetThingPosition(mobj);
 
-	mobj->mobjnum = READUINT32(save->p);
-
 	if (mobj->player)
 	{
 		if (mobj->eflags & MFE_VERTICALFLIP)
@@ -6983,27 +7180,10 @@ void P_SaveNetGame(savebuffer_t *save, boolean resending)
 
 	current_savebuffer = save;
 
-	thinker_t *th;
-	mobj_t *mobj;
-	UINT32 i = 1; // don't start from 0, it'd be confused with a blank pointer otherwise
-
 	CV_SaveNetVars(&save->p);
 	P_NetArchiveMisc(save, resending);
 
-	// Assign the mobjnumber for pointer tracking
-	if (gamestate == GS_LEVEL)
-	{
-		for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
-		{
-			if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
-				continue;
-
-			mobj = (mobj_t *)th;
-			if (TypeIsNetSynced(mobj->type) == false)
-				continue;
-			mobj->mobjnum = i++;
-		}
-	}
+	// mobjnums for pointer tracking were given out by the mobj pool
 
 	K_SaveEndCamera(save);
 	WriteMobjPointer(g_endcam.panMobj);
@@ -7015,13 +7195,19 @@ void P_SaveNetGame(savebuffer_t *save, boolean resending)
 
 	if (gamestate == GS_LEVEL)
 	{
+		savebuffer_t tail = {0};
+
+		if (P_SaveBufferAlloc(&tail, NETSAVEGAMESIZE) == false)
+			I_Error("No more free memory for savegame");
+
 		P_NetArchiveWorld(save);
 		P_ArchivePolyObjects(save);
-		P_NetArchiveThinkers(save);
-		P_NetArchiveSpecials(save);
-		P_NetArchiveColormaps(save);
-		P_NetArchiveTubeWaypoints(save);
-		P_NetArchiveWaypoints(save);
+		P_NetArchiveThinkers(save, &tail);
+		P_NetArchiveSpecials(&tail);
+		P_NetArchiveColormaps(&tail);
+		P_NetArchiveTubeWaypoints(&tail);
+		P_NetArchiveWaypoints(&tail);
+		P_JoinThinkerSlices(save, &tail);
 	}
 
 	ACS_Archive(save);
@@ -7091,6 +7277,7 @@ boolean P_LoadNetGame(savebuffer_t *save, boolean reloading)
 		P_NetUnArchiveTubeWaypoints(save);
 		P_NetUnArchiveWaypoints(save);
 		P_RelinkPointers();
+		P_SyncHashRebuild(false);
 	}
 
 	ACS_UnArchive(save);
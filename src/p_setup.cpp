@@ -26,6 +26,8 @@
 #include "g_game.h"
 
 #include "p_local.h"
+#include "p_mobjpool.h"
+#include "p_synchash.h"
 #include "p_setup.h"
 #include "p_spec.h"
 #include "p_saveg.h"
@@ -8294,6 +8296,9 @@ void P_LoadLevelMusic(void)
 		music = mapheader->musname[mapmusrng];
 	}
 
+	// Alt music or a map change during the intermission can leave the wrong song prefetched
+	Music_DropPrefetch(music);
+
 	if (P_UseContinuousLevelMusic())
 	{
 		if (!stricmp(Music_Song("level_nosync"), music))
@@ -8607,7 +8612,7 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 	Patch_FreeTag(PU_PATCH_LOWPRIORITY);
 	Patch_FreeTag(PU_PATCH_ROTATED);
 	Z_FreeTags(PU_LEVEL, PU_PURGELEVEL - 1);
-	mobjcache = NULL;
+	P_ClearMobjPools();
 
 	R_InitializeLevelInterpolators();
 
@@ -8786,6 +8791,10 @@ boolean P_LoadLevel(boolean fromnetsave, boolean reloadinggamestate)
 
 	P_MapEnd(); // tm.thing is no longer needed from this point onwards
 
+	// Start the world hash from everything the map spawned.
+	// A netsave brings its own shares, see P_LoadNetGame.
+	P_SyncHashRebuild(true);
+
 	if (!udmf && !P_CanWriteTextmap())
 	{
 		// *Playing* binary maps is disabled; the support is kept in the code for binary map conversions only.
@@ -4488,6 +4488,8 @@ boolean P_ProcessSpecial(activator_t *activator, INT16 special, INT32 *args, cha
 							{
 								thing->extravalue1 = 0;
 							}
+
+							K_UpdateWaypointEnabled(thing);
 						}
 					}
 				}
@@ -0,0 +1,226 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_synchash.c
+/// \brief Incrementally maintained world hash for desync detection
+///
+/// Walking every thinker each tic to build the consistancy value is too
+/// slow, so mobjs and sectors instead keep their own share of a running
+/// total. A share is rehashed when the object changes: mobjs after they
+/// think and whenever they are linked into the world, sectors whenever
+/// their planes are checked after moving. Shares are summed, so replacing
+/// one is a subtract and an add.
+///
+/// A share can be stale: a mobj pushed by another mobj that already
+/// thought this tic keeps its old hash until its next think. Every peer
+/// runs the same code, so their totals still agree; the netsave carries
+/// stale shares so a client that joins or resyncs agrees as well.
+
+#include "doomdef.h"
+#include "doomstat.h"
+#include "g_game.h"
+#include "info.h"
+#include "m_random.h"
+#include "p_local.h"
+#include "p_saveg.h"
+#include "p_synchash.h"
+#include "r_state.h"
+
+const char *const syncsubsystemnames[NUMSYNCSUBSYSTEMS] = {
+	"players",
+	"rng",
+	"mobjs",
+	"sectors",
+};
+
+// Running totals of the mobj and sector shares
+static UINT32 synctotal[NUMSYNCSUBSYSTEMS];
+
+#define SYNCHASH_SEED 0x811C9DC5u
+
+static inline UINT32 SyncHash_Mix(UINT32 h, UINT32 v)
+{
+	return (h ^ v) * 0x01000193u;
+}
+
+UINT32 P_MobjSyncHash(const mobj_t *mobj)
+{
+	UINT32 h = SYNCHASH_SEED;
+
+	h = SyncHash_Mix(h, mobj->type);
+	h = SyncHash_Mix(h, mobj->x);
+	h = SyncHash_Mix(h, mobj->y);
+	h = SyncHash_Mix(h, mobj->z);
+	h = SyncHash_Mix(h, mobj->momx);
+	h = SyncHash_Mix(h, mobj->momy);
+	h = SyncHash_Mix(h, mobj->momz);
+	h = SyncHash_Mix(h, mobj->angle);
+	h = SyncHash_Mix(h, mobj->flags);
+	h = SyncHash_Mix(h, mobj->flags2);
+	h = SyncHash_Mix(h, mobj->eflags);
+	h = SyncHash_Mix(h, mobj->health);
+	h = SyncHash_Mix(h, mobj->state ? (UINT32)(mobj->state - states) : 0);
+	h = SyncHash_Mix(h, mobj->tics);
+
+	return h;
+}
+
+UINT32 P_SectorSyncHash(const sector_t *sector)
+{
+	UINT32 h = SYNCHASH_SEED;
+
+	h = SyncHash_Mix(h, sector->floorheight);
+	h = SyncHash_Mix(h, sector->ceilingheight);
+
+	return h;
+}
+
+// Only mobjs that are saved in netsaves count
+static boolean P_MobjHasSyncHash(const mobj_t *mobj)
+{
+	return (mobj->thinker.next != NULL && TypeIsNetSynced(mobj->type));
+}
+
+void P_SyncHashMobj(mobj_t *mobj)
+{
+	if (!P_MobjHasSyncHash(mobj))
+		return;
+
+	synctotal[SYNC_MOBJS] -= mobj->synchash;
+	mobj->synchash = P_MobjSyncHash(mobj);
+	synctotal[SYNC_MOBJS] += mobj->synchash;
+}
+
+void P_SyncHashRemoveMobj(mobj_t *mobj)
+{
+	synctotal[SYNC_MOBJS] -= mobj->synchash;
+	mobj->synchash = 0;
+}
+
+void P_SyncHashSector(sector_t *sector)
+{
+	synctotal[SYNC_SECTORS] -= sector->synchash;
+	sector->synchash = P_SectorSyncHash(sector);
+	synctotal[SYNC_SECTORS] += sector->synchash;
+}
+
+void P_SyncHashRebuild(boolean rehash)
+{
+	thinker_t *th;
+	size_t i;
+
+	synctotal[SYNC_MOBJS] = synctotal[SYNC_SECTORS] = 0;
+
+	for (th = thlist[THINK_MOBJ].next; th != &thlist[THINK_MOBJ]; th = th->next)
+	{
+		mobj_t *mobj = (mobj_t *)th;
+
+		if (th->function.acp1 == (actionf_p1)P_RemoveThinkerDelayed)
+			continue;
+
+		if (!P_MobjHasSyncHash(mobj))
+		{
+			mobj->synchash = 0;
+			continue;
+		}
+
+		if (rehash)
+			mobj->synchash = P_MobjSyncHash(mobj);
+
+		synctotal[SYNC_MOBJS] += mobj->synchash;
+	}
+
+	for (i = 0; i < numsectors; i++)
+	{
+		if (rehash)
+			sectors[i].synchash = P_SectorSyncHash(&sectors[i]);
+
+		synctotal[SYNC_SECTORS] += sectors[i].synchash;
+	}
+}
+
+static UINT32 P_PlayersSyncHash(void)
+{
+	UINT32 h = SYNCHASH_SEED;
+	INT32 i;
+
+	for (i = 0; i < MAXPLAYERS; i++)
+	{
+		const player_t *player = &players[i];
+
+		if (!playeringame[i])
+		{
+			h = SyncHash_Mix(h, 0xCCCC);
+			continue;
+		}
+
+		h = SyncHash_Mix(h, player->itemtype);
+		h = SyncHash_Mix(h, player->itemamount);
+		h = SyncHash_Mix(h, player->rings);
+		h = SyncHash_Mix(h, player->laps);
+		h = SyncHash_Mix(h, player->cheatchecknum);
+
+		if (player->mo && !P_MobjWasRemoved(player->mo))
+		{
+			h = SyncHash_Mix(h, player->mo->x);
+			h = SyncHash_Mix(h, player->mo->y);
+			h = SyncHash_Mix(h, player->mo->z);
+			h = SyncHash_Mix(h, player->mo->momx);
+			h = SyncHash_Mix(h, player->mo->momy);
+			h = SyncHash_Mix(h, player->mo->momz);
+			h = SyncHash_Mix(h, player->mo->angle);
+		}
+	}
+
+	return h;
+}
+
+static UINT32 P_RNGSyncHash(void)
+{
+	UINT32 h = SYNCHASH_SEED;
+	INT32 i;
+
+	for (i = 0; i < PRNUMSYNCED; i++)
+		h = SyncHash_Mix(h, P_GetRandSeed(i));
+
+	return h;
+}
+
+UINT32 P_GetSyncHash(syncsubsystem_t which)
+{
+	switch (which)
+	{
+		case SYNC_PLAYERS:
+			return P_PlayersSyncHash();
+		case SYNC_RNG:
+			return P_RNGSyncHash();
+		default:
+			return synctotal[which];
+	}
+}
+
+UINT32 P_SyncHashConsistancy(void)
+{
+	UINT32 ret = 0;
+	INT32 i;
+
+	// Outside of levels there is no world to hash
+	if (gamestate != GS_LEVEL)
+		return 0;
+
+	for (i = 0; i < NUMSYNCSUBSYSTEMS; i++)
+	{
+		UINT32 h = P_GetSyncHash(i);
+
+		h ^= h >> 16;
+		h ^= h >> 8;
+		ret |= (h & 0xFF) << (i * 8);
+	}
+
+	return ret;
+}
@@ -0,0 +1,59 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  p_synchash.h
+/// \brief Incrementally maintained world hash for desync detection
+
+#ifndef __P_SYNCHASH__
+#define __P_SYNCHASH__
+
+#include "doomtype.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Each subsystem gets one byte of the consistancy value, so
+// the server can tell which one diverged.
+typedef enum
+{
+	SYNC_PLAYERS,
+	SYNC_RNG,
+	SYNC_MOBJS,
+	SYNC_SECTORS,
+	NUMSYNCSUBSYSTEMS
+} syncsubsystem_t;
+
+extern const char *const syncsubsystemnames[NUMSYNCSUBSYSTEMS];
+
+// Hash of the fields of a mobj / sector that the world hash covers
+UINT32 P_MobjSyncHash(const mobj_t *mobj);
+UINT32 P_SectorSyncHash(const sector_t *sector);
+
+// Replace the share of a mobj / sector with its current hash
+void P_SyncHashMobj(mobj_t *mobj);
+void P_SyncHashSector(sector_t *sector);
+
+// Take a removed mobj's share out of the world hash
+void P_SyncHashRemoveMobj(mobj_t *mobj);
+
+// Recomputes the totals from scratch. With rehash false, the shares
+// stored in each mobj and sector are trusted (used after a netsave,
+// which carries the shares that differ from a fresh hash).
+void P_SyncHashRebuild(boolean rehash);
+
+UINT32 P_GetSyncHash(syncsubsystem_t which);
+
+// Packs one byte per subsystem
+UINT32 P_SyncHashConsistancy(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
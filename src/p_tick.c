@@ -17,6 +17,8 @@
 #include "g_game.h"
 #include "g_input.h"
 #include "p_local.h"
+#include "p_mobjpool.h"
+#include "p_synchash.h"
 #include "z_zone.h"
 #include "s_sound.h"
 #include "st_stuff.h"
@@ -450,9 +452,12 @@ void P_UnlinkThinker(thinker_t *thinker)
 	(next->prev = thinker->prev)->next = next;
 	if (thinker->cachable)
 	{
-		// put cachable thinkers in the mobj cache, so we can avoid allocations
-		((mobj_t *)thinker)->hnext = mobjcache;
-		mobjcache = (mobj_t *)thinker;
+		// mobjs go back to their pool, so we can avoid allocations
+		P_MobjPoolFree((mobj_t *)thinker);
+	}
+	else if (thinker->function.acp1 == (actionf_p1)P_NullPrecipThinker)
+	{
+		P_PrecipPoolFree((precipmobj_t *)thinker);
 	}
 	else
 	{
@@ -567,6 +572,9 @@ static void P_RunThinkers(void)
 			I_Assert(currentthinker->function.acp1 != NULL);
 #endif
 			currentthinker->function.acp1(currentthinker);
+
+			if (i == THINK_MOBJ && currentthinker->function.acp1 == (actionf_p1)P_MobjThinker)
+				P_SyncHashMobj((mobj_t *)currentthinker);
 		}
 		ps_thlist_times[i] = I_GetPreciseTime() - ps_thlist_times[i];
 	}
@@ -921,6 +929,7 @@ void P_Ticker(boolean run)
 
 		ps_lua_mobjhooks = 0;
 		ps_checkposition_calls = 0;
+		ps_mobj_allocs = 0;
 
 		LUA_HOOK(PreThinkFrame);
 
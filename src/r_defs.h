@@ -574,6 +574,9 @@ struct sector_t
 
 	// UDMF user-defined custom properties.
 	mapUserProperties_t user;
+
+	// Share of the world hash, see p_synchash.c
+	UINT32 synchash;
 };
 
 //
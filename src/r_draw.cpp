@@ -17,6 +17,7 @@
 ///        The frame buffer is a linear one, and we need only the base address.
 
 #include <algorithm>
+#include <vector>
 
 #include "doomdef.h"
 #include "doomstat.h"
@@ -25,12 +26,15 @@
 #include "i_video.h"
 #include "v_video.h"
 #include "m_misc.h"
+#include "m_argv.h"
 #include "w_wad.h"
 #include "z_zone.h"
 #include "console.h" // Until buffering gets finished
 #include "k_color.h" // SRB2kart
 #include "i_threads.h"
 #include "libdivide.h" // used by NPO2 tilted span functions
+#include "core/memory.h"
+#include "core/thread_pool.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -656,9 +660,156 @@ void R_DrawViewBorder(void)
 }
 #endif
 
+// ==========================================================================
+//                        DEFERRED COLUMN DRAWING
+// ==========================================================================
+
+// Columns are queued per screen strip and each strip is drawn by one task
+// at a time. Strips never share pixels, and within a strip the batches are
+// chained with continuations, so masked columns still composite in the
+// order they were queued.
+
+namespace
+{
+
+constexpr INT32 kColumnStripShift = 5; // 32 columns
+constexpr INT32 kColumnStripCount = (MAXVIDWIDTH >> kColumnStripShift) + 1;
+constexpr INT32 kColumnBatchSize = 32;
+constexpr INT32 kColumnFlushThreshold = 512;
+constexpr size_t kColumnArenaReserve = 4 * 1024 * 1024;
+
+struct ColumnBatch
+{
+	ColumnBatch *next;
+	INT32 count;
+	coldrawfunc_t *funcs[kColumnBatchSize];
+	drawcolumndata_t dcs[kColumnBatchSize];
+};
+
+struct ColumnStrip
+{
+	ColumnBatch *head;
+	ColumnBatch *tail;
+	srb2::ThreadPool::TaskGroup last;
+};
+
+ColumnStrip g_column_strips[kColumnStripCount];
+srb2::ThreadPool::TaskGroup g_column_group;
+INT32 g_queued_columns = 0;
+
+void R_DrawColumnBatches(ColumnBatch *batch)
+{
+	ZoneScoped;
+
+	for (; batch; batch = batch->next)
+	{
+		for (INT32 i = 0; i < batch->count; i++)
+		{
+			(batch->funcs[i])(&batch->dcs[i]);
+		}
+	}
+}
+
+boolean R_QueueColumn(coldrawfunc_t *func, const drawcolumndata_t *dc)
+{
+	// Leave the rest of the arena to the light lists and flipped posts
+	// that the renderer copies into it outside of this queue
+	if (Z_Frame_Remaining() < kColumnArenaReserve)
+		return false;
+
+	ColumnStrip &strip = g_column_strips[std::clamp<INT32>(dc->x, 0, MAXVIDWIDTH - 1) >> kColumnStripShift];
+	ColumnBatch *batch = strip.tail;
+
+	if (batch == nullptr || batch->count >= kColumnBatchSize)
+	{
+		batch = static_cast<ColumnBatch*>(Z_Frame_Alloc(sizeof(ColumnBatch)));
+		batch->next = nullptr;
+		batch->count = 0;
+
+		if (strip.tail)
+			strip.tail->next = batch;
+		else
+			strip.head = batch;
+		strip.tail = batch;
+	}
+
+	drawcolumndata_t *queued = &batch->dcs[batch->count];
+	*queued = *dc;
+
+	// The light list is rewritten for every column, so keep a copy
+	if (dc->numlights > 0 && dc->lightlist)
+	{
+		queued->lightlist = static_cast<r_lightlist_t*>(Z_Frame_Alloc(sizeof(*dc->lightlist) * dc->numlights));
+		std::copy_n(dc->lightlist, dc->numlights, queued->lightlist);
+	}
+
+	batch->funcs[batch->count] = func;
+	batch->count++;
+
+	return true;
+}
+
+} // namespace
+
+void R_DrawColumnDeferred(coldrawfunc_t *func, const drawcolumndata_t *dc)
+{
+	if (cv_parallelsoftware.value && R_QueueColumn(func, dc))
+	{
+		if (++g_queued_columns >= kColumnFlushThreshold)
+			R_FlushDeferredColumns(false);
+		return;
+	}
+
+	// Out of frame memory or drawing serially; anything already
+	// queued has to land first to keep the draw order intact.
+	if (g_queued_columns > 0 || g_column_group.valid())
+		R_FlushDeferredColumns(true);
+
+	drawcolumndata_t dc_copy = *dc;
+	func(&dc_copy);
+}
+
+void R_FlushDeferredColumns(boolean wait)
+{
+	ZoneScoped;
+
+	srb2::ThreadPool &pool = *srb2::g_main_threadpool;
+
+	if (g_queued_columns > 0)
+	{
+		if (!g_column_group.valid())
+			g_column_group = pool.make_group();
+
+		for (ColumnStrip &strip : g_column_strips)
+		{
+			ColumnBatch *batch = strip.head;
+			if (batch == nullptr)
+				continue;
+
+			srb2::ThreadPool::TaskGroup group = pool.make_group(g_column_group);
+			pool.schedule_after(strip.last, group, [batch]() { R_DrawColumnBatches(batch); });
+			strip.last = group;
+			strip.head = strip.tail = nullptr;
+		}
+
+		g_queued_columns = 0;
+		pool.notify();
+	}
+
+	if (wait && g_column_group.valid())
+	{
+		pool.wait(g_column_group);
+		g_column_group = {};
+
+		for (ColumnStrip &strip : g_column_strips)
+			strip.last = {};
+	}
+}
+
 // ==========================================================================
 //                   INCLUDE MAIN DRAWERS CODE HERE
 // ==========================================================================
 
 #include "r_draw_column.cpp"
 #include "r_draw_span.cpp"
+#include "r_draw_simd.cpp"
@@ -199,6 +199,22 @@ void R_DrawViewBorder(void);
 // 8bpp DRAWING CODE
 // -----------------
 
+// Queues a column to be drawn by the thread pool, or draws it right away
+// when parallel software rendering is off. dc is copied.
+void R_DrawColumnDeferred(coldrawfunc_t *func, const drawcolumndata_t *dc);
+// Hands every queued column to the thread pool and optionally waits until
+// all deferred columns have been drawn.
+void R_FlushDeferredColumns(boolean wait);
+
+// Swaps the hottest span and column drawers for vectorized versions when
+// the CPU supports them. -nosimd keeps the scalar drawers.
+void R_InitSIMDDrawFuncs(void);
+
+// Runs the scalar and every vectorized drawer the CPU supports on the same
+// random spans and columns, and compares the screen byte for byte. Returns
+// how many runs differed. Used by the simddrawtest command and src/tests.
+UINT32 R_CheckSIMDDrawFuncs(UINT32 runs, UINT32 seed);
+
 void R_DrawColumn(drawcolumndata_t* dc);
 void R_DrawTranslucentColumn(drawcolumndata_t* dc);
 void R_DrawDropShadowColumn(drawcolumndata_t* dc);
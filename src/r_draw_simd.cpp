@@ -0,0 +1,574 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  r_draw_simd.cpp
+/// \brief vectorized span and column drawers
+/// \note  included as part of r_draw.cpp, after r_draw_column.cpp and
+///        r_draw_span.cpp; only the intrinsics headers are pulled in here
+
+// The 8-bit drawers spend most of their time on two things: stepping the
+// texture coordinates and looking pixels up through the texture, colormap
+// and translucency tables. The coordinate stepping vectorizes cleanly, so
+// the kernels below compute texel addresses for a whole batch of pixels at
+// once and then run the (inherently scalar) table lookups over the batch.
+// Hardware gathers are not used: they read 4 bytes per lane and would step
+// past the end of flats and column posts.
+//
+// Only the hottest combinations are covered: power-of-two flats without
+// effects (DS_BASIC, DS_TRANSMAP) and power-of-two wall and sprite columns
+// (DC_BASIC, DC_COLORMAP). Everything else keeps using the templates.
+// Output is identical to the scalar drawers.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define R_SIMD_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define R_SIMD_AVX2
+#define R_SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER)
+#define R_SIMD_AVX2
+#define R_SIMD_TARGET_AVX2
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(_M_ARM64)
+#define R_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// Pixels computed per call into a texel generator.
+#define SIMDBATCH 64
+
+struct SpanTexelState
+{
+	UINT32 x, y;
+	UINT32 xstep, ystep;
+	UINT32 xshift, yshift;
+	UINT32 mask;
+};
+
+struct ColumnTexelState
+{
+	UINT32 frac;
+	UINT32 fracstep;
+	UINT32 heightmask;
+};
+
+// Generators fill bits[0..n) and advance the state; n is a multiple of 8.
+typedef void (*spantexelfunc_t)(UINT32 *bits, size_t n, SpanTexelState *s);
+typedef void (*columntexelfunc_t)(UINT32 *bits, size_t n, ColumnTexelState *s);
+
+static inline UINT32 R_SpanTexel(const SpanTexelState *s)
+{
+	return ((s->y >> s->yshift) & s->mask) | (s->x >> s->xshift);
+}
+
+static inline UINT32 R_ColumnTexel(const ColumnTexelState *s)
+{
+	return (static_cast<INT32>(s->frac) >> FRACBITS) & s->heightmask;
+}
+
+#ifdef R_SIMD_SSE2
+static void R_SpanTexels_SSE2(UINT32 *bits, size_t n, SpanTexelState *s)
+{
+	const __m128i xshift = _mm_cvtsi32_si128(s->xshift);
+	const __m128i yshift = _mm_cvtsi32_si128(s->yshift);
+	const __m128i mask = _mm_set1_epi32(s->mask);
+	const __m128i xstep = _mm_set1_epi32(s->xstep * 4);
+	const __m128i ystep = _mm_set1_epi32(s->ystep * 4);
+	__m128i x = _mm_setr_epi32(s->x, s->x + s->xstep, s->x + s->xstep * 2, s->x + s->xstep * 3);
+	__m128i y = _mm_setr_epi32(s->y, s->y + s->ystep, s->y + s->ystep * 2, s->y + s->ystep * 3);
+	size_t i;
+
+	for (i = 0; i < n; i += 4)
+	{
+		__m128i bit = _mm_or_si128(_mm_and_si128(_mm_srl_epi32(y, yshift), mask), _mm_srl_epi32(x, xshift));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(bits + i), bit);
+
+		x = _mm_add_epi32(x, xstep);
+		y = _mm_add_epi32(y, ystep);
+	}
+
+	s->x += s->xstep * n;
+	s->y += s->ystep * n;
+}
+
+static void R_ColumnTexels_SSE2(UINT32 *bits, size_t n, ColumnTexelState *s)
+{
+	const __m128i mask = _mm_set1_epi32(s->heightmask);
+	const __m128i step = _mm_set1_epi32(s->fracstep * 4);
+	__m128i frac = _mm_setr_epi32(s->frac, s->frac + s->fracstep, s->frac + s->fracstep * 2, s->frac + s->fracstep * 3);
+	size_t i;
+
+	for (i = 0; i < n; i += 4)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(bits + i), _mm_and_si128(_mm_srai_epi32(frac, FRACBITS), mask));
+		frac = _mm_add_epi32(frac, step);
+	}
+
+	s->frac += s->fracstep * n;
+}
+#endif
+
+#ifdef R_SIMD_AVX2
+R_SIMD_TARGET_AVX2
+static void R_SpanTexels_AVX2(UINT32 *bits, size_t n, SpanTexelState *s)
+{
+	const __m128i xshift = _mm_cvtsi32_si128(s->xshift);
+	const __m128i yshift = _mm_cvtsi32_si128(s->yshift);
+	const __m256i mask = _mm256_set1_epi32(s->mask);
+	const __m256i xstep = _mm256_set1_epi32(s->xstep * 8);
+	const __m256i ystep = _mm256_set1_epi32(s->ystep * 8);
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i x = _mm256_add_epi32(_mm256_set1_epi32(s->x), _mm256_mullo_epi32(lane, _mm256_set1_epi32(s->xstep)));
+	__m256i y = _mm256_add_epi32(_mm256_set1_epi32(s->y), _mm256_mullo_epi32(lane, _mm256_set1_epi32(s->ystep)));
+	size_t i;
+
+	for (i = 0; i < n; i += 8)
+	{
+		__m256i bit = _mm256_or_si256(_mm256_and_si256(_mm256_srl_epi32(y, yshift), mask), _mm256_srl_epi32(x, xshift));
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(bits + i), bit);
+
+		x = _mm256_add_epi32(x, xstep);
+		y = _mm256_add_epi32(y, ystep);
+	}
+
+	s->x += s->xstep * n;
+	s->y += s->ystep * n;
+}
+
+R_SIMD_TARGET_AVX2
+static void R_ColumnTexels_AVX2(UINT32 *bits, size_t n, ColumnTexelState *s)
+{
+	const __m256i mask = _mm256_set1_epi32(s->heightmask);
+	const __m256i step = _mm256_set1_epi32(s->fracstep * 8);
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i frac = _mm256_add_epi32(_mm256_set1_epi32(s->frac), _mm256_mullo_epi32(lane, _mm256_set1_epi32(s->fracstep)));
+	size_t i;
+
+	for (i = 0; i < n; i += 8)
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i *>(bits + i), _mm256_and_si256(_mm256_srai_epi32(frac, FRACBITS), mask));
+		frac = _mm256_add_epi32(frac, step);
+	}
+
+	s->frac += s->fracstep * n;
+}
+
+static boolean R_CPUHasAVX2(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	int regs[4];
+
+	__cpuid(regs, 0);
+	if (regs[0] < 7)
+	{
+		return false;
+	}
+
+	// AVX needs OS support for saving the YMM registers
+	__cpuid(regs, 1);
+	if ((regs[2] & (1 << 27)) == 0 || (regs[2] & (1 << 28)) == 0)
+	{
+		return false;
+	}
+
+	if ((_xgetbv(0) & 6) != 6)
+	{
+		return false;
+	}
+
+	__cpuidex(regs, 7, 0);
+	return (regs[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+#ifdef R_SIMD_NEON
+static void R_SpanTexels_NEON(UINT32 *bits, size_t n, SpanTexelState *s)
+{
+	const int32x4_t xshift = vdupq_n_s32(-static_cast<INT32>(s->xshift));
+	const int32x4_t yshift = vdupq_n_s32(-static_cast<INT32>(s->yshift));
+	const uint32x4_t mask = vdupq_n_u32(s->mask);
+	const uint32x4_t xstep = vdupq_n_u32(s->xstep * 4);
+	const uint32x4_t ystep = vdupq_n_u32(s->ystep * 4);
+	const UINT32 xinit[4] = {s->x, s->x + s->xstep, s->x + s->xstep * 2, s->x + s->xstep * 3};
+	const UINT32 yinit[4] = {s->y, s->y + s->ystep, s->y + s->ystep * 2, s->y + s->ystep * 3};
+	uint32x4_t x = vld1q_u32(xinit);
+	uint32x4_t y = vld1q_u32(yinit);
+	size_t i;
+
+	for (i = 0; i < n; i += 4)
+	{
+		// a negative shift count is a logical right shift for unsigned lanes
+		vst1q_u32(bits + i, vorrq_u32(vandq_u32(vshlq_u32(y, yshift), mask), vshlq_u32(x, xshift)));
+
+		x = vaddq_u32(x, xstep);
+		y = vaddq_u32(y, ystep);
+	}
+
+	s->x += s->xstep * n;
+	s->y += s->ystep * n;
+}
+
+static void R_ColumnTexels_NEON(UINT32 *bits, size_t n, ColumnTexelState *s)
+{
+	const uint32x4_t mask = vdupq_n_u32(s->heightmask);
+	const int32x4_t step = vdupq_n_s32(static_cast<INT32>(s->fracstep * 4));
+	const UINT32 init[4] = {s->frac, s->frac + s->fracstep, s->frac + s->fracstep * 2, s->frac + s->fracstep * 3};
+	int32x4_t frac = vreinterpretq_s32_u32(vld1q_u32(init));
+	size_t i;
+
+	for (i = 0; i < n; i += 4)
+	{
+		vst1q_u32(bits + i, vandq_u32(vreinterpretq_u32_s32(vshrq_n_s32(frac, FRACBITS)), mask));
+		frac = vaddq_s32(frac, step);
+	}
+
+	s->frac += s->fracstep * n;
+}
+#endif
+
+/**	\brief Batched version of R_DrawSpanTemplate
+	Power-of-two flats only, no ripple.
+*/
+template<DrawSpanType Type, spantexelfunc_t Texels>
+static void R_DrawSpanSIMDTemplate(drawspandata_t* ds)
+{
+	static_assert((Type & (DS_RIPPLE|DS_SPRITE)) == 0, "SIMD span drawers do not support ripple or sprite spans");
+
+	alignas(32) UINT32 bits[SIMDBATCH];
+	SpanTexelState s;
+
+	UINT8 *dest;
+	UINT8 *dsrc;
+
+	const UINT8 *deststop = screens[0] + vid.rowbytes * vid.height;
+
+	size_t count = (ds->x2 - ds->x1 + 1);
+	size_t i, n;
+
+	s.x = static_cast<UINT32>(ds->xfrac) << ds->nflatshiftup;
+	s.y = static_cast<UINT32>(ds->yfrac) << ds->nflatshiftup;
+	s.xstep = static_cast<UINT32>(ds->xstep) << ds->nflatshiftup;
+	s.ystep = static_cast<UINT32>(ds->ystep) << ds->nflatshiftup;
+	s.xshift = ds->nflatxshift;
+	s.yshift = ds->nflatyshift;
+	s.mask = ds->nflatmask;
+
+	dest = ylookup[ds->y] + columnofs[ds->x1];
+	dsrc = dest;
+
+	if (dest+8 > deststop)
+	{
+		return;
+	}
+
+	while (count >= 8)
+	{
+		n = std::min<size_t>(count & ~static_cast<size_t>(7), SIMDBATCH);
+		Texels(bits, n, &s);
+
+		for (i = 0; i < n; i++)
+		{
+			dest[i] = R_DrawSpanPixel<Type>(ds, &dsrc[i], ds->colormap, bits[i]);
+		}
+
+		dest += n;
+		dsrc += n;
+
+		count -= n;
+	}
+
+	while (count-- && dest <= deststop)
+	{
+		*dest = R_DrawSpanPixel<Type>(ds, dsrc, ds->colormap, R_SpanTexel(&s));
+
+		dest++;
+		dsrc++;
+
+		s.x += s.xstep;
+		s.y += s.ystep;
+	}
+}
+
+/**	\brief Batched version of R_DrawColumnTemplate
+	Non-power-of-two textures are handed back to the template.
+*/
+template<DrawColumnType Type, columntexelfunc_t Texels>
+static void R_DrawColumnSIMDTemplate(drawcolumndata_t *dc)
+{
+	static_assert((Type & DC_LIGHTLIST) == 0, "SIMD column drawers do not support light lists");
+
+	alignas(32) UINT32 bits[SIMDBATCH];
+	ColumnTexelState s;
+
+	INT32 count;
+	UINT8 *dest;
+	size_t i, n;
+
+	if (dc->sourcelength & (dc->sourcelength-1))
+	{
+		R_DrawColumnTemplate<Type>(dc);
+		return;
+	}
+
+	count = dc->yh - dc->yl;
+
+	if (count < 0) // Zero length, column does not exceed a pixel.
+	{
+		return;
+	}
+
+	if ((unsigned)dc->x >= (unsigned)vid.width || dc->yl < 0 || dc->yh >= vid.height)
+	{
+		return;
+	}
+
+	dest = &topleft[dc->yl * vid.width + dc->x];
+
+	count++;
+
+	s.fracstep = dc->iscale;
+	s.frac = (dc->texturemid + FixedMul((dc->yl << FRACBITS) - centeryfrac, dc->iscale)) * (!dc->hires);
+	s.heightmask = dc->sourcelength-1;
+
+	while (count >= 8)
+	{
+		n = std::min<size_t>(count & ~7, SIMDBATCH);
+		Texels(bits, n, &s);
+
+		for (i = 0; i < n; i++)
+		{
+			*dest = R_DrawColumnPixel<Type>(dc, dest, bits[i]);
+			dest += vid.width;
+		}
+
+		count -= n;
+	}
+
+	while (count--)
+	{
+		*dest = R_DrawColumnPixel<Type>(dc, dest, R_ColumnTexel(&s));
+		dest += vid.width;
+		s.frac += s.fracstep;
+	}
+}
+
+#define DEFINE_SIMD_FUNCS(isa) \
+	static void R_DrawSpan_ ## isa(drawspandata_t* ds) \
+	{ \
+		ZoneScoped; \
+		R_DrawSpanSIMDTemplate<DS_BASIC, R_SpanTexels_ ## isa>(ds); \
+	} \
+	static void R_DrawTranslucentSpan_ ## isa(drawspandata_t* ds) \
+	{ \
+		ZoneScoped; \
+		R_DrawSpanSIMDTemplate<DS_TRANSMAP, R_SpanTexels_ ## isa>(ds); \
+	} \
+	static void R_DrawColumn_ ## isa(drawcolumndata_t* dc) \
+	{ \
+		ZoneScoped; \
+		R_DrawColumnSIMDTemplate<DC_BASIC, R_ColumnTexels_ ## isa>(dc); \
+	} \
+	static void R_DrawTranslatedColumn_ ## isa(drawcolumndata_t* dc) \
+	{ \
+		ZoneScoped; \
+		R_DrawColumnSIMDTemplate<DC_COLORMAP, R_ColumnTexels_ ## isa>(dc); \
+	}
+
+#define SET_SIMD_FUNCS(isa) \
+	spanfuncs[BASEDRAWFUNC] = R_DrawSpan_ ## isa; \
+	spanfuncs[SPANDRAWFUNC_TRANS] = R_DrawTranslucentSpan_ ## isa; \
+	colfuncs[BASEDRAWFUNC] = R_DrawColumn_ ## isa; \
+	colfuncs[COLDRAWFUNC_TRANS] = R_DrawTranslatedColumn_ ## isa; \
+	CONS_Debug(DBG_RENDER, "R_InitSIMDDrawFuncs: using " #isa " drawers\n");
+
+#ifdef R_SIMD_SSE2
+DEFINE_SIMD_FUNCS(SSE2)
+#endif
+#ifdef R_SIMD_AVX2
+DEFINE_SIMD_FUNCS(AVX2)
+#endif
+#ifdef R_SIMD_NEON
+DEFINE_SIMD_FUNCS(NEON)
+#endif
+
+struct SIMDDrawFuncs
+{
+	const char *name;
+	spandrawfunc_t *span;
+	spandrawfunc_t *translucentspan;
+	coldrawfunc_t *column;
+	coldrawfunc_t *translatedcolumn;
+};
+
+#define SIMD_FUNCS_ENTRY(isa) \
+	{#isa, R_DrawSpan_ ## isa, R_DrawTranslucentSpan_ ## isa, R_DrawColumn_ ## isa, R_DrawTranslatedColumn_ ## isa}
+
+// Draws with the scalar drawer, then with the vector one, both times
+// over the same starting screen. Returns true if the screens match.
+template<typename Data, typename Func>
+static boolean R_CompareSIMDDraw(Func *scalar, Func *simd, const Data *data, const UINT8 *initial, UINT8 *expected, size_t size)
+{
+	Data copy = *data;
+
+	memcpy(screens[0], initial, size);
+	scalar(&copy);
+	memcpy(expected, screens[0], size);
+
+	copy = *data;
+	memcpy(screens[0], initial, size);
+	simd(&copy);
+
+	return memcmp(expected, screens[0], size) == 0;
+}
+
+UINT32 R_CheckSIMDDrawFuncs(UINT32 runs, UINT32 seed)
+{
+	std::vector<SIMDDrawFuncs> isas;
+
+#ifdef R_SIMD_SSE2
+	isas.push_back(SIMD_FUNCS_ENTRY(SSE2));
+#endif
+#ifdef R_SIMD_AVX2
+	if (R_CPUHasAVX2())
+	{
+		isas.push_back(SIMD_FUNCS_ENTRY(AVX2));
+	}
+#endif
+#ifdef R_SIMD_NEON
+	isas.push_back(SIMD_FUNCS_ENTRY(NEON));
+#endif
+
+	if (isas.empty())
+	{
+		CONS_Printf("No vectorized drawers in this build.\n");
+		return 0;
+	}
+
+	const size_t size = vid.rowbytes * vid.height;
+	std::vector<UINT8> saved(screens[0], screens[0] + size);
+	std::vector<UINT8> initial(size), expected(size);
+	std::vector<UINT8> flat(2048 * 2048), source(260), colormap(256), translation(256), transmap(65536);
+	UINT32 failed = 0;
+
+	// Don't touch the synced RNG, this runs on one machine only
+	auto random = [&seed]()
+	{
+		seed = seed * 1664525 + 1013904223;
+		return seed >> 8;
+	};
+	auto fill = [&random](std::vector<UINT8> &v)
+	{
+		std::generate(v.begin(), v.end(), [&random]() { return static_cast<UINT8>(random()); });
+	};
+
+	fill(initial);
+	fill(flat);
+	fill(source);
+	fill(colormap);
+	fill(translation);
+	fill(transmap);
+
+	for (const SIMDDrawFuncs &isa : isas)
+	{
+		UINT32 mismatches = 0;
+
+		for (UINT32 i = 0; i < runs; i++)
+		{
+			drawspandata_t ds = {};
+			drawcolumndata_t dc = {};
+			const UINT32 flatbits = 3 + random() % 9; // 8x8 to 2048x2048
+			INT32 a, b;
+
+			// What R_CheckFlatLength picks for a square power-of-two flat
+			ds.flatwidth = ds.flatheight = 1 << flatbits;
+			ds.nflatshiftup = 16 - flatbits;
+			ds.nflatxshift = 32 - flatbits;
+			ds.nflatyshift = 32 - 2 * flatbits;
+			ds.nflatmask = ((1 << flatbits) - 1) << flatbits;
+			ds.powersoftwo = true;
+			ds.source = flat.data();
+			ds.colormap = colormap.data();
+			ds.transmap = transmap.data();
+			ds.xfrac = random() << 8;
+			ds.yfrac = random() << 8;
+			ds.xstep = static_cast<INT32>(random() % (8 * FRACUNIT)) - 4 * FRACUNIT;
+			ds.ystep = static_cast<INT32>(random() % (8 * FRACUNIT)) - 4 * FRACUNIT;
+			ds.y = random() % viewheight;
+			a = random() % viewwidth;
+			b = random() % viewwidth;
+			ds.x1 = std::min(a, b);
+			ds.x2 = std::max(a, b);
+
+			// Mostly power-of-two posts, which are the vectorized ones.
+			// Like a real post, there is a byte to spare before the data.
+			dc.source = source.data() + 1;
+			dc.sourcelength = (random() & 7) ? 2 << (random() % 7) : 1 + random() % 255;
+			dc.texheight = dc.sourcelength;
+			dc.colormap = colormap.data();
+			dc.translation = translation.data();
+			dc.iscale = FRACUNIT / 8 + random() % (4 * FRACUNIT);
+			dc.texturemid = static_cast<fixed_t>(random() << 8);
+			dc.x = random() % viewwidth;
+			a = random() % viewheight;
+			b = random() % viewheight;
+			dc.yl = std::min(a, b);
+			dc.yh = std::max(a, b);
+
+			if (!R_CompareSIMDDraw(R_DrawSpan, isa.span, &ds, initial.data(), expected.data(), size)
+				|| !R_CompareSIMDDraw(R_DrawTranslucentSpan, isa.translucentspan, &ds, initial.data(), expected.data(), size)
+				|| !R_CompareSIMDDraw(R_DrawColumn, isa.column, &dc, initial.data(), expected.data(), size)
+				|| !R_CompareSIMDDraw(R_DrawTranslatedColumn, isa.translatedcolumn, &dc, initial.data(), expected.data(), size))
+			{
+				mismatches++;
+			}
+		}
+
+		CONS_Printf("%s: %u of %u runs differ from the scalar drawers\n", isa.name, mismatches, runs);
+		failed += mismatches;
+	}
+
+	std::copy(saved.begin(), saved.end(), screens[0]);
+
+	return failed;
+}
+
+#undef SIMD_FUNCS_ENTRY
+
+void R_InitSIMDDrawFuncs(void)
+{
+	if (M_CheckParm("-nosimd"))
+	{
+		return;
+	}
+
+#ifdef R_SIMD_AVX2
+	if (R_CPUHasAVX2())
+	{
+		SET_SIMD_FUNCS(AVX2)
+		return;
+	}
+#endif
+
+#if defined(R_SIMD_SSE2)
+	SET_SIMD_FUNCS(SSE2)
+#elif defined(R_SIMD_NEON)
+	SET_SIMD_FUNCS(NEON)
+#endif
+}
+
+#undef DEFINE_SIMD_FUNCS
+#undef SET_SIMD_FUNCS
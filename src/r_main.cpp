@@ -1622,6 +1622,7 @@ void R_RenderPlayerView(void)
 	tp_sema = srb2::g_main_threadpool->end_sema();
 	srb2::g_main_threadpool->notify_sema(tp_sema);
 	srb2::g_main_threadpool->wait_sema(tp_sema);
+	R_FlushDeferredColumns(true);
 	ps_sw_planetime = I_GetPreciseTime() - ps_sw_planetime;
 
 	// draw mid texture and sprite
@@ -166,7 +166,7 @@ static void R_Render2sidedMultiPatchColumn(drawcolumndata_t* dc, column_t *colum
 			}
 		}
 
-		colfunccopy(const_cast<drawcolumndata_t*>(&dc_copy));
+		R_DrawColumnDeferred(colfunccopy, &dc_copy);
 	}
 }
 
@@ -1389,7 +1389,7 @@ static void R_DrawWallColumn(drawcolumndata_t* dc, INT32 yl, INT32 yh, fixed_t m
 		dc_copy.colormap += COLORMAP_REMAPOFFSET;
 		dc_copy.fullbright += COLORMAP_REMAPOFFSET;
 	}
-	colfunccopy(const_cast<drawcolumndata_t*>(&dc_copy));
+	R_DrawColumnDeferred(colfunccopy, &dc_copy);
 }
 
 static void R_RenderSegLoop (drawcolumndata_t* dc)
@@ -40,6 +40,7 @@
 #include "d_netfil.h" // blargh. for nameonly().
 #include "m_cheat.h" // objectplace
 #include "p_local.h" // stplyr
+#include "core/memory.h"
 #include "core/thread_pool.h"
 #ifdef HWRENDER
 #include "hardware/hw_md2.h"
@@ -703,9 +704,7 @@ void R_DrawMaskedColumn(drawcolumndata_t* dc, column_t *column, column_t *bright
 			// quick fix... something more proper should be done!!!
 			if (ylookup[dc->yl])
 			{
-				drawcolumndata_t dc_copy = *dc;
-				coldrawfunc_t* colfunccopy = colfunc;
-				colfunccopy(const_cast<drawcolumndata_t*>(&dc_copy));
+				R_DrawColumnDeferred(colfunc, dc);
 			}
 #ifdef PARANOIA
 			else
@@ -774,14 +773,15 @@ void R_DrawFlippedMaskedColumn(drawcolumndata_t* dc, column_t *column, column_t
 
 		if (dc->yl <= dc->yh && dc->yh > 0 && column->length != 0)
 		{
-			dc->source = static_cast<UINT8*>(ZZ_Alloc(column->length));
+			// Frame memory, since the column may be drawn later by the thread pool
+			dc->source = static_cast<UINT8*>(Z_Frame_Alloc(column->length));
 			dc->sourcelength = column->length;
 			for (s = (UINT8 *)column+2+column->length, d = dc->source; d < dc->source+column->length; --s)
 				*d++ = *s;
 
 			if (brightmap != NULL)
 			{
-				dc->brightmap = static_cast<UINT8*>(ZZ_Alloc(brightmap->length));
+				dc->brightmap = static_cast<UINT8*>(Z_Frame_Alloc(brightmap->length));
 				for (s = (UINT8 *)brightmap+2+brightmap->length, d = dc->brightmap; d < dc->brightmap+brightmap->length; --s)
 					*d++ = *s;
 			}
@@ -791,15 +791,12 @@ void R_DrawFlippedMaskedColumn(drawcolumndata_t* dc, column_t *column, column_t
 			// Still drawn by R_DrawColumn.
 			if (ylookup[dc->yl])
 			{
-				drawcolumndata_t dc_copy = *dc;
-				coldrawfunc_t* colfunccopy = colfunc;
-				colfunccopy(const_cast<drawcolumndata_t*>(&dc_copy));
+				R_DrawColumnDeferred(colfunc, dc);
 			}
 #ifdef PARANOIA
 			else
 				I_Error("R_DrawMaskedColumn: Invalid ylookup for dc_yl %d", dc->yl);
 #endif
-			Z_Free(dc->source);
 		}
 		column = (column_t *)((UINT8 *)column + column->length + 4);
 		if (brightmap != NULL)
@@ -3419,6 +3416,12 @@ static void R_DrawSprite(vissprite_t *spr)
 
 	R_CheckDebugHighlight(SW_HI_THINGS);
 
+	if (spr->cut & (SC_BBOX|SC_SPLAT))
+	{
+		// Not column based; everything queued before must be drawn first
+		R_FlushDeferredColumns(true);
+	}
+
 	if (spr->cut & SC_BBOX)
 		R_DrawThingBoundingBox(spr);
 	else if (spr->cut & SC_SPLAT)
@@ -3909,6 +3912,8 @@ static void R_DrawMaskedList (drawnode_t* head)
 		{
 			drawspandata_t ds = {0};
 			next = r2->prev;
+			// Spans cross column strips, so the queued columns must land first
+			R_FlushDeferredColumns(true);
 			R_DrawSinglePlane(&ds, r2->plane, false);
 			R_DoneWithNode(r2);
 			r2 = next;
@@ -4000,5 +4005,7 @@ void R_DrawMasked(maskcount_t* masks, INT32 nummasks)
 		R_ClearDrawNodes(&heads[nummasks - 1]);
 	}
 
+	R_FlushDeferredColumns(true);
+
 	free(heads);
 }
@@ -441,7 +441,6 @@ static ATTRNORETURN void signal_handler(INT32 num)
 	}
 
 	D_QuitNetGame(); // Fix server freezes
-	CL_AbortDownloadResume();
 	G_DirtyGameData();
 #ifdef UNIXBACKTRACE
 	write_backtrace(num);
@@ -1678,7 +1677,6 @@ void I_Quit(void)
 #endif
 
 	D_QuitNetGame();
-	CL_AbortDownloadResume();
 	I_ShutdownMusic();
 	I_ShutdownSound();
 	// use this for 1.28 19990220 by Kin
@@ -1803,7 +1801,6 @@ void I_Error(const char *error, ...)
 #endif
 
 	D_QuitNetGame();
-	CL_AbortDownloadResume();
 
 	I_ShutdownMusic();
 	I_ShutdownGraphics();
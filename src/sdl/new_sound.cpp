@@ -9,19 +9,26 @@
 //-----------------------------------------------------------------------------
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <future>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <SDL.h>
 #include <tracy/tracy/Tracy.hpp>
 
 #include "../audio/chunk_load.hpp"
 #include "../audio/gain.hpp"
+#include "../audio/kernels.hpp"
 #include "../audio/mixer.hpp"
 #include "../audio/music_player.hpp"
 #include "../audio/resample.hpp"
 #include "../audio/sound_chunk.hpp"
 #include "../audio/sound_effect_player.hpp"
+#include "../core/spsc_ring.hpp"
 #include "../cxxutil.hpp"
 #include "../io/streams.hpp"
 
@@ -74,6 +81,124 @@ static shared_ptr<srb2::media::AVRecorder> av_recorder;
 
 static void (*music_fade_callback)();
 
+// The next song, loading in the background. See I_PrefetchSong.
+static std::string prefetched_song;
+static std::future<audio::MusicPlayer> prefetched_player;
+
+namespace
+{
+
+// Parameter changes that the game thread doesn't need an answer for are
+// queued instead of taking the SDL audio lock, and the audio thread
+// applies them before mixing. Anything that takes the lock applies the
+// queue first, so queued and locked changes stay in order.
+enum class AudioCommandType
+{
+	kSfxParams,
+	kSfxVolume,
+	kMasterVolume,
+	kMusicVolume,
+	kSongVolume,
+	kSongSpeed,
+};
+
+struct AudioCommand
+{
+	AudioCommandType type;
+	INT32 channel;
+	float a;
+	float b;
+};
+
+constexpr size_t kAudioCommandQueueSize = 256;
+
+srb2::SpScRing<AudioCommand> audio_commands {kAudioCommandQueueSize};
+
+void apply_audio_command(const AudioCommand& command)
+{
+	switch (command.type)
+	{
+	case AudioCommandType::kSfxParams:
+		if (command.channel >= 0 && static_cast<size_t>(command.channel) < sound_effect_channels.size())
+		{
+			shared_ptr<SoundEffectPlayer>& channel = sound_effect_channels[command.channel];
+			if (!channel->finished())
+				channel->update(command.a, command.b);
+		}
+		break;
+	case AudioCommandType::kSfxVolume:
+		if (gain_sound_effects)
+			gain_sound_effects->gain(command.a);
+		break;
+	case AudioCommandType::kMasterVolume:
+		if (master_gain)
+			master_gain->gain(command.a);
+		break;
+	case AudioCommandType::kMusicVolume:
+		if (gain_music_channel)
+			gain_music_channel->gain(command.a);
+		break;
+	case AudioCommandType::kSongVolume:
+		if (gain_music_player)
+			gain_music_player->gain(command.a);
+		break;
+	case AudioCommandType::kSongSpeed:
+		if (resample_music_player)
+			resample_music_player->ratio(command.a);
+		break;
+	}
+}
+
+// Audio thread, or the game thread while it holds the lock
+void apply_audio_commands()
+{
+	AudioCommand command;
+
+	while (audio_commands.try_pop(command))
+	{
+		apply_audio_command(command);
+	}
+}
+
+class SdlAudioLockHandle
+{
+public:
+	SdlAudioLockHandle()
+	{
+		SDL_LockAudio();
+		apply_audio_commands();
+	}
+	~SdlAudioLockHandle() { SDL_UnlockAudio(); }
+};
+
+// Game thread only
+void push_audio_command(const AudioCommand& command)
+{
+	if (!sound_started)
+		return;
+
+	if (!audio_commands.try_push(command))
+	{
+		// The audio thread has stalled; catch up the slow way
+		SdlAudioLockHandle _;
+		apply_audio_command(command);
+	}
+}
+
+// Game thread only. A player joins its decode thread when it is
+// destroyed, so the old one goes after the lock is released.
+void swap_music_player(audio::MusicPlayer&& player)
+{
+	audio::MusicPlayer old_player;
+
+	{
+		SdlAudioLockHandle _;
+		old_player = std::exchange(*music_player, std::move(player));
+	}
+}
+
+} // namespace
+
 void* I_GetSfx(sfxinfo_t* sfx)
 {
 	if (sfx->lumpnum == LUMPERROR)
@@ -83,6 +208,8 @@ void* I_GetSfx(sfxinfo_t* sfx)
 	std::byte* lump = static_cast<std::byte*>(W_CacheLumpNum(sfx->lumpnum, PU_SOUND));
 	auto _ = srb2::finally([lump]() { Z_Free(lump); });
 
+	// The chunk comes out converted to the mixer's rate, and stays in
+	// sfx->data until I_FreeSfx, so channels never resample it.
 	tcb::span<std::byte> data_span(lump, sfx->length);
 	std::optional<SoundChunk> chunk = srb2::audio::try_load_chunk(data_span);
 
@@ -102,6 +229,7 @@ void I_FreeSfx(sfxinfo_t* sfx)
 		auto _ = srb2::finally([chunk]() { delete chunk; });
 
 		// Stop any channels playing this chunk
+		SdlAudioLockHandle lock;
 		for (auto& player : sound_effect_channels)
 		{
 			if (player->is_playing_chunk(chunk))
@@ -117,13 +245,6 @@ void I_FreeSfx(sfxinfo_t* sfx)
 namespace
 {
 
-class SdlAudioLockHandle
-{
-public:
-	SdlAudioLockHandle() { SDL_LockAudio(); }
-	~SdlAudioLockHandle() { SDL_UnlockAudio(); }
-};
-
 #ifdef TRACY_ENABLE
 static const char* kAudio = "Audio";
 #endif
@@ -138,29 +259,21 @@ void audio_callback(void* userdata, Uint8* buffer, int len)
 
 	try
 	{
-		Sample<2>* float_buffer = reinterpret_cast<Sample<2>*>(buffer);
-		size_t float_len = len / 8;
+		tcb::span<Sample<2>> float_buffer {reinterpret_cast<Sample<2>*>(buffer), static_cast<size_t>(len) / 8};
 
-		for (size_t i = 0; i < float_len; i++)
-		{
-			float_buffer[i] = Sample<2> {0.f, 0.f};
-		}
+		audio::zero_samples(float_buffer);
+
+		apply_audio_commands();
 
 		if (!master_gain)
 			return;
 
-		master_gain->generate(tcb::span {float_buffer, float_len});
+		master_gain->generate(float_buffer);
 
-		for (size_t i = 0; i < float_len; i++)
-		{
-			float_buffer[i] = {
-				std::clamp(float_buffer[i].amplitudes[0], -1.f, 1.f),
-				std::clamp(float_buffer[i].amplitudes[1], -1.f, 1.f),
-			};
-		}
+		audio::clamp_samples(float_buffer);
 #ifdef SRB2_CONFIG_ENABLE_WEBM_MOVIES
 		if (av_recorder)
-			av_recorder->push_audio_samples(tcb::span {float_buffer, float_len});
+			av_recorder->push_audio_samples(float_buffer);
 #endif
 	}
 	catch (...)
@@ -347,48 +460,26 @@ void I_UpdateSoundParams(INT32 handle, UINT8 vol, UINT8 sep, UINT8 pitch)
 {
 	(void) pitch;
 
-	SdlAudioLockHandle _;
-
-	if (sound_effect_channels.empty())
-		return;
-
 	if (handle < 0)
 		return;
 
-	size_t index = handle;
-
-	if (index >= sound_effect_channels.size())
-		return;
-
-	shared_ptr<SoundEffectPlayer>& channel = sound_effect_channels[index];
-	if (!channel->finished())
-	{
-		float vol_float = static_cast<float>(vol) / 255.f;
-		float sep_float = static_cast<float>(sep) / 127.f - 1.f;
-		channel->update(vol_float, sep_float);
-	}
+	float vol_float = static_cast<float>(vol) / 255.f;
+	float sep_float = static_cast<float>(sep) / 127.f - 1.f;
+	push_audio_command({AudioCommandType::kSfxParams, handle, vol_float, sep_float});
 }
 
 void I_SetSfxVolume(int volume)
 {
-	SdlAudioLockHandle _;
 	float vol = static_cast<float>(volume) / 100.f;
 
-	if (gain_sound_effects)
-	{
-		gain_sound_effects->gain(std::clamp(vol * vol * vol, 0.f, 1.f));
-	}
+	push_audio_command({AudioCommandType::kSfxVolume, -1, std::clamp(vol * vol * vol, 0.f, 1.f), 0.f});
 }
 
 void I_SetMasterVolume(int volume)
 {
-	SdlAudioLockHandle _;
 	float vol = static_cast<float>(volume) / 100.f;
 
-	if (master_gain)
-	{
-		master_gain->gain(std::clamp(vol * vol * vol, 0.f, 1.f));
-	}
+	push_audio_command({AudioCommandType::kMasterVolume, -1, std::clamp(vol * vol * vol, 0.f, 1.f), 0.f});
 }
 
 /// ------------------------
@@ -400,18 +491,17 @@ void I_InitMusic(void)
 	if (!sound_started)
 		initialize_sound();
 
-	SdlAudioLockHandle _;
-
 	if (music_player != nullptr)
-		*music_player = audio::MusicPlayer();
+		swap_music_player(audio::MusicPlayer());
 }
 
 void I_ShutdownMusic(void)
 {
-	SdlAudioLockHandle _;
+	prefetched_song.clear();
+	prefetched_player = {};
 
 	if (music_player)
-		*music_player = audio::MusicPlayer();
+		swap_music_player(audio::MusicPlayer());
 }
 
 /// ------------------------
@@ -471,7 +561,7 @@ boolean I_SetSongSpeed(float speed)
 {
 	if (resample_music_player)
 	{
-		resample_music_player->ratio(speed);
+		push_audio_command({AudioCommandType::kSongSpeed, -1, speed, 0.f});
 		return true;
 	}
 
@@ -593,6 +683,22 @@ void print_ex(const std::exception& ex)
 		print_walk_ex_stack(ex);
 	}
 }
+
+void install_music_player(audio::MusicPlayer&& player)
+{
+	if (music_fade_callback && music_player->fading())
+	{
+		auto old_callback = music_fade_callback;
+		music_fade_callback = nullptr;
+		(old_callback)();
+	}
+
+	// Reset song volume to 1.0 for newly loaded songs. The swap takes the
+	// lock, which applies this along with it.
+	push_audio_command({AudioCommandType::kSongVolume, -1, 1.f, 0.f});
+
+	swap_music_player(std::move(player));
+}
 } // namespace
 
 boolean I_LoadSong(char* data, size_t len)
@@ -612,34 +718,72 @@ boolean I_LoadSong(char* data, size_t len)
 		return false;
 	}
 
-	if (music_fade_callback && music_player->fading())
-	{
-		auto old_callback = music_fade_callback;
-		music_fade_callback = nullptr;
-		(old_callback)();
-	}
+	install_music_player(std::move(new_player));
 
-	SdlAudioLockHandle _;
+	return true;
+}
+
+boolean I_PrefetchSong(const char* name, char* data, size_t len)
+{
+	if (!music_player)
+		return false;
+
+	if (prefetched_player.valid() && stricmp(prefetched_song.c_str(), name) == 0)
+		return true;
+
+	// The lump can be purged once this returns, so the loader gets its own copy
+	std::vector<std::byte> copy(reinterpret_cast<std::byte*>(data), reinterpret_cast<std::byte*>(data) + len);
+
+	prefetched_song = name;
+	prefetched_player = std::async(
+		std::launch::async,
+		[copy = std::move(copy)]() mutable { return audio::MusicPlayer {tcb::span<std::byte> {copy}}; }
+	);
 
+	return true;
+}
+
+boolean I_LoadPrefetchedSong(const char* name)
+{
+	if (!music_player || !prefetched_player.valid() || stricmp(prefetched_song.c_str(), name) != 0)
+		return false;
+
+	audio::MusicPlayer new_player;
 	try
 	{
-		*music_player = std::move(new_player);
+		new_player = prefetched_player.get();
 	}
 	catch (const std::exception& ex)
 	{
+		prefetched_song.clear();
 		print_ex(ex);
 		return false;
 	}
 
-	if (gain_music_player)
-	{
-		// Reset song volume to 1.0 for newly loaded songs.
-		gain_music_player->gain(1.0);
-	}
+	prefetched_song.clear();
+
+	if (!new_player.music_type())
+		return false;
+
+	install_music_player(std::move(new_player));
 
 	return true;
 }
 
+void I_DropPrefetchedSong(const char* keep)
+{
+	if (!prefetched_player.valid() || (keep != nullptr && stricmp(prefetched_song.c_str(), keep) == 0))
+		return;
+
+	// Letting go of the future would wait for the loader, so a song that's still loading is left for the next
+	// prefetch to replace. A loaded one only has a sleeping decode thread.
+	if (prefetched_player.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		return;
+
+	prefetched_song.clear();
+	prefetched_player = {};
+}
+
 void I_UnloadSong(void)
 {
 	if (!music_player)
@@ -652,9 +796,7 @@ void I_UnloadSong(void)
 		(old_callback)();
 	}
 
-	SdlAudioLockHandle _;
-
-	*music_player = audio::MusicPlayer();
+	swap_music_player(audio::MusicPlayer());
 }
 
 boolean I_PlaySong(boolean looping)
@@ -703,23 +845,17 @@ void I_SetMusicVolume(int volume)
 {
 	float vol = static_cast<float>(volume) / 100.f;
 
-	if (gain_music_channel)
-	{
-		// Music channel volume is interpreted as logarithmic rather than linear.
-		// We approximate by cubing the gain level so vol 50 roughly sounds half as loud.
-		gain_music_channel->gain(std::clamp(vol * vol * vol, 0.f, 1.f));
-	}
+	// Music channel volume is interpreted as logarithmic rather than linear.
+	// We approximate by cubing the gain level so vol 50 roughly sounds half as loud.
+	push_audio_command({AudioCommandType::kMusicVolume, -1, std::clamp(vol * vol * vol, 0.f, 1.f), 0.f});
 }
 
 void I_SetCurrentSongVolume(int volume)
 {
 	float vol = static_cast<float>(volume) / 100.f;
 
-	if (gain_music_player)
-	{
-		// However, different from music channel volume, musicdef volumes are explicitly linear.
-		gain_music_player->gain(std::max(vol, 0.f));
-	}
+	// However, different from music channel volume, musicdef volumes are explicitly linear.
+	push_audio_command({AudioCommandType::kSongVolume, -1, std::max(vol, 0.f), 0.f});
 }
 
 boolean I_SetSongTrack(int track)
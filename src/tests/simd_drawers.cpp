@@ -0,0 +1,123 @@
+// DR. ROBOTNIK'S RING RACERS
+//-----------------------------------------------------------------------------
+// Copyright (C) 2024 by Kart Krew.
+//
+// This program is free software distributed under the
+// terms of the GNU General Public License, version 2.
+// See the 'LICENSE' file for more details.
+//-----------------------------------------------------------------------------
+/// \file  tests/simd_drawers.cpp
+/// \brief checks the vectorized span and column drawers against the templates
+/// \note  builds the drawers on their own, without the rest of the renderer
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../doomdef.h"
+#include "../doomstat.h"
+#include "../r_local.h"
+#include "../v_video.h"
+#include "../m_argv.h"
+#include "../libdivide.h"
+
+#include <tracy/tracy/Tracy.hpp>
+
+// Same order as the bottom of r_draw.cpp
+#include "../r_draw_column.cpp"
+#include "../r_draw_span.cpp"
+#include "../r_draw_simd.cpp"
+
+// Everything the drawers read, normally owned by the rest of the renderer
+
+#define TESTWIDTH 640
+#define TESTHEIGHT 400
+
+viddef_t vid;
+UINT8 *screens[5];
+UINT8 *ylookup[MAXVIDHEIGHT*4];
+INT32 columnofs[MAXVIDWIDTH*4];
+UINT8 *topleft;
+INT32 viewwidth, viewheight;
+INT32 centerx, centery;
+fixed_t centeryfrac;
+fixed_t fovtan[MAXSPLITSCREENPLAYERS];
+UINT8 viewssnum;
+lighttable_t *colormaps;
+UINT8 *encoremap;
+coldrawfunc_t *colfuncs[COLDRAWFUNC_MAX];
+spandrawfunc_t *spanfuncs[SPANDRAWFUNC_MAX];
+
+void I_Error(const char *error, ...)
+{
+	va_list argptr;
+
+	va_start(argptr, error);
+	vfprintf(stderr, error, argptr);
+	va_end(argptr);
+	fputc('\n', stderr);
+
+	exit(EXIT_FAILURE);
+}
+
+void *M_Memcpy(void *dest, const void *src, size_t n)
+{
+	return memcpy(dest, src, n);
+}
+
+void CONS_Printf(const char *fmt, ...)
+{
+	va_list argptr;
+
+	va_start(argptr, fmt);
+	vprintf(fmt, argptr);
+	va_end(argptr);
+}
+
+void CONS_Debug(UINT32 debugflags, const char *fmt, ...)
+{
+	(void)debugflags;
+	(void)fmt;
+}
+
+INT32 M_CheckParm(const char *check)
+{
+	(void)check;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	const UINT32 runs = (argc > 1) ? strtoul(argv[1], NULL, 0) : 10000;
+	const UINT32 seed = (argc > 2) ? strtoul(argv[2], NULL, 0) : 0x5EED5EED;
+	std::vector<UINT8> screen(TESTWIDTH * TESTHEIGHT);
+	INT32 i;
+
+	vid.width = viewwidth = TESTWIDTH;
+	vid.height = viewheight = TESTHEIGHT;
+	vid.rowbytes = TESTWIDTH;
+	vid.bpp = 1;
+
+	centerx = viewwidth / 2;
+	centery = viewheight / 2;
+	centeryfrac = centery << FRACBITS;
+
+	screens[0] = topleft = screen.data();
+
+	for (i = 0; i < TESTWIDTH; i++)
+		columnofs[i] = i;
+
+	for (i = 0; i < TESTHEIGHT; i++)
+		ylookup[i] = screens[0] + i * TESTWIDTH;
+
+	if (R_CheckSIMDDrawFuncs(runs, seed) != 0)
+	{
+		printf("FAILED (seed 0x%X)\n", seed);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -174,6 +174,9 @@ TYPEDEF (timestate_t);
 // i_tcp.h
 TYPEDEF3 (union, mysockaddr_t, mysockaddr_t);
 
+// i_tcp_thread.h
+TYPEDEF (tcppacket_t);
+
 // info.h
 TYPEDEF (state_t);
 TYPEDEF (mobjinfo_t);
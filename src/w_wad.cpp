@@ -34,6 +34,14 @@
 #include <unistd.h>
 #endif
 
+#ifdef _WIN32
+#include <io.h>
+#define HAVE_FILEMAPPING
+#elif (defined (__unix__) && !defined (MSDOS)) || defined (__APPLE__) || defined (UNIXCOMMON)
+#include <sys/mman.h>
+#define HAVE_FILEMAPPING
+#endif
+
 #define ZWAD
 
 #ifdef ZWAD
@@ -72,6 +80,7 @@
 #include "g_game.h" // G_SetGameModified
 
 #include "k_terrain.h"
+#include "m_argv.h"
 
 #ifdef HWRENDER
 #include "hardware/hw_main.h"
@@ -107,12 +116,111 @@ typedef struct lumpnum_cache_s
 static lumpnum_cache_t lumpnumcache[LUMPNUMCACHESIZE];
 static UINT16 lumpnumcacheindex = 0;
 
+// Ends a lump name hash chain
+#define LUMPCHAINEND UINT16_MAX
+
+// Index of every lump name across all files, for W_CheckNumForName and
+// W_CheckNumForLongName. Each name maps to the lump a backwards search
+// through the files would find, so files added later take precedence.
+typedef struct
+{
+	UINT32 hash;
+	lumpnum_t lumpnum; // LUMPERROR for an empty slot
+} lumpindexslot_t;
+
+typedef struct
+{
+	lumpindexslot_t *slots; // open addressed, capacity is a power of 2
+	size_t count;
+	size_t capacity;
+} lumpindex_t;
+
+static lumpindex_t lumpnameindex;
+static lumpindex_t lumplongnameindex;
+
 //===========================================================================
 //                                                                    GLOBALS
 //===========================================================================
 UINT16 numwadfiles = 0; // number of active wadfiles
 wadfile_t *wadfiles[MAX_WADFILES]; // 0 to numwadfiles-1 are valid
 
+// Maps a whole file into memory, so that lumps can be read without going
+// through its FILE handle. Failing is fine, reads just fall back to stdio.
+static void W_MapFile(wadfile_t *wadfile)
+{
+	wadfile->mapping = NULL;
+	wadfile->mappingsize = 0;
+
+#ifdef HAVE_FILEMAPPING
+	if (wadfile->filesize == 0 || M_CheckParm("-nofilemapping"))
+		return;
+
+#ifdef _WIN32
+	{
+		HANDLE file = (HANDLE)_get_osfhandle(_fileno(wadfile->handle));
+		HANDLE mapping;
+		void *view;
+
+		if (file == INVALID_HANDLE_VALUE)
+			return;
+
+		mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapping == NULL)
+			return;
+
+		// The view keeps the mapping alive on its own
+		view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, wadfile->filesize);
+		CloseHandle(mapping);
+
+		if (view == NULL)
+			return;
+
+		wadfile->mapping = static_cast<const UINT8*>(view);
+	}
+#else
+	{
+		void *view = mmap(NULL, wadfile->filesize, PROT_READ, MAP_PRIVATE, fileno(wadfile->handle), 0);
+
+		if (view == MAP_FAILED)
+			return;
+
+		wadfile->mapping = static_cast<const UINT8*>(view);
+	}
+#endif
+
+	wadfile->mappingsize = wadfile->filesize;
+#endif
+}
+
+static void W_UnmapFile(wadfile_t *wadfile)
+{
+#ifdef HAVE_FILEMAPPING
+	if (wadfile->mapping == NULL)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(wadfile->mapping);
+#else
+	munmap((void *)wadfile->mapping, wadfile->mappingsize);
+#endif
+#endif
+
+	wadfile->mapping = NULL;
+	wadfile->mappingsize = 0;
+}
+
+// Returns where a lump's data on disk is in its file's mapping, or NULL
+static inline const UINT8 *W_MappedLumpData(const wadfile_t *wadfile, const lumpinfo_t *l)
+{
+	// standalone files don't fill in disksize
+	size_t extent = (l->compression == CM_NOCOMPRESSION) ? l->size : l->disksize;
+
+	if (wadfile->mapping == NULL || l->position > wadfile->mappingsize || extent > wadfile->mappingsize - l->position)
+		return NULL;
+
+	return wadfile->mapping + l->position;
+}
+
 // W_Shutdown
 // Closes all of the WAD files before quitting
 // If not done on a Mac then open wad files
@@ -136,8 +244,19 @@ void W_Shutdown(void)
 		}
 
 		Z_Free(wad->lumpinfo);
+		Z_Free(wad->namebuckets);
+		Z_Free(wad->namenext);
+		Z_Free(wad->longnamebuckets);
+		Z_Free(wad->longnamenext);
+		Z_Free(wad->longnamehashes);
+		W_UnmapFile(wad);
 		Z_Free(wad);
 	}
+
+	Z_Free(lumpnameindex.slots);
+	Z_Free(lumplongnameindex.slots);
+	memset(&lumpnameindex, 0, sizeof lumpnameindex);
+	memset(&lumplongnameindex, 0, sizeof lumplongnameindex);
 }
 
 //===========================================================================
@@ -322,6 +441,154 @@ static void W_InvalidateLumpnumCache(void)
 	memset(lumpnumcache, 0, sizeof (lumpnumcache));
 }
 
+// Hash of a whole long lump name, case insensitive
+static inline UINT32 W_LongNameHash(const char *name)
+{
+	return quickncasehash(name, SIZE_MAX);
+}
+
+// Builds the lump name hash chains of a file. Lumps are linked in from
+// last to first, so every chain ends up ordered by lump number.
+static void W_BuildFileLumpIndex(wadfile_t *wadfile)
+{
+	size_t numbuckets = 1;
+	UINT16 i;
+
+	while (numbuckets < wadfile->numlumps)
+		numbuckets <<= 1;
+
+	wadfile->lumpbucketmask = (UINT16)(numbuckets - 1);
+	wadfile->namebuckets = static_cast<UINT16*>(Z_Malloc(numbuckets * sizeof (UINT16), PU_STATIC, NULL));
+	wadfile->longnamebuckets = static_cast<UINT16*>(Z_Malloc(numbuckets * sizeof (UINT16), PU_STATIC, NULL));
+	wadfile->namenext = static_cast<UINT16*>(Z_Malloc(wadfile->numlumps * sizeof (UINT16), PU_STATIC, NULL));
+	wadfile->longnamenext = static_cast<UINT16*>(Z_Malloc(wadfile->numlumps * sizeof (UINT16), PU_STATIC, NULL));
+	wadfile->longnamehashes = static_cast<UINT32*>(Z_Malloc(wadfile->numlumps * sizeof (UINT32), PU_STATIC, NULL));
+
+	memset(wadfile->namebuckets, 0xFF, numbuckets * sizeof (UINT16));
+	memset(wadfile->longnamebuckets, 0xFF, numbuckets * sizeof (UINT16));
+
+	for (i = wadfile->numlumps; i-- > 0;)
+	{
+		const lumpinfo_t *lump_p = &wadfile->lumpinfo[i];
+		UINT16 bucket;
+
+		bucket = lump_p->hash & wadfile->lumpbucketmask;
+		wadfile->namenext[i] = wadfile->namebuckets[bucket];
+		wadfile->namebuckets[bucket] = i;
+
+		wadfile->longnamehashes[i] = W_LongNameHash(lump_p->longname);
+		bucket = wadfile->longnamehashes[i] & wadfile->lumpbucketmask;
+		wadfile->longnamenext[i] = wadfile->longnamebuckets[bucket];
+		wadfile->longnamebuckets[bucket] = i;
+	}
+}
+
+static inline const lumpinfo_t *W_LumpInfoForNum(lumpnum_t lumpnum)
+{
+	return &wadfiles[WADFILENUM(lumpnum)]->lumpinfo[LUMPNUM(lumpnum)];
+}
+
+// Whether two lumps are found by the same names
+static boolean W_LumpNamesMatch(const lumpinfo_t *a, const lumpinfo_t *b, boolean longname)
+{
+	if (longname)
+		return !strcasecmp(a->longname, b->longname);
+
+	return a->hash == b->hash && !strncasecmp(a->name, b->name, 8);
+}
+
+static void W_GrowLumpIndex(lumpindex_t *index)
+{
+	lumpindexslot_t *oldslots = index->slots;
+	size_t oldcapacity = index->capacity;
+	size_t mask, i, j;
+
+	index->capacity = oldcapacity ? oldcapacity * 2 : 4096;
+	index->slots = static_cast<lumpindexslot_t*>(Z_Malloc(index->capacity * sizeof (*index->slots), PU_STATIC, NULL));
+	mask = index->capacity - 1;
+
+	for (i = 0; i < index->capacity; i++)
+		index->slots[i].lumpnum = LUMPERROR;
+
+	for (i = 0; i < oldcapacity; i++)
+	{
+		if (oldslots[i].lumpnum == LUMPERROR)
+			continue;
+
+		for (j = oldslots[i].hash & mask; index->slots[j].lumpnum != LUMPERROR; j = (j + 1) & mask)
+			;
+
+		index->slots[j] = oldslots[i];
+	}
+
+	Z_Free(oldslots);
+}
+
+// Points the name of a lump at that lump, replacing whatever lump had it before
+static void W_SetLumpIndexName(lumpindex_t *index, UINT32 hash, lumpnum_t lumpnum, boolean longname)
+{
+	const lumpinfo_t *lump_p = W_LumpInfoForNum(lumpnum);
+	size_t mask, i;
+
+	// keep the load factor under 3/4
+	if ((index->count + 1) * 4 > index->capacity * 3)
+		W_GrowLumpIndex(index);
+
+	mask = index->capacity - 1;
+
+	for (i = hash & mask; index->slots[i].lumpnum != LUMPERROR; i = (i + 1) & mask)
+	{
+		if (index->slots[i].hash == hash && W_LumpNamesMatch(W_LumpInfoForNum(index->slots[i].lumpnum), lump_p, longname))
+		{
+			index->slots[i].lumpnum = lumpnum;
+			return;
+		}
+	}
+
+	index->slots[i].hash = hash;
+	index->slots[i].lumpnum = lumpnum;
+	index->count++;
+}
+
+// Adds the lumps of the newest file to the global lump indexes
+static void W_AddFileToLumpIndex(UINT16 wadnum)
+{
+	const wadfile_t *wadfile = wadfiles[wadnum];
+	UINT16 i;
+
+	// Go backwards, so the first lump of a name in this file is the one that sticks
+	for (i = wadfile->numlumps; i-- > 0;)
+	{
+		W_SetLumpIndexName(&lumpnameindex, wadfile->lumpinfo[i].hash, (wadnum << 16) + i, false);
+		W_SetLumpIndexName(&lumplongnameindex, wadfile->longnamehashes[i], (wadnum << 16) + i, true);
+	}
+}
+
+static lumpnum_t W_FindInLumpIndex(const lumpindex_t *index, const char *name, UINT32 hash, boolean longname)
+{
+	size_t mask, i;
+
+	if (!index->count)
+		return LUMPERROR;
+
+	mask = index->capacity - 1;
+
+	for (i = hash & mask; index->slots[i].lumpnum != LUMPERROR; i = (i + 1) & mask)
+	{
+		const lumpinfo_t *lump_p;
+
+		if (index->slots[i].hash != hash)
+			continue;
+
+		lump_p = W_LumpInfoForNum(index->slots[i].lumpnum);
+
+		if (longname ? !strcasecmp(lump_p->longname, name) : !strncasecmp(lump_p->name, name, 8))
+			return index->slots[i].lumpnum;
+	}
+
+	return LUMPERROR;
+}
+
 /** Detect a file type.
  * \todo Actually detect the wad/pkzip headers and whatnot, instead of just checking the extensions.
  */
@@ -902,10 +1169,13 @@ UINT16 W_InitFile(const char *filename, boolean mainfile, boolean startup)
 	fseek(handle, 0, SEEK_END);
 	wadfile->filesize = (unsigned)ftell(handle);
 	wadfile->type = type;
+	W_MapFile(wadfile);
 
 	// already generated, just copy it over
 	M_Memcpy(&wadfile->md5sum, &md5sum, 16);
 
+	W_BuildFileLumpIndex(wadfile);
+
 	//
 	// set up caching
 	//
@@ -918,6 +1188,7 @@ UINT16 W_InitFile(const char *filename, boolean mainfile, boolean startup)
 	CONS_Printf(M_GetText("Added file %s (%u lumps)\n"), filename, numlumps);
 	wadfiles[numwadfiles] = wadfile;
 	numwadfiles++; // must come BEFORE W_LoadDehackedLumps, so any addfile called by COM_BufInsertText called by Lua doesn't overwrite what we just loaded
+	W_AddFileToLumpIndex(numwadfiles - 1);
 
 #ifdef HWRENDER
 	// Read shaders from file
@@ -1141,9 +1412,12 @@ UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 	//
 	if (startlump < wadfiles[wad]->numlumps)
 	{
-		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-		for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
+		const wadfile_t *wadfile = wadfiles[wad];
+		for (i = wadfile->namebuckets[hash & wadfile->lumpbucketmask]; i != LUMPCHAINEND; i = wadfile->namenext[i])
 		{
+			lumpinfo_t *lump_p = wadfile->lumpinfo + i;
+			if (i < startlump)
+				continue;
 			if (lump_p->hash != hash)
 				continue;
 			if (strncasecmp(lump_p->name, name, 8))
@@ -1165,7 +1439,7 @@ UINT16 W_CheckNumForNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 UINT16 W_CheckNumForLongNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 {
 	UINT16 i;
-	UINT32 hash = quickncasehash(name, 8); // Not a mistake, legacy system for short lumpnames
+	UINT32 hash = W_LongNameHash(name);
 
 	if (!TestValidLump(wad,0))
 		return INT16_MAX;
@@ -1177,12 +1451,14 @@ UINT16 W_CheckNumForLongNamePwad(const char *name, UINT16 wad, UINT16 startlump)
 	//
 	if (startlump < wadfiles[wad]->numlumps)
 	{
-		lumpinfo_t *lump_p = wadfiles[wad]->lumpinfo + startlump;
-		for (i = startlump; i < wadfiles[wad]->numlumps; i++, lump_p++)
+		const wadfile_t *wadfile = wadfiles[wad];
+		for (i = wadfile->longnamebuckets[hash & wadfile->lumpbucketmask]; i != LUMPCHAINEND; i = wadfile->longnamenext[i])
 		{
-			if (lump_p->hash != hash)
+			if (i < startlump)
+				continue;
+			if (wadfile->longnamehashes[i] != hash)
 				continue;
-			if (strcasecmp(lump_p->longname, name))
+			if (strcasecmp(wadfile->lumpinfo[i].longname, name))
 				continue;
 			return i;
 		}
@@ -1260,52 +1536,13 @@ UINT16 W_CheckNumForFullNamePK3(const char *name, UINT16 wad, UINT16 startlump)
 //
 lumpnum_t W_CheckNumForName(const char *name)
 {
-	lumpnum_t check = INT16_MAX;
-	UINT32 hash = name ? quickncasehash(name, 8) : 0;
-	INT32 i;
-
 	if (name == NULL)
 		return LUMPERROR;
 
 	if (!*name) // some doofus gave us an empty string?
 		return LUMPERROR;
 
-	// Check the lumpnumcache first. Loop backwards so that we check
-	// most recent entries first
-	for (i = lumpnumcacheindex + LUMPNUMCACHESIZE; i > lumpnumcacheindex; i--)
-	{
-		if (!lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumpname[8]
-			&& lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumphash == hash
-			&& strncasecmp(lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumpname, name, 8) == 0)
-		{
-			lumpnumcacheindex = i & (LUMPNUMCACHESIZE - 1);
-			return lumpnumcache[lumpnumcacheindex].lumpnum;
-		}
-	}
-
-	// scan wad files backwards so patch lump files take precedence
-	for (i = numwadfiles - 1; i >= 0; i--)
-	{
-		check = W_CheckNumForNamePwad(name,(UINT16)i,0);
-		if (check != INT16_MAX)
-			break; //found it
-	}
-
-	if (check == INT16_MAX)
-	{
-		return LUMPERROR;
-	}
-	else
-	{
-		// Update the cache.
-		lumpnumcacheindex = (lumpnumcacheindex + 1) & (LUMPNUMCACHESIZE - 1);
-		memset(lumpnumcache[lumpnumcacheindex].lumpname, '\0', LUMPNUMCACHENAME);
-		strncpy(lumpnumcache[lumpnumcacheindex].lumpname, name, 8);
-		lumpnumcache[lumpnumcacheindex].lumpnum = (i << 16) + check;
-		lumpnumcache[lumpnumcacheindex].lumphash = hash;
-
-		return lumpnumcache[lumpnumcacheindex].lumpnum;
-	}
+	return W_FindInLumpIndex(&lumpnameindex, name, quickncasehash(name, 8), false);
 }
 
 //
@@ -1316,54 +1553,13 @@ lumpnum_t W_CheckNumForName(const char *name)
 //
 lumpnum_t W_CheckNumForLongName(const char *name)
 {
-	lumpnum_t check = INT16_MAX;
-	UINT32 hash = name ? quickncasehash(name, LUMPNUMCACHENAME) : 0;
-	INT32 i;
-
 	if (name == NULL)
 		return LUMPERROR;
 
 	if (!*name) // some doofus gave us an empty string?
 		return LUMPERROR;
 
-	// Check the lumpnumcache first. Loop backwards so that we check
-	// most recent entries first
-	for (i = lumpnumcacheindex + LUMPNUMCACHESIZE; i > lumpnumcacheindex; i--)
-	{
-		if (lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumphash == hash
-			&& strcasecmp(lumpnumcache[i & (LUMPNUMCACHESIZE - 1)].lumpname, name) == 0)
-		{
-			lumpnumcacheindex = i & (LUMPNUMCACHESIZE - 1);
-			return lumpnumcache[lumpnumcacheindex].lumpnum;
-		}
-	}
-
-	// scan wad files backwards so patch lump files take precedence
-	for (i = numwadfiles - 1; i >= 0; i--)
-	{
-		check = W_CheckNumForLongNamePwad(name,(UINT16)i,0);
-		if (check != INT16_MAX)
-			break; //found it
-	}
-
-	if (check == INT16_MAX)
-	{
-		return LUMPERROR;
-	}
-	else
-	{
-		if (strlen(name) < LUMPNUMCACHENAME)
-		{
-			// Update the cache.
-			lumpnumcacheindex = (lumpnumcacheindex + 1) & (LUMPNUMCACHESIZE - 1);
-			memset(lumpnumcache[lumpnumcacheindex].lumpname, '\0', LUMPNUMCACHENAME);
-			strlcpy(lumpnumcache[lumpnumcacheindex].lumpname, name, LUMPNUMCACHENAME);
-			lumpnumcache[lumpnumcacheindex].lumpnum = (i << 16) + check;
-			lumpnumcache[lumpnumcacheindex].lumphash = hash;
-		}
-
-		return (i << 16) + check;
-	}
+	return W_FindInLumpIndex(&lumplongnameindex, name, W_LongNameHash(name), true);
 }
 
 // Look for valid map data through all added files in descendant order.
@@ -1618,6 +1814,8 @@ void zerr(int ret)
 
 /** Reads bytes from the head of a lump.
   * Note: If the lump is compressed, the whole thing has to be read anyway.
+  * Reads from mapped files don't touch the shared file handle or, apart
+  * from ZWAD lumps, the zone, so they are safe from other threads.
   *
   * \param wad Wad number to read from.
   * \param lump Lump number to read from.
@@ -1632,6 +1830,7 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 	size_t lumpsize;
 	lumpinfo_t *l;
 	FILE *handle;
+	const UINT8 *mapped;
 
 	if (!TestValidLump(wad,lump))
 		return 0;
@@ -1649,22 +1848,29 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 	// We setup the desired file handle to read the lump data.
 	l = wadfiles[wad]->lumpinfo + lump;
 	handle = wadfiles[wad]->handle;
-	fseek(handle, (long)(l->position + offset), SEEK_SET);
+	mapped = W_MappedLumpData(wadfiles[wad], l);
+	if (mapped == NULL)
+		fseek(handle, (long)(l->position + offset), SEEK_SET);
 
 	// But let's not copy it yet. We support different compression formats on lumps, so we need to take that into account.
 	switch(wadfiles[wad]->lumpinfo[lump].compression)
 	{
 	case CM_NOCOMPRESSION:		// If it's uncompressed, we directly write the data into our destination, and return the bytes read.
-#ifdef NO_PNG_LUMPS
 		{
-			size_t bytesread = fread(dest, 1, size, handle);
+			size_t bytesread;
+			if (mapped != NULL)
+			{
+				bytesread = size;
+				M_Memcpy(dest, mapped + offset, bytesread);
+			}
+			else
+				bytesread = fread(dest, 1, size, handle);
+#ifdef NO_PNG_LUMPS
 			if (Picture_IsLumpPNG((UINT8 *)dest, bytesread))
 				Picture_ThrowPNGError(l->fullname, wadfiles[wad]->filename);
+#endif
 			return bytesread;
 		}
-#else
-		return fread(dest, 1, size, handle);
-#endif
 	case CM_LZF:		// Is it LZF compressed? Used by ZWADs.
 		{
 #ifdef ZWAD
@@ -1672,12 +1878,18 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 			char *decData; // Lump's decompressed real data.
 			size_t retval; // Helper var, lzf_decompress returns 0 when an error occurs.
 
-			rawData = static_cast<char*>(Z_Malloc(l->disksize, PU_STATIC, NULL));
+			rawData = NULL;
 			decData = static_cast<char*>(Z_Malloc(l->size, PU_STATIC, NULL));
 
-			if (fread(rawData, 1, l->disksize, handle) < l->disksize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
-			retval = lzf_decompress(rawData, l->disksize, decData, l->size);
+			if (mapped == NULL)
+			{
+				// The seek above skipped ahead to offset, but the whole lump is needed
+				fseek(handle, (long)l->position, SEEK_SET);
+				rawData = static_cast<char*>(Z_Malloc(l->disksize, PU_STATIC, NULL));
+				if (fread(rawData, 1, l->disksize, handle) < l->disksize)
+					I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+			}
+			retval = lzf_decompress(mapped != NULL ? (const void *)mapped : rawData, l->disksize, decData, l->size);
 #ifndef AVOID_ERRNO
 			if (retval == 0) // If this was returned, check if errno was set
 			{
@@ -1721,11 +1933,16 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 			unsigned long rawSize = l->disksize;
 			unsigned long decSize = size;
 
-			rawData = static_cast<UINT8*>(Z_Malloc(rawSize, PU_STATIC, NULL));
+			rawData = NULL;
 			decData = static_cast<UINT8*>(dest);
 
-			if (fread(rawData, 1, rawSize, handle) < rawSize)
-				I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+			if (mapped == NULL)
+			{
+				fseek(handle, (long)l->position, SEEK_SET);
+				rawData = static_cast<UINT8*>(Z_Malloc(rawSize, PU_STATIC, NULL));
+				if (fread(rawData, 1, rawSize, handle) < rawSize)
+					I_Error("wad %d, lump %d: cannot read compressed data", wad, lump);
+			}
 
 			strm.zalloc = Z_NULL;
 			strm.zfree = Z_NULL;
@@ -1734,7 +1951,7 @@ size_t W_ReadLumpHeaderPwad(UINT16 wad, UINT16 lump, void *dest, size_t size, si
 			strm.total_in = strm.avail_in = rawSize;
 			strm.total_out = strm.avail_out = decSize;
 
-			strm.next_in = rawData;
+			strm.next_in = mapped != NULL ? const_cast<UINT8*>(mapped) : rawData;
 			strm.next_out = decData;
 
 			zErr = inflateInit2(&strm, -15);
@@ -1791,6 +2008,31 @@ void W_ReadLumpPwad(UINT16 wad, UINT16 lump, void *dest)
 	W_ReadLumpHeaderPwad(wad, lump, dest, 0, 0);
 }
 
+const void *W_MapLumpPwad(UINT16 wad, UINT16 lump)
+{
+	const lumpinfo_t *l;
+	const UINT8 *mapped;
+
+	if (!TestValidLump(wad, lump))
+		return NULL;
+
+	l = wadfiles[wad]->lumpinfo + lump;
+	if (l->compression != CM_NOCOMPRESSION || l->size == 0)
+		return NULL;
+
+	mapped = W_MappedLumpData(wadfiles[wad], l);
+#ifdef NO_PNG_LUMPS
+	if (mapped != NULL && Picture_IsLumpPNG(mapped, l->size))
+		Picture_ThrowPNGError(l->fullname, wadfiles[wad]->filename);
+#endif
+	return mapped;
+}
+
+const void *W_MapLump(lumpnum_t lumpnum)
+{
+	return W_MapLumpPwad(WADFILENUM(lumpnum), LUMPNUM(lumpnum));
+}
+
 // ==========================================================================
 // W_CacheLumpNum
 // ==========================================================================
@@ -1971,13 +2213,23 @@ void *W_CacheSoftwarePatchNumPwad(UINT16 wad, UINT16 lump, INT32 tag)
 	if (!lumpcache[lump])
 	{
 		size_t len = W_LumpLengthPwad(wad, lump);
-		void *lumpdata = Z_Malloc(len, PU_STATIC, NULL);
+		const void *mapped = W_MapLumpPwad(wad, lump);
 
-		// read the lump in full
-		W_ReadLumpHeaderPwad(wad, lump, lumpdata, 0, 0);
+		if (mapped != NULL)
+		{
+			// patches are only read from, so no copy is needed
+			MakePatch(const_cast<void*>(mapped), len, tag, &lumpcache[lump]);
+		}
+		else
+		{
+			void *lumpdata = Z_Malloc(len, PU_STATIC, NULL);
+
+			// read the lump in full
+			W_ReadLumpHeaderPwad(wad, lump, lumpdata, 0, 0);
 
-		MakePatch(lumpdata, len, tag, &lumpcache[lump]);
-		Z_Free(lumpdata);
+			MakePatch(lumpdata, len, tag, &lumpcache[lump]);
+			Z_Free(lumpdata);
+		}
 	}
 	else
 		Z_ChangeTag(lumpcache[lump], tag);
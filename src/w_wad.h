@@ -130,6 +130,18 @@ struct wadfile_t
 	UINT8 md5sum[16];
 
 	boolean important; // also network - !W_VerifyNMUSlumps
+
+	// Lump name hash chains, ordered by lump number. The buckets hold the
+	// first lump of each chain, next links each lump to the following one.
+	UINT16 *namebuckets;
+	UINT16 *namenext;
+	UINT16 *longnamebuckets;
+	UINT16 *longnamenext;
+	UINT32 *longnamehashes; // quickncasehash of each lump's whole long name
+	UINT16 lumpbucketmask;
+
+	const UINT8 *mapping; // the whole file mapped read-only, NULL if it couldn't be mapped
+	size_t mappingsize;
 };
 
 #define WADFILENUM(lumpnum) (UINT16)((lumpnum)>>16) // wad flumpnum>>16) // wad file number in upper word
@@ -194,6 +206,13 @@ size_t W_ReadLumpHeader(lumpnum_t lump, void *dest, size_t size, size_t offest);
 void W_ReadLumpPwad(UINT16 wad, UINT16 lump, void *dest);
 void W_ReadLump(lumpnum_t lump, void *dest);
 
+// Returns a read-only view of an uncompressed lump's data in the mapped file,
+// or NULL if the lump is compressed or the file isn't mapped. No copy is made.
+// Views stay valid until W_Shutdown and, unlike the lump cache, can be used
+// from any thread.
+const void *W_MapLumpPwad(UINT16 wad, UINT16 lump);
+const void *W_MapLump(lumpnum_t lumpnum);
+
 void *W_CacheLumpNumPwad(UINT16 wad, UINT16 lump, INT32 tag);
 void *W_CacheLumpNum(lumpnum_t lump, INT32 tag);
 void *W_CacheLumpNumForce(lumpnum_t lumpnum, INT32 tag);
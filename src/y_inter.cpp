@@ -2260,6 +2260,16 @@ void Y_StartIntermission(void)
 	if (prevmap >= nummapheaders || !mapheaderinfo[prevmap])
 		I_Error("Y_StartIntermission: Internal map ID %d not found (nummapheaders = %d)", prevmap, nummapheaders);
 
+	// If the round queue already knows the next map, start loading
+	// its music while the results are up (see G_GetNextMap)
+	if (roundqueue.position < roundqueue.size)
+	{
+		const roundentry_t *entry = &roundqueue.entries[roundqueue.position];
+
+		if (entry->rankrestricted == false)
+			Music_PrefetchMap(entry->mapnum, entry->encore);
+	}
+
 	switch (intertype)
 	{
 		case int_score:
@@ -25,6 +25,13 @@
 ///        caught with this direct-malloc version. We also suspected that SRB2's
 ///        allocator was fragmenting badly. Finally, this version is a bit
 ///        simpler (about half the lines of code).
+///
+///        Small blocks with a level or cache tag are the exception: they are
+///        carved out of per-tag arenas instead, in a few size classes. Most of
+///        them have no user, so they aren't kept in the tag's block list at
+///        all, and freeing the tag releases its arena chunks in one go rather
+///        than walking tens of thousands of blocks. Valgrind builds keep
+///        using malloc for everything.
 
 #include <stddef.h>
 #include <stdalign.h>
@@ -66,21 +73,306 @@ typedef struct memblock_s
 	const char *ownerfile;
 	INT32 ownerline;
 
+	struct memchunk_s *chunk; // arena chunk holding the block, NULL if malloc'd
+
+	// NULL for arena blocks without a user that still have the arena's tag,
+	// which are only found by walking the arena
 	struct memblock_s *next, *prev;
 } memblock_t;
 
-#define ALIGNPAD (((sizeof (memblock_t) + (alignof (max_align_t) - 1)) & ~(alignof (max_align_t) - 1)) - sizeof (memblock_t))
+#define ALIGNUP(x) (((x) + (alignof (max_align_t) - 1)) & ~(alignof (max_align_t) - 1))
+#define ALIGNPAD (ALIGNUP(sizeof (memblock_t)) - sizeof (memblock_t))
 #define MEMORY(x) (void *)((uintptr_t)(x) + sizeof(memblock_t) + ALIGNPAD)
 #define MEMBLOCK(x) (memblock_t *)((uintptr_t)(x) - ALIGNPAD - sizeof(memblock_t))
 
-// both the head and tail of the zone memory block list
-static memblock_t head;
+// Block lists are kept per tag, so freeing a tag doesn't walk every block
+#define NUMTAGLISTS 128
+#define TAGLIST(tag) ((tag) < 0 ? 0 : (tag) >= NUMTAGLISTS ? NUMTAGLISTS - 1 : (tag))
+
+// both the head and tail of each tag's memory block list
+static memblock_t heads[NUMTAGLISTS];
+
+// -----------
+// Tag arenas
+// -----------
+
+#define ARENACHUNKSIZE (128 << 10)
+
+// Slot sizes, including the block header
+static const size_t sizeclasses[] = {96, 128, 192, 256, 384, 512, 768, 1024};
+#define NUMSIZECLASSES (sizeof sizeclasses / sizeof *sizeclasses)
+
+typedef struct memchunk_s
+{
+	struct memchunk_s *next;
+	struct memarena_s *arena; // NULL once the arena was freed under the chunk
+	INT32 tag;
+	size_t used; // bytes carved out so far
+	size_t escaped; // blocks that have since been given another tag
+} memchunk_t;
+
+#define CHUNKDATA(c) ((UINT8 *)(c) + ALIGNUP(sizeof (memchunk_t)))
+
+typedef struct memarena_s
+{
+	INT32 tag;
+	memchunk_t *chunks; // the first one is being carved
+	memblock_t *freeblocks[NUMSIZECLASSES];
+} memarena_t;
+
+#ifdef HAVE_VALGRIND
+#define NUMARENAS 0
+#else
+#define NUMARENAS 3
+#endif
+
+static memarena_t arenas[3] = {
+	{PU_CACHE, NULL, {NULL}},
+	{PU_LEVEL, NULL, {NULL}},
+	{PU_LEVSPEC, NULL, {NULL}},
+};
 
 //
 // Function prototypes
 //
 static void Command_Memfree_f(void);
 static void Command_Memdump_f(void);
+static void *xm(size_t size);
+
+static memarena_t *Z_TagArena(INT32 tag)
+{
+	INT32 i;
+
+	for (i = 0; i < NUMARENAS; i++)
+		if (arenas[i].tag == tag)
+			return &arenas[i];
+
+	return NULL;
+}
+
+// Index of the smallest size class that fits, or -1
+static INT32 Z_SizeClass(size_t size)
+{
+	INT32 i;
+
+	for (i = 0; i < (INT32)NUMSIZECLASSES; i++)
+		if (size <= sizeclasses[i])
+			return i;
+
+	return -1;
+}
+
+// A freed slot keeps its realsize, so this works for free slots as well
+static size_t Z_SlotSize(const memblock_t *block)
+{
+	return sizeclasses[Z_SizeClass(sizeof (memblock_t) + ALIGNPAD + block->realsize)];
+}
+
+// Steps through the slots of a chunk, live or free
+static memblock_t *Z_ChunkSlot(memchunk_t *chunk, size_t *offset)
+{
+	memblock_t *block;
+
+	if (*offset >= chunk->used)
+		return NULL;
+
+	block = (memblock_t *)(CHUNKDATA(chunk) + *offset);
+	*offset += Z_SlotSize(block);
+	return block;
+}
+
+// Live arena blocks that aren't in any block list
+#define ANONYMOUS(block) ((block)->id == ZONEID && (block)->next == NULL)
+
+// Blocks that outlive their arena's tag keep their chunk alive
+static boolean Z_BlockEscaped(const memblock_t *block)
+{
+	return (block->chunk->arena == NULL || block->tag != block->chunk->tag);
+}
+
+// Arena blocks are only listed if something other than the arena has to find them
+static boolean Z_BlockNeedsLink(const memblock_t *block)
+{
+	return (block->chunk == NULL || block->user != NULL || Z_BlockEscaped(block));
+}
+
+static void Z_LinkBlock(memblock_t *block)
+{
+	memblock_t *head = &heads[TAGLIST(block->tag)];
+
+	block->next = head->next;
+	block->prev = head;
+	head->next = block;
+	block->next->prev = block;
+}
+
+static void Z_UnlinkBlock(memblock_t *block)
+{
+	block->prev->next = block->next;
+	block->next->prev = block->prev;
+	block->next = block->prev = NULL;
+}
+
+/** Takes a block for the given size (header included) out of an arena.
+  *
+  * \return The block, or NULL if it's too big for the size classes.
+  */
+static memblock_t *Z_ArenaAlloc(memarena_t *arena, size_t size)
+{
+	INT32 sc = Z_SizeClass(size);
+	memchunk_t *chunk;
+	memblock_t *block;
+
+	if (sc < 0)
+		return NULL;
+
+	block = arena->freeblocks[sc];
+	if (block != NULL)
+	{
+		arena->freeblocks[sc] = block->next;
+		return block;
+	}
+
+	chunk = arena->chunks;
+	if (chunk == NULL || chunk->used + sizeclasses[sc] > ARENACHUNKSIZE - ALIGNUP(sizeof (memchunk_t)))
+	{
+		chunk = xm(ARENACHUNKSIZE);
+		TracyCAlloc(chunk, ARENACHUNKSIZE);
+		chunk->next = arena->chunks;
+		chunk->arena = arena;
+		chunk->tag = arena->tag;
+		chunk->used = 0;
+		chunk->escaped = 0;
+		arena->chunks = chunk;
+	}
+
+	block = (memblock_t *)(CHUNKDATA(chunk) + chunk->used);
+	chunk->used += sizeclasses[sc];
+	block->chunk = chunk;
+	return block;
+}
+
+/** Returns an arena block's slot to its size class.
+  */
+static void Z_ArenaFree(memblock_t *block)
+{
+	memchunk_t *chunk = block->chunk;
+	memarena_t *arena = chunk->arena;
+	INT32 sc;
+
+	if (Z_BlockEscaped(block))
+	{
+		chunk->escaped--;
+
+		if (arena == NULL)
+		{
+			// The rest of the chunk went with its arena
+			if (chunk->escaped == 0)
+			{
+				TracyCFree(chunk);
+				free(chunk);
+			}
+			return;
+		}
+	}
+
+	block->id = 0;
+	sc = Z_SizeClass(sizeof (memblock_t) + ALIGNPAD + block->realsize);
+	block->next = arena->freeblocks[sc];
+	arena->freeblocks[sc] = block;
+}
+
+typedef struct
+{
+	memchunk_t **chunks; // sorted by address
+	size_t numchunks;
+} chunkset_t;
+
+static int Z_CompareChunks(const void *a, const void *b)
+{
+	uintptr_t x = (uintptr_t)*(memchunk_t *const *)a;
+	uintptr_t y = (uintptr_t)*(memchunk_t *const *)b;
+
+	return (x > y) - (x < y);
+}
+
+// Is data inside a chunk of the set, and not in a block that escaped it?
+static boolean Z_InChunkSet(void *data, void *arg)
+{
+	const chunkset_t *set = arg;
+	uintptr_t p = (uintptr_t)data;
+	size_t lo = 0, hi = set->numchunks;
+	memchunk_t *chunk;
+	memblock_t *block;
+	size_t offset = 0;
+
+	// Find the last chunk starting at or before data
+	while (lo < hi)
+	{
+		size_t mid = (lo + hi) / 2;
+
+		if ((uintptr_t)set->chunks[mid] <= p)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	if (lo == 0 || p >= (uintptr_t)set->chunks[lo - 1] + ARENACHUNKSIZE)
+		return false;
+
+	chunk = set->chunks[lo - 1];
+	if (chunk->escaped == 0)
+		return true;
+
+	while ((block = Z_ChunkSlot(chunk, &offset)) != NULL)
+		if (p < (uintptr_t)CHUNKDATA(chunk) + offset)
+			return !(block->id == ZONEID && block->tag != chunk->tag);
+
+	return true;
+}
+
+/** Frees every block left in an arena at once.
+  * Blocks in it that have a user must have been freed already.
+  */
+static void Z_FreeArena(memarena_t *arena)
+{
+	memchunk_t *chunk, *next;
+	chunkset_t set;
+
+	set.numchunks = 0;
+	for (chunk = arena->chunks; chunk != NULL; chunk = chunk->next)
+		set.numchunks++;
+
+	if (set.numchunks == 0)
+		return;
+
+	// One pass over Lua's pointers, instead of one lookup per block
+	set.chunks = xm(set.numchunks * sizeof *set.chunks);
+	set.numchunks = 0;
+	for (chunk = arena->chunks; chunk != NULL; chunk = chunk->next)
+		set.chunks[set.numchunks++] = chunk;
+	qsort(set.chunks, set.numchunks, sizeof *set.chunks, Z_CompareChunks);
+	LUA_InvalidateUserdataIf(Z_InChunkSet, &set);
+	free(set.chunks);
+
+	for (chunk = arena->chunks; chunk != NULL; chunk = next)
+	{
+		next = chunk->next;
+
+		if (chunk->escaped)
+		{
+			// Freed along with its last escaped block
+			chunk->arena = NULL;
+			continue;
+		}
+
+		TracyCFree(chunk);
+		free(chunk);
+	}
+
+	arena->chunks = NULL;
+	memset(arena->freeblocks, 0, sizeof arena->freeblocks);
+}
 
 // --------------------------
 // Zone memory initialisation
@@ -94,10 +386,12 @@ static void Command_Memdump_f(void);
 void Z_Init(void)
 {
 	UINT32 total, memfree;
+	INT32 i;
 
-	memset(&head, 0x00, sizeof(head));
+	memset(heads, 0x00, sizeof(heads));
 
-	head.next = head.prev = &head;
+	for (i = 0; i < NUMTAGLISTS; i++)
+		heads[i].next = heads[i].prev = &heads[i];
 
 	memfree = I_GetFreeMem(&total)>>20;
 	CONS_Printf("System memory: %uMB - Free: %uMB\n", total>>20, memfree);
@@ -155,8 +449,15 @@ void Z_Free2(void *ptr, const char *file, INT32 line)
 #ifdef VALGRIND_DESTROY_MEMPOOL
 	VALGRIND_DESTROY_MEMPOOL(block);
 #endif
-	block->prev->next = block->next;
-	block->next->prev = block->prev;
+	if (block->next != NULL)
+		Z_UnlinkBlock(block);
+
+	if (block->chunk != NULL)
+	{
+		Z_ArenaFree(block);
+		return;
+	}
+
 	TracyCFree(block);
 	free(block);
 }
@@ -205,7 +506,8 @@ static void *xm(size_t size)
 void *Z_Malloc2(size_t size, INT32 tag, void *user, INT32 alignbits,
 	const char *file, INT32 line)
 {
-	memblock_t *block;
+	memblock_t *block = NULL;
+	memarena_t *arena;
 	void *ptr;
 
 	(void)(alignbits); // no longer used, so silence warnings. TODO we should figure out a solution for this
@@ -214,8 +516,17 @@ void *Z_Malloc2(size_t size, INT32 tag, void *user, INT32 alignbits,
 	CONS_Debug(DBG_MEMORY, "Z_Malloc %s:%d\n", file, line);
 #endif
 
-	block = xm(sizeof (memblock_t) + ALIGNPAD + size);
-	TracyCAlloc(block, sizeof (memblock_t) + ALIGNPAD + size);
+	arena = Z_TagArena(tag);
+	if (arena != NULL && size <= sizeclasses[NUMSIZECLASSES - 1])
+		block = Z_ArenaAlloc(arena, sizeof (memblock_t) + ALIGNPAD + size);
+
+	if (block == NULL)
+	{
+		block = xm(sizeof (memblock_t) + ALIGNPAD + size);
+		TracyCAlloc(block, sizeof (memblock_t) + ALIGNPAD + size);
+		block->chunk = NULL;
+	}
+
 	ptr = MEMORY(block);
 	I_Assert((intptr_t)ptr % alignof (max_align_t) == 0);
 
@@ -223,11 +534,6 @@ void *Z_Malloc2(size_t size, INT32 tag, void *user, INT32 alignbits,
 	Z_calloc = false;
 #endif
 
-	block->next = head.next;
-	block->prev = &head;
-	head.next = block;
-	block->next->prev = block;
-
 	block->tag = tag;
 	block->user = NULL;
 	block->ownerline = line;
@@ -250,6 +556,10 @@ void *Z_Malloc2(size_t size, INT32 tag, void *user, INT32 alignbits,
 		I_Error("Z_Malloc: attempted to allocate purgable block "
 			"(size %s) with no user", sizeu1(size));
 
+	block->next = block->prev = NULL;
+	if (Z_BlockNeedsLink(block))
+		Z_LinkBlock(block);
+
 	return ptr;
 }
 
@@ -352,15 +662,22 @@ void *Z_Realloc2(void *ptr, size_t size, INT32 tag, void *user, INT32 alignbits,
 void Z_FreeTags(INT32 lowtag, INT32 hightag)
 {
 	memblock_t *block, *next;
+	INT32 i;
 	TracyCZone(__zone, true);
 
 	Z_CheckHeap(420);
-	for (block = head.next; block != &head; block = next)
-	{
-		next = block->next; // get link before freeing
-		if (block->tag >= lowtag && block->tag <= hightag)
-			Z_Free(MEMORY(block));
-	}
+	for (i = TAGLIST(lowtag); i <= TAGLIST(hightag); i++)
+		for (block = heads[i].next; block != &heads[i]; block = next)
+		{
+			next = block->next; // get link before freeing
+			if (block->tag >= lowtag && block->tag <= hightag)
+				Z_Free(MEMORY(block));
+		}
+
+	// What's left in the arenas has no user, so it can go all at once
+	for (i = 0; i < NUMARENAS; i++)
+		if (arenas[i].tag >= lowtag && arenas[i].tag <= hightag)
+			Z_FreeArena(&arenas[i]);
 
 	TracyCZoneEnd(__zone);
 }
@@ -374,22 +691,37 @@ void Z_FreeTags(INT32 lowtag, INT32 hightag)
 void Z_IterateTags(INT32 lowtag, INT32 hightag, boolean (*iterfunc)(void *))
 {
 	memblock_t *block, *next;
+	memchunk_t *chunk;
+	size_t offset;
+	INT32 i;
 	TracyCZone(__zone, true);
 
 	if (!iterfunc)
 		I_Error("Z_IterateTags: no iterator function was given");
 
-	for (block = head.next; block != &head; block = next)
-	{
-		next = block->next; // get link before possibly freeing
-
-		if (block->tag >= lowtag && block->tag <= hightag)
+	for (i = TAGLIST(lowtag); i <= TAGLIST(hightag); i++)
+		for (block = heads[i].next; block != &heads[i]; block = next)
 		{
-			void *mem = MEMORY(block);
-			boolean free = iterfunc(mem);
-			if (free)
-				Z_Free(mem);
+			next = block->next; // get link before possibly freeing
+
+			if (block->tag >= lowtag && block->tag <= hightag)
+			{
+				void *mem = MEMORY(block);
+				boolean free = iterfunc(mem);
+				if (free)
+					Z_Free(mem);
+			}
 		}
+
+	for (i = 0; i < NUMARENAS; i++)
+	{
+		if (arenas[i].tag < lowtag || arenas[i].tag > hightag)
+			continue;
+
+		for (chunk = arenas[i].chunks; chunk != NULL; chunk = chunk->next)
+			for (offset = 0; (block = Z_ChunkSlot(chunk, &offset)) != NULL;)
+				if (ANONYMOUS(block) && iterfunc(MEMORY(block)))
+					Z_Free(MEMORY(block));
 	}
 
 	TracyCZoneEnd(__zone);
@@ -432,10 +764,14 @@ void Z_CheckMemCleanup(void)
 void Z_CheckHeap(INT32 i)
 {
 	memblock_t *block;
+	memchunk_t *chunk;
 	UINT32 blocknumon = 0;
 	void *given;
+	size_t offset;
+	INT32 list;
 
-	for (block = head.next; block != &head; block = block->next)
+	for (list = 0; list < NUMTAGLISTS; list++)
+	for (block = heads[list].next; block != &heads[list]; block = block->next)
 	{
 		blocknumon++;
 		given = MEMORY(block);
@@ -490,6 +826,30 @@ void Z_CheckHeap(INT32 i)
 			);
 		}
 	}
+
+	for (list = 0; list < NUMARENAS; list++)
+		for (chunk = arenas[list].chunks; chunk != NULL; chunk = chunk->next)
+			for (offset = 0; (block = Z_ChunkSlot(chunk, &offset)) != NULL;)
+			{
+				blocknumon++;
+				if (block->id == 0)
+					continue;
+				if (block->id != ZONEID || block->chunk != chunk)
+				{
+					I_Error("Z_CheckHeap %d: block %u"
+						" in the arena for tag %d is corrupt", i, blocknumon,
+						chunk->tag
+					);
+				}
+				if (block->next == NULL && (block->user != NULL || block->tag != chunk->tag))
+				{
+					I_Error("Z_CheckHeap %d: block %u"
+						"(owned by %s:%d)"
+						" should be in a block list", i, blocknumon,
+						block->ownerfile, block->ownerline
+					);
+				}
+			}
 }
 
 // ------------------------
@@ -524,7 +884,22 @@ void Z_ChangeTag(void *ptr, INT32 tag)
 		I_Error("Internal memory management error: "
 			"tried to make block purgable but it has no owner");
 
+	// An arena block can't move, so one that changes tag keeps its chunk alive
+	if (block->chunk != NULL && block->chunk->arena != NULL)
+	{
+		if (block->tag == block->chunk->tag && tag != block->chunk->tag)
+			block->chunk->escaped++;
+		else if (block->tag != block->chunk->tag && tag == block->chunk->tag)
+			block->chunk->escaped--;
+	}
+
+	if (block->next != NULL)
+		Z_UnlinkBlock(block);
+
 	block->tag = tag;
+
+	if (Z_BlockNeedsLink(block))
+		Z_LinkBlock(block);
 }
 
 /** Changes a memory block's user.
@@ -557,6 +932,9 @@ void Z_SetUser(void *ptr, void **newuser)
 
 	block->user = (void*)newuser;
 	*newuser = ptr;
+
+	if (block->next == NULL)
+		Z_LinkBlock(block);
 }
 
 // -----------------
@@ -574,12 +952,27 @@ size_t Z_TagsUsage(INT32 lowtag, INT32 hightag)
 {
 	size_t cnt = 0;
 	memblock_t *rover;
+	memchunk_t *chunk;
+	size_t offset;
+	INT32 i;
 
-	for (rover = head.next; rover != &head; rover = rover->next)
+	for (i = TAGLIST(lowtag); i <= TAGLIST(hightag); i++)
+		for (rover = heads[i].next; rover != &heads[i]; rover = rover->next)
+		{
+			if (rover->tag < lowtag || rover->tag > hightag)
+				continue;
+			cnt += rover->size + sizeof *rover;
+		}
+
+	for (i = 0; i < NUMARENAS; i++)
 	{
-		if (rover->tag < lowtag || rover->tag > hightag)
+		if (arenas[i].tag < lowtag || arenas[i].tag > hightag)
 			continue;
-		cnt += rover->size + sizeof *rover;
+
+		for (chunk = arenas[i].chunks; chunk != NULL; chunk = chunk->next)
+			for (offset = 0; (rover = Z_ChunkSlot(chunk, &offset)) != NULL;)
+				if (ANONYMOUS(rover))
+					cnt += rover->size + sizeof *rover;
 	}
 
 	return cnt;
@@ -631,6 +1024,12 @@ static void Command_Memfree_f(void)
 	CONS_Printf(M_GetText("Available physical memory: %7u KB\n"), freebytes>>10);
 }
 
+static void Memdump_Block(const memblock_t *block)
+{
+	const char *filename = strrchr(block->ownerfile, PATHSEP[0]);
+	CONS_Printf("[%3d] %s (%s) bytes @ %s:%d\n", block->tag, sizeu1(block->size), sizeu2(block->realsize), filename ? filename + 1 : block->ownerfile, block->ownerline);
+}
+
 /** The function called by the "memdump" console command.
   * Prints zone memory debugging information (i.e. tag, size, location in code allocated).
   * Can be all memory allocated in game, or between a set of tags (if -min/-max args used).
@@ -638,6 +1037,8 @@ static void Command_Memfree_f(void)
 static void Command_Memdump_f(void)
 {
 	memblock_t *block;
+	memchunk_t *chunk;
+	size_t offset;
 	INT32 mintag = 0, maxtag = INT32_MAX;
 	INT32 i;
 
@@ -647,12 +1048,21 @@ static void Command_Memdump_f(void)
 	if ((i = COM_CheckParm("-max")))
 		maxtag = atoi(COM_Argv(i + 1));
 
-	for (block = head.next; block != &head; block = block->next)
-		if (block->tag >= mintag && block->tag <= maxtag)
-		{
-			char *filename = strrchr(block->ownerfile, PATHSEP[0]);
-			CONS_Printf("[%3d] %s (%s) bytes @ %s:%d\n", block->tag, sizeu1(block->size), sizeu2(block->realsize), filename ? filename + 1 : block->ownerfile, block->ownerline);
-		}
+	for (i = TAGLIST(mintag); i <= TAGLIST(maxtag); i++)
+		for (block = heads[i].next; block != &heads[i]; block = block->next)
+			if (block->tag >= mintag && block->tag <= maxtag)
+				Memdump_Block(block);
+
+	for (i = 0; i < NUMARENAS; i++)
+	{
+		if (arenas[i].tag < mintag || arenas[i].tag > maxtag)
+			continue;
+
+		for (chunk = arenas[i].chunks; chunk != NULL; chunk = chunk->next)
+			for (offset = 0; (block = Z_ChunkSlot(chunk, &offset)) != NULL;)
+				if (ANONYMOUS(block))
+					Memdump_Block(block);
+	}
 }
 
 /** Creates a copy of a string.